@@ -1,498 +1,546 @@
-#include <stdio.h>
-#include <math.h>
-#include <stdlib.h>
-#include "nrutil.h"
-#include "mc_main.h"
-#include "mc_v.h"
-#include "pert.h"
-
-#define MU_LB 0.01
- 
-/* global variables */
-extern struct Photon *photptr;
-extern struct Tissue *tissptr;
-extern struct Output *outptr;
-extern struct perturb *pertptr;
-extern struct History *histptr;
-struct bvolume *bananaptr;
-extern struct SourceDefinition *source;
-extern struct DetectorDefinition *detector;
-
-/***********************************************************/
-void init_banana_allvox()
-{
-  int ix,iy,iz,iw,num_sides=6;
-  bananaptr=(struct bvolume *)malloc(sizeof(struct bvolume));
-  /* use cylindrical data for cartesian data */
-  bananaptr->nx=2*detector->nr+1;  /* center source */
-  bananaptr->ny=1;  
-  bananaptr->nz=detector->nz; 
-  printf("banana:nx,ny,nz=%d,%d,%d\n",
-    bananaptr->nx,bananaptr->ny,bananaptr->nz);
-  //outptr->out_side_allvox=dvector(0,num_sides-1);
-  //outptr->in_side_allvox=dvector(0,num_sides-1);
-  for (iw=0;iw<num_sides;++iw) {
-    outptr->out_side_allvox[iw]=d3tensor(0,bananaptr->nx-1,0,bananaptr->ny-1,0,bananaptr->nz-1);
-    outptr->in_side_allvox[iw]=d3tensor(0,bananaptr->nx-1,0,bananaptr->ny-1,0,bananaptr->nz-1);
-  }
-  for (ix=0;ix<bananaptr->nx;++ix)
-    for (iy=0;iy<bananaptr->ny;++iy)
-       for (iz=0;iz<bananaptr->nz;++iz)
-         for (iw=0;iw<num_sides;++iw)
-         {
-	   outptr->out_side_allvox[iw][ix][iy][iz]=0.0; // CKH 09jan31 agree with c# and linux
-	   outptr->in_side_allvox[iw][ix][iy][iz]=0.0;
-	  }
-   bananaptr->banana_photons=0;
-   outptr->wt_pathlen_out_top=0.0;
-   outptr->wt_pathlen_out_bot=0.0;
-   outptr->wt_pathlen_out_sides=0.0;
-   outptr->R_rt[0][0]=0.0;
-}
-
-/**************************************************************/
-void Compute_Prob_allvox()
-{
-  int debug=0,i,j,k,m,iw,ktrk,jfix,num,N,in_layer,curr_layer,dead=0;
-  int ix,iy,iz;
-  int nx,ny,nz,side,next_same_vox,exit;
-  double this_x,this_y,this_z,next_x,next_y,next_z;
-  double w=1.0,dx,dy,dz,xmid,ymid,zmid,xmid2,ymid2,zmid2;
-  double s[6],mins,dist_in_vox,tracklen;
-  double phot_disc_wt;
-  double mu;
-  int bdry_col=0;
-  struct vox_list *this_vox=NULL,*head;
-  double MIN_X,MAX_X,MIN_Y,MAX_Y,MIN_Z,MAX_Z;
-  MIN_X=-detector->nr*detector->dr-detector->dr/2;	  
-  MAX_X= detector->nr*detector->dr+detector->dr/2;	  
-  MIN_Y=-detector->nr*detector->dr-detector->dr/2;	  
-  MAX_Y= detector->nr*detector->dr+detector->dr/2;	  
-  MIN_Z=0.0;	  
-  MAX_Z= detector->nz*detector->dz;	  
-  dx=detector->dr;
-  dy=detector->nr*detector->dr+detector->dr;
-  dz=detector->dz;
-  nx=bananaptr->nx;
-  ny=bananaptr->ny;
-  nz=bananaptr->nz;
-  N=source->num_photons;
-  num=histptr->num_pts_stored;
-  ++bananaptr->banana_photons;
-  phot_disc_wt=1.0;  
-  in_layer=0;
-  exit=0;  /* this needs to be 0 so that for/adj work simultaneously */
-  for(ktrk=0;ktrk<num-1;++ktrk)  {  /* for all tracks */
-    if (!dead) {
-      this_x=histptr->xh[ktrk];
-      this_y=histptr->yh[ktrk];
-      this_z=histptr->zh[ktrk];
-      next_x=histptr->xh[ktrk+1];
-      next_y=histptr->yh[ktrk+1];
-      next_z=histptr->zh[ktrk+1];
-      tracklen=sqrt((next_x-this_x)*(next_x-this_x)+
-                    (next_y-this_y)*(next_y-this_y)+
-                    (next_z-this_z)*(next_z-this_z));
-      xmid=this_x;
-      ymid=this_y;
-      zmid=this_z;
-      next_same_vox=0;
-      /* DEBUG */
-      /* if ((bananaptr->banana_photons>=1041)&&(ktrk>=270)) debug=1; 
-      else debug=0;     */
-      if (debug) { 
-        printf("N %3d TRACK %5d: this=(%15.10f,%15.10f,%15.10f)\n",
-        bananaptr->banana_photons,ktrk,this_x,this_y,this_z);
-        printf("                 : next=(%15.10f,%15.10f,%15.10f)\n",
-        next_x,next_y,next_z);
-	printf("phot_dist_wt=%f\n",phot_disc_wt);
-      } 
-      /* flag if out sides */
-      if ((fabs(next_x)>MAX_X)||(fabs(next_y)>MAX_Y)) {
-	in_layer=0;
-	if (debug) printf("outside of layer \n");
-      }  /* if out sides */
-      else { /* not out sides */
-        histptr->boundary_col[ktrk]=0;
-	for (i=1;i<=tissptr->num_layers;i++) {
-	/* following based on "this" s.t. check later for weights agrees */
-	  if (fabs(this_z-tissptr->layerprops[i].zbegin)<1e-9) {
-	    histptr->boundary_col[ktrk]=1;
-	    if (debug) printf("boundary collision!\n");
-	  }
-        }
-        if (!in_layer) { /* check if enter layer */
-	  if ((MIN_Z==0.0)&&(ktrk==0)) { /* layer at origin */
-	    /* NOTE: this may not handle if passes thru 1st voxel */
-	    in_layer=1;
-	    ix=floor((this_x-MIN_X)/dx);
-	    iy=floor((this_y-MIN_Y)/dy);
-	    iz=0;
-	    side=0;
-            /* adjoint */
-	    outptr->in_side_allvox[ix][iy][iz][side]+=phot_disc_wt; 
-	  } 
-	  else { /* layer not at origin */  
-            s[0]=0;
-            if ((this_z<=MIN_Z)&&(next_z>MIN_Z))  
-	       s[0]=(MIN_Z-this_z)/(next_z-this_z);
-            else if ((this_z>MAX_Z)&&(next_z<MAX_Z))  
-	       s[0]=(MAX_Z-this_z)/(next_z-this_z);
-	    /* determine point of intersection */
-	    if ((s[0]>0)&&(s[0]<=1)) {  /* crossed into layer */
-	      xmid=this_x+s[0]*(next_x-this_x);
-	      ymid=this_y+s[0]*(next_y-this_y);
-	      zmid=this_z+s[0]*(next_z-this_z);
-	      /* NOTE: ix,iy,iz always min of voxel */
-	      ix=floor((xmid-MIN_X)/dx);
-	      iy=floor((ymid-MIN_Y)/dy);
-	      if (next_z>this_z) { /* enter from top */
-	        iz=0;
-		side=0;
-                /* adjoint */
-		if (in_layer)
-	          outptr->in_side_allvox[ix][iy][iz][side]+=phot_disc_wt; 
-              }
-	      else  { /* enter from bottom */
-	        iz=nz-1;
-		side=5;
-                /* adjoint */
-		if (in_layer)
-	          outptr->in_side_allvox[ix][iy][iz][side]+=phot_disc_wt; 
-              }
-	      in_layer=1;
-	    }  /* crossed into layer */
-	  } /* layer not at origin */
-          if ((debug)&&(in_layer)) {
-	    printf("enter layer at (x,y,z)=(%f,%f,%f)\n",xmid,ymid,zmid);
-	    printf("enter layer at (ix,iy,iz)=(%d,%d,%d)\n",ix,iy,iz); }
-          } /* check if enter layer */
-        else { /* check if exit layer */
-	  /* NOTE: this may not handle if passes thru edge voxel */
-          s[0]=0;
-          if ((this_z>MIN_Z)&&(next_z<=MIN_Z))  
-	    s[0]=(MIN_Z-this_z)/(next_z-this_z);
-          else if ((this_z<MAX_Z)&&(next_z>MAX_Z))  
-	    s[0]=(MAX_Z-this_z)/(next_z-this_z);
-	  /* determine point of intersection */
-	  if ((s[0]>0)&&(s[0]<=1)) {  /* crossed out of layer */
-	    xmid=this_x+s[0]*(next_x-this_x);
-	    ymid=this_y+s[0]*(next_y-this_y);
-	    zmid=this_z+s[0]*(next_z-this_z);
-	    ix=floor((xmid-MIN_X)/dx);
-	    iy=floor((ymid-MIN_Y)/dy);
-	    if (next_z>this_z) { /* exit bottom */
-	      iz=nz-1;
-	      side=5;
-              mu=(next_z-this_z)/tracklen;
-	      if (in_layer) {
-                if (fabs(mu)>MU_LB)
-	          outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/mu; 
-	        else
-	          outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/(MU_LB/2); 
-              }
-	    }
-            else { /* exit top */
-	      iz=0;
-	      side=0;
-              mu=-(next_z-this_z)/tracklen;
-	      if (in_layer) {
-                if (fabs(mu)>MU_LB)
-	          outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/mu;
-                else
-	          outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/(MU_LB/2);
-              }
-            }
-	    in_layer=0;
-	    if (debug) {
-	    printf("out[side=%d,%d,%d,%d]=%e\n",side,ix,iy,iz,
-			    outptr->out_side_allvox[ix][iy][iz][side]);
-	    printf("exit layer at (x,y,z)=(%f,%f,%f)\n",xmid,ymid,zmid);
-	    printf("exit: dist_in_vox(%d,%d,%d)=%f\n",ix,iy,iz,
-	                sqrt((this_x-xmid)*(this_x-xmid)+
-	                     (this_y-ymid)*(this_y-ymid)+
-	                     (this_z-zmid)*(this_z-zmid))); 
-	    }
-	  } /* crossed out of layer */
-        } /* check if exit layer */
-        while ((!next_same_vox)&&(in_layer)&&(!dead)) {
-          /* if boundary upward boundary collision first segment, save exiting wt */
-          if ((histptr->boundary_col[ktrk]==1)&&
-			  (this_z>next_z)&&(this_z==zmid)) {
-	    if (fabs(mu)>MU_LB)
-	      outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/mu;
-	    else
-	      outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/(MU_LB/2);
-	    if (debug) 
-	    printf("out[side=%d,%d,%d,%d]=%e\n",side,ix,iy,iz,
-			    outptr->out_side_allvox[ix][iy][iz][side]);
-            --iz;
-          }
-          /* check if ended in this voxel */
-	  if (debug) printf("floor((next_x-MIN_X)/dx)=%4.1f ix=%d\n",
-	                     floor((next_x-MIN_X)/dx),ix);
-	  if (debug) printf("floor((next_y-MIN_Y)/dy)=%4.1f iy=%d\n",
-	                     floor((next_y-MIN_Y)/dy),iy);
-	  if (debug) printf("floor((next_z-MIN_Z)/dz)=%4.1f iz=%d\n",
-	                     floor((next_z-MIN_Z)/dz),iz);
-	  if ( (floor((next_x-MIN_X)/dx)==(double)ix)&&
-	       (floor((next_y-MIN_Y)/dy)==(double)iy)&&
-	       (floor((next_z-MIN_Z)/dz)==(double)iz) ) { /* floor fix */
-            next_same_vox=1; 
-	    if (debug) {
-	      printf("while:track ended in vox\n"); 
-	      printf("while:dist_in_vox(%d,%d,%d)=%f\n",ix,iy,iz,
-	                sqrt((next_x-xmid)*(next_x-xmid)+
-	                     (next_y-ymid)*(next_y-ymid)+
-	                     (next_z-zmid)*(next_z-zmid))); 
-	    }
-          } /* track ended in vox */
-          else { /* check which face track exited */
-          /* i of s[i] based on 0=top,1=front,2=left,3=back,4=right,5=bot */
-            if (debug) printf("fmod(xmid-MIN_X,dx)=%f y=%f z=%f\n",
-              fmod(xmid-MIN_X,dx),fmod(ymid-MIN_Y,dy),fmod(zmid-MIN_Z,dz));
-	    if ((fmod(xmid-MIN_X,dx)<1e-10)|| /* on y-z face */
-	      (fabs(fmod(xmid-MIN_X,dx)-dx)<1e-10)) { 
-	      if (debug) printf("on y-z face\n");
-	      if (next_x>this_x) {
-	        s[2]=99;
-                s[4]=(MIN_X+(ix+1)*dx-xmid)/(next_x-xmid);
-	      }
-              else {
-                s[2]=(MIN_X+(ix)*dx-xmid)/(next_x-xmid);
-	        s[4]=99;
-	      }
-              s[3]=(MIN_Y+iy*dy-ymid)/(next_y-ymid);
-              s[1]=(MIN_Y+(iy+1)*dy-ymid)/(next_y-ymid);
-              s[0]=(MIN_Z+iz*dz-zmid)/(next_z-zmid);
-              s[5]=(MIN_Z+(iz+1)*dz-zmid)/(next_z-zmid);
-	    }
-	    else if ((fmod(ymid-MIN_Y,dy)<1e-10)||  /* on x-z face */
-	        (fabs(fmod(ymid-MIN_Y,dy)-dy)<1e-10)) { 
-	      if (debug) printf("on x-z face\n");
-              s[2]=(MIN_X+ix*dx-xmid)/(next_x-xmid);
-              s[4]=(MIN_X+(ix+1)*dx-xmid)/(next_x-xmid);
-	      if (next_y>this_y) {
-	        s[3]=99;
-                s[1]=(MIN_Y+(iy+1)*dy-ymid)/(next_y-ymid);
-              }
-	      else {
-                s[3]=(MIN_Y+(iy)*dy-ymid)/(next_y-ymid);
-	        s[1]=99;
-              }
-              s[0]=(MIN_Z+iz*dz-zmid)/(next_z-zmid);
-              s[5]=(MIN_Z+(iz+1)*dz-zmid)/(next_z-zmid);
-	    } 
-	    else if ((fmod(zmid-MIN_Z,dz)<1e-10)||  /* on x-y face */
-	        (fabs(fmod(zmid-MIN_Z,dz)-dz)<1e-10)) { 
-	      if (debug) printf("on x-y face\n");
-                s[2]=(MIN_X+ix*dx-xmid)/(next_x-xmid);
-                s[4]=(MIN_X+(ix+1)*dx-xmid)/(next_x-xmid);
-                s[3]=(MIN_Y+iy*dy-ymid)/(next_y-ymid);
-                s[1]=(MIN_Y+(iy+1)*dy-ymid)/(next_y-ymid);
-	        if (next_z>this_z) {
-                  s[0]=99;
-                  s[5]=(MIN_Z+(iz+1)*dz-zmid)/(next_z-zmid);
-	        }
-	        else {
-                  s[0]=(MIN_Z+(iz)*dz-zmid)/(next_z-zmid);
-	          s[5]=99;
-	        }
-            }
-            else { /* this interior to voxel */
-	      if (debug) printf("interior to voxel\n"); 
-              s[2]=(MIN_X+ix*dx-xmid)/(next_x-xmid);
-              s[4]=(MIN_X+(ix+1)*dx-xmid)/(next_x-xmid);
-              s[3]=(MIN_Y+iy*dy-ymid)/(next_y-ymid);
-              s[1]=(MIN_Y+(iy+1)*dy-ymid)/(next_y-ymid);
-              s[0]=(MIN_Z+(iz)*dz-zmid)/(next_z-zmid);
-              s[5]=(MIN_Z+(iz+1)*dz-zmid)/(next_z-zmid);
-            }
-            mins=99;
-	    jfix=-1;
-            for (j=0;j<6;++j) {
-              if ((s[j]>0)&&(s[j]<=1+1e-10)) { /* hit plane */  
-	         if (fabs(s[j])>1e-10) { 
-                   if (s[j]<=mins) {
-	             mins=s[j]; 
-		     jfix=j;
-		   }
-	         }
-	      }
-            } 
-            if ((mins==99)&&(histptr->boundary_col[ktrk]==0)) {
-	      printf("WARNING: N=%d trk=%d mins==99 x,y,z=%f,%f,%f\n",
-	         bananaptr->banana_photons,ktrk,this_x,this_y,this_z);
-	      dead=1;
-	    } 
-	    side=jfix;
-	    switch (jfix) {
-	      case 0: mu=-(next_z-this_z)/tracklen; break;
-	      case 1: mu=(next_y-this_y)/tracklen; break;
-	      case 2: mu=-(next_x-this_x)/tracklen; break;
-	      case 3: mu=-(next_y-this_y)/tracklen; break;
-	      case 4: mu=(next_x-this_x)/tracklen; break;
-	      case 5: mu=(next_z-this_z)/tracklen; break;
-	    }
-	    xmid2=xmid+mins*(next_x-xmid);
-	    ymid2=ymid+mins*(next_y-ymid);
-	    zmid2=zmid+mins*(next_z-zmid);
-	    if (debug) {
-	      printf("jfix=%d s=(%7.5f,%7.5f,%7.5f,%7.5f,%7.5f,%7.5f)\n",
-	        jfix,s[0],s[1],s[2],s[3],s[4],s[5]); 
-	      printf("intra layer at (x,y,z)=(%7.5f,%7.5f,%7.5f)\n",
-	        xmid2,ymid2,zmid2); 
-	      printf("intra:dist_in_vox(%d,%d,%d)=%f\n",ix,iy,iz,
-	                sqrt((xmid2-xmid)*(xmid2-xmid)+
-	                     (ymid2-ymid)*(ymid2-ymid)+
-	                     (zmid2-zmid)*(zmid2-zmid))); 
-            }
-	    /* save weights since exiting current voxel */
-	    if ( (ix>=nx)||(ix<0)||(iy>=ny)||(iy<0)||(iz>=nz)||(iz<0) )
-	      in_layer=0;
-	    if (in_layer) {
-	      if (fabs(mu)>MU_LB)
-	        outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/mu;
-	      else
-	        outptr->out_side_allvox[ix][iy][iz][side]+=phot_disc_wt/(MU_LB/2);
-            }
-	    if (debug) printf("out[side=%d,%d,%d,%d]=%e\n",side,ix,iy,iz,
-			    outptr->out_side_allvox[ix][iy][iz][side]);
-	    /* move to the next voxel */
-	    switch (jfix) {
-	      case 0: --iz; if (!exit) side=5; break;
-	      case 1: ++iy; if (!exit) side=3; break;
-	      case 2: --ix; if (!exit) side=4; break;
-	      case 3: --iy; if (!exit) side=1; break;
-	      case 4: ++ix; if (!exit) side=2; break;
-	      case 5: ++iz; if (!exit) side=0; break;
-	    }
-	    if (debug) printf("next (ix,iy,iz)=(%d,%d,%d)\n",ix,iy,iz);
-	    if ( (ix>=nx)||(ix<0)||(iy>=ny)||(iy<0)||(iz>=nz)||(iz<0) )
-	      in_layer=0;
-	    /* adjoint: save weights since entering voxel */
-	    if (in_layer) {
-                outptr->in_side_allvox[ix][iy][iz][side]+=phot_disc_wt; 
-	    }
-            xmid=xmid2;
-            ymid=ymid2;
-            zmid=zmid2;
-	  } /* else crossed voxel face */
-        } /* while not at end of track or dead */
-      } /* not out sides */
-      /* only deweight non-boundary collisions */
-      if ((histptr->boundary_col[ktrk]==0)||(ktrk==0)) {
-        curr_layer=0;
-        for (i=1;i<=tissptr->num_layers;i++) {
-          if ( (this_z>=tissptr->layerprops[i].zbegin)&& /* must >= */
-               (this_z<=tissptr->layerprops[i].zend) )
-             curr_layer=i;
-        }
-        phot_disc_wt*=tissptr->layerprops[curr_layer].mus/
-            (tissptr->layerprops[curr_layer].mus+
-             tissptr->layerprops[curr_layer].mua);
-      } /* if not boundary collision */
-      else
-        ++bdry_col;
-    } /* if not dead */
-  } /* for all tracks */
-}
-/**************************************************************/
-void Add_To_List(struct vox_list **this_vox, 
-                int ix, int iy, int iz, int col, int sa_idx)
-{
-  struct vox_list *temp;
-  if ((temp=malloc(sizeof(*temp)))==NULL) 
-    nrerror("allocation failure in Add_To_List()");
-  temp->ix=ix;
-  temp->iy=iy;
-  temp->iz=iz;
-  temp->col=col;
-  temp->sa_idx=sa_idx;
-  temp->next=*this_vox;
-  *this_vox=temp;
-  /* printf("Add end: *this_vox=%d ix,iy,iz=%d,%d,%d\n",
-    *this_vox,ix,iy,iz);  */
-}
-/************************************************************/
-void Free_List(struct vox_list *head)
-{
-  struct vox_list *temp;
-  /* printf("Free_List: head=%d\n",head);  */
-  while (head!=NULL) {
-    temp=head->next;
-    free(head);
-    head=temp;
-  }
-}
-/************************************************************/
-void Output_Wts_allvox(void)
- {
-   FILE *ofp[6];
-   int ix,iy,iz,iw,N,num_sides=6;
-   char tmp[256];
-   /* QFIX: assume symmetry -> use forward for adjoint */
-   double src_NA=source->src_NA,det_NA=src_NA;
-   double dx,dy,dz,delmu,delphi,Rhoog_norm;
-   double Asrc,Adet,n=tissptr->layerprops[1].n;
-   /* delmu=1.0/bananaptr->num_mu;
-   delphi=2*PI/bananaptr->num_phi; */
-   delmu=1.0; /* assume 1 angular bin now */
-   delphi=2*PI;
-   dx=detector->dr;
-   dy=detector->dr;
-   dz=detector->dz;
-   N=source->num_photons;
-   /* NOTE: norm/denom(dx*dy*dz*dmu*dphi) factor of adjoint files */
-     for (iw=0;iw<num_sides;++iw) {
-       sprintf(tmp,"%s%i","wts_out_side",iw);
-       ofp[iw]=fopen(tmp,"w");
-       for(iz=0;iz<bananaptr->nz;++iz) {
-         for(ix=0;ix<bananaptr->nx;++ix) {
-           for(iy=0;iy<bananaptr->ny;++iy) {
-             fprintf(ofp[iw],"%.6e ",
-               outptr->out_side_allvox[iw][ix][iy][iz]); // CKH 09jan31 make consist with c#
-           } /* for iy */
-         } /* for ix */
-         fprintf(ofp[iw],"\n");
-       } /* for iz */
-       fclose(ofp[iw]);
-     } /* for iw */
-     if (source->beam_radius==0.0)
-       Asrc=1;
-     else
-       Asrc=PI*source->beam_radius*source->beam_radius;
-     /* Adet=PI*detector->det_rad*detector->det_rad; */
-     Adet=Asrc;
-     Rhoog_norm=Asrc*2*PI*(1-sqrt(1-(src_NA/n)*(src_NA/n)))*
-	        Adet*2*PI*(1-sqrt(1-(det_NA/n)*(det_NA/n)));
-     //printf("in_side[0][200][0][0]=%e\n",outptr->in_side_allvox[0][200][0][0]);
-     for (iw=0;iw<num_sides;++iw) {
-       sprintf(tmp,"%s%i","wts_in_side",iw);
-       ofp[iw]=fopen(tmp,"w");
-       for(iz=0;iz<bananaptr->nz;++iz) {
-         for(ix=0;ix<bananaptr->nx;++ix) {
-           for(iy=0;iy<bananaptr->ny;++iy) {
-             if ((iw==0)||(iw==5)) {
-               fprintf(ofp[iw],"%.6e ",
-                 Rhoog_norm*outptr->in_side_allvox[iw][ix][iy][iz]/
-		 (delmu*delphi*dx*dy*N*N));
-                
-             }
-             else if ((iw==1)||(iw==3)) {
-               fprintf(ofp[iw],"%.6e ",
-                 Rhoog_norm*outptr->in_side_allvox[iw][ix][iy][iz]/
-		 (delmu*delphi*dx*dz*N*N));
-	     }
-             else if ((iw==2)||(iw==4)) {
-               fprintf(ofp[iw],"%.6e ",
-                 Rhoog_norm*outptr->in_side_allvox[iw][ix][iy][iz]/
-		 (delmu*delphi*dy*dz*N*N));
-             }
-           } /* for iy */
-         } /* for ix */
-         fprintf(ofp[iw],"\n");
-       } /* for iz */
-       fclose(ofp[iw]);
-     } /* for iw */
- }
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include "nrutil.h"
+#include "mc_main.h"
+#include "mc_v.h"
+#include "pert.h"
+#include "mc_moment.h"
+#include "protos.h"
+
+#define MU_LB 0.01
+/* entry/exit points near the grid edge can floor() outside it */
+#define IN_GRID(b,ix,iy,iz) (((ix)>=0)&&((ix)<(b)->nx)&&((iy)>=0)&&((iy)<(b)->ny)&& \
+                             ((iz)>=0)&&((iz)<(b)->nz))
+
+/* a voxel side's weight, counted for its second moment too */
+static void AddVox(struct SimContext *ctx, double *v, double w)
+{
+  *v+=w;
+  MOMENT_ADD(ctx,v,w);
+}
+ 
+/***********************************************************/
+void init_banana_allvox(struct SimContext *ctx)
+{
+  ctx->bananaptr=(struct bvolume *)malloc(sizeof(struct bvolume));
+  /* use cylindrical data for cartesian data */
+  ctx->bananaptr->nx=2*ctx->detector->nr+1;  /* center source */
+  ctx->bananaptr->ny=1;  
+  ctx->bananaptr->nz=ctx->detector->nz; 
+  printf("banana:nx,ny,nz=%d,%d,%d\n",
+    ctx->bananaptr->nx,ctx->bananaptr->ny,ctx->bananaptr->nz);
+  Alloc_Tally_allvox(ctx); /* zeroed, CKH 09jan31 agree with c# and linux */
+   ctx->bananaptr->banana_photons=0;
+   ctx->outptr->wt_pathlen_out_top=0.0;
+   ctx->outptr->wt_pathlen_out_bot=0.0;
+   ctx->outptr->wt_pathlen_out_sides=0.0;
+   ctx->outptr->R_rt[0][0]=0.0;
+}
+
+/***********************************************************/
+/* one zeroed, TALLY_ALIGN aligned block holding in_side_allvox */
+/* then out_side_allvox, each num_vox*ALLVOX_STRIDE doubles,    */
+/* then, when visits are recorded, num_vox visits_allvox        */
+void Alloc_Tally_allvox(struct SimContext *ctx)
+{
+  struct bvolume *b=ctx->bananaptr;
+  int record=ctx->allvox_trk.visits.record;
+  size_t nd,bytes;
+  char *p;
+
+  if ((b->nx<=0)||(b->ny<=0)||(b->nz<=0)) {
+    printf("\nERROR - allvox grid %d x %d x %d is empty\n",b->nx,b->ny,b->nz);
+    exit(0);
+  }
+  b->num_vox=(size_t)b->nx*b->ny;
+  if (b->num_vox>((size_t)-1)/b->nz) 
+    b->num_vox=0;
+  else
+    b->num_vox*=b->nz;
+  /* all tallies plus alignment slack must fit in a size_t */
+  if ((b->num_vox==0)||
+      (b->num_vox>(((size_t)-1)-TALLY_ALIGN)/((2*ALLVOX_STRIDE+1)*sizeof(double)))) {
+    printf("\nERROR - allvox grid %d x %d x %d is too large\n",b->nx,b->ny,b->nz);
+    exit(0);
+  }
+  nd=b->num_vox*ALLVOX_STRIDE;
+  b->num_tally=2*nd+(record ? b->num_vox : 0);
+  bytes=b->num_tally*sizeof(double)+TALLY_ALIGN-1;
+  b->tally_block=calloc(1,bytes);
+  if (b->tally_block==NULL) 
+    nrerror("allocation failure in Alloc_Tally_allvox()");
+  p=(char *)b->tally_block;
+  p+=(TALLY_ALIGN-(size_t)p%TALLY_ALIGN)%TALLY_ALIGN;
+  ctx->outptr->in_side_allvox=(double *)p;
+  ctx->outptr->out_side_allvox=ctx->outptr->in_side_allvox+nd;
+  ctx->outptr->visits_allvox=NULL;
+  b->visit_stamp=NULL;
+  if (record) {
+    ctx->outptr->visits_allvox=ctx->outptr->out_side_allvox+nd;
+    b->visit_stamp=(int *)calloc(b->num_vox,sizeof(int));
+    if (b->visit_stamp==NULL) 
+      nrerror("allocation failure in Alloc_Tally_allvox()");
+  }
+}
+
+/***********************************************************/
+void Free_Tally_allvox(struct SimContext *ctx)
+{
+  free(ctx->bananaptr->tally_block);
+  free(ctx->bananaptr->visit_stamp);
+  ctx->bananaptr->tally_block=NULL;
+  ctx->bananaptr->visit_stamp=NULL;
+  ctx->outptr->in_side_allvox=NULL;
+  ctx->outptr->out_side_allvox=NULL;
+  ctx->outptr->visits_allvox=NULL;
+}
+
+/**************************************************************/
+/* Score the photon's whole track from the History arrays */
+void Compute_Prob_allvox(struct SimContext *ctx)
+{
+  int ktrk,num;
+
+  num=ctx->histptr->num_pts_stored;
+  Start_Track_allvox(ctx);
+  for(ktrk=0;ktrk<num-1;++ktrk)  /* for all tracks */
+    Score_Track_allvox(ctx,
+      ctx->histptr->xh[ktrk],ctx->histptr->yh[ktrk],ctx->histptr->zh[ktrk],
+      ctx->histptr->xh[ktrk+1],ctx->histptr->yh[ktrk+1],ctx->histptr->zh[ktrk+1]);
+}
+
+/**************************************************************/
+/* reset the scoring state for a new photon */
+void Start_Track_allvox(struct SimContext *ctx)
+{
+  struct AllvoxTrack *st=&ctx->allvox_trk;
+
+  ++ctx->bananaptr->banana_photons;
+  st->phot_disc_wt=1.0;
+  st->in_layer=0;
+  st->dead=0;
+  st->bdry_col=0;
+  st->ktrk=0;
+  st->visits.num=0;
+  st->ix=st->iy=st->iz=0;
+  st->side=0;
+  st->mu=0.0;
+}
+
+/**************************************************************/
+/* Score one track (this -> next) of the current photon. Called  */
+/* for every stored track by Compute_Prob_allvox(), or straight  */
+/* from Move_Photon() when scoring online (ALLVOX_STREAM).       */
+void Score_Track_allvox(struct SimContext *ctx, double this_x, double this_y,
+  double this_z, double next_x, double next_y, double next_z)
+{
+  struct AllvoxTrack *st=&ctx->allvox_trk;
+  double *in_vox=ctx->outptr->in_side_allvox;
+  double *out_vox=ctx->outptr->out_side_allvox;
+  const double *zb=ctx->layers.zb;  /* layer boundaries, SetupLayerTable() */
+  int debug=0,i,j,ktrk,curr_layer;
+  int nz;
+  double dx,dy,dz,xmid,ymid,zmid;
+  double s[6],tracklen;
+  /* voxel traversal, axes 0=x,1=y,2=z */
+  static const int exit_face[3][2]={{2,4},{3,1},{0,5}};  /* [axis][step>0] */
+  static const int opposite_face[NUM_SIDES]={5,3,4,1,2,0};
+  double p0[3],p1[3],dir[3],lo[3],h[3],tmax[3],tdelta[3],t,tcur;
+  int idx[3],tgt[3],step[3],a;
+  int bcol;  /* track starts with a boundary collision */
+  /* state carried from track to track */
+  int in_layer=st->in_layer,dead=st->dead,bdry_col=st->bdry_col;
+  int ix=st->ix,iy=st->iy,iz=st->iz,side=st->side;
+  double mu=st->mu,phot_disc_wt=st->phot_disc_wt;
+  double MIN_X,MAX_X,MIN_Y,MAX_Y,MIN_Z,MAX_Z;
+  MIN_X=-ctx->detector->nr*ctx->detector->dr-ctx->detector->dr/2;	  
+  MAX_X= ctx->detector->nr*ctx->detector->dr+ctx->detector->dr/2;	  
+  MIN_Y=-ctx->detector->nr*ctx->detector->dr-ctx->detector->dr/2;	  
+  MAX_Y= ctx->detector->nr*ctx->detector->dr+ctx->detector->dr/2;	  
+  MIN_Z=0.0;	  
+  MAX_Z= ctx->detector->nz*ctx->detector->dz;	  
+  dx=ctx->detector->dr;
+  dy=ctx->detector->nr*ctx->detector->dr+ctx->detector->dr;
+  dz=ctx->detector->dz;
+  nz=ctx->bananaptr->nz;
+  ktrk=st->ktrk;
+  bcol=0;
+  if (!dead) {
+    tracklen=sqrt((next_x-this_x)*(next_x-this_x)+
+                  (next_y-this_y)*(next_y-this_y)+
+                  (next_z-this_z)*(next_z-this_z));
+    xmid=this_x;
+    ymid=this_y;
+    zmid=this_z;
+    tcur=0.0;
+    p0[0]=this_x; p0[1]=this_y; p0[2]=this_z;
+    p1[0]=next_x; p1[1]=next_y; p1[2]=next_z;
+    for (a=0;a<3;++a) dir[a]=p1[a]-p0[a];
+    lo[0]=MIN_X; lo[1]=MIN_Y; lo[2]=MIN_Z;
+    h[0]=dx; h[1]=dy; h[2]=dz;
+    /* DEBUG */
+    /* if ((ctx->bananaptr->banana_photons>=1041)&&(ktrk>=270)) debug=1; 
+    else debug=0;     */
+    if (debug) { 
+      printf("N %3d TRACK %5d: this=(%15.10f,%15.10f,%15.10f)\n",
+      ctx->bananaptr->banana_photons,ktrk,this_x,this_y,this_z);
+      printf("                 : next=(%15.10f,%15.10f,%15.10f)\n",
+      next_x,next_y,next_z);
+	printf("phot_dist_wt=%f\n",phot_disc_wt);
+    } 
+    /* flag if out sides */
+    if ((fabs(next_x)>MAX_X)||(fabs(next_y)>MAX_Y)) {
+	in_layer=0;
+	if (debug) printf("outside of layer \n");
+    }  /* if out sides */
+    else { /* not out sides */
+      bcol=0;
+	/* following based on "this" s.t. check later for weights agrees; */
+	/* only the tops of the layer found and of the one below can be near */
+	i=LayerAt(ctx,this_z);
+	if ((fabs(this_z-zb[i-1])<1e-9)||
+	    ((i<ctx->tissptr->num_layers)&&(fabs(this_z-zb[i])<1e-9))) {
+	  bcol=1;
+	  if (debug) printf("boundary collision!\n");
+	}
+      if (!in_layer) { /* check if enter layer */
+	  if ((MIN_Z==0.0)&&(ktrk==0)) { /* layer at origin */
+	    /* NOTE: this may not handle if passes thru 1st voxel */
+	    in_layer=1;
+	    ix=floor((this_x-MIN_X)/dx);
+	    iy=floor((this_y-MIN_Y)/dy);
+	    iz=0;
+	    side=0;
+          /* adjoint */
+	    if (IN_GRID(ctx->bananaptr,ix,iy,iz)) {
+	      AddVox(ctx,&in_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt); 
+	      if (st->visits.record) Add_Visit_allvox(ctx,ix,iy,iz,ktrk,side);
+	    }
+	  } 
+	  else { /* layer not at origin */  
+          s[0]=0;
+          if ((this_z<=MIN_Z)&&(next_z>MIN_Z))  
+	       s[0]=(MIN_Z-this_z)/(next_z-this_z);
+          else if ((this_z>MAX_Z)&&(next_z<MAX_Z))  
+	       s[0]=(MAX_Z-this_z)/(next_z-this_z);
+	    /* determine point of intersection */
+	    if ((s[0]>0)&&(s[0]<=1)) {  /* crossed into layer */
+	      tcur=s[0];
+	      xmid=this_x+s[0]*(next_x-this_x);
+	      ymid=this_y+s[0]*(next_y-this_y);
+	      zmid=this_z+s[0]*(next_z-this_z);
+	      /* NOTE: ix,iy,iz always min of voxel */
+	      ix=floor((xmid-MIN_X)/dx);
+	      iy=floor((ymid-MIN_Y)/dy);
+	      if (next_z>this_z) { /* enter from top */
+	        iz=0;
+		side=0;
+              /* adjoint */
+		if ((in_layer)&&(IN_GRID(ctx->bananaptr,ix,iy,iz)))
+	          AddVox(ctx,&in_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt); 
+            }
+	      else  { /* enter from bottom */
+	        iz=nz-1;
+		side=5;
+              /* adjoint */
+		if ((in_layer)&&(IN_GRID(ctx->bananaptr,ix,iy,iz)))
+	          AddVox(ctx,&in_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt); 
+            }
+	      in_layer=1;
+	      if ((st->visits.record)&&(IN_GRID(ctx->bananaptr,ix,iy,iz)))
+	        Add_Visit_allvox(ctx,ix,iy,iz,ktrk,side);
+	    }  /* crossed into layer */
+	  } /* layer not at origin */
+        if ((debug)&&(in_layer)) {
+	    printf("enter layer at (x,y,z)=(%f,%f,%f)\n",xmid,ymid,zmid);
+	    printf("enter layer at (ix,iy,iz)=(%d,%d,%d)\n",ix,iy,iz); }
+        } /* check if enter layer */
+      else { /* check if exit layer */
+	  /* NOTE: this may not handle if passes thru edge voxel */
+        s[0]=0;
+        if ((this_z>MIN_Z)&&(next_z<=MIN_Z))  
+	    s[0]=(MIN_Z-this_z)/(next_z-this_z);
+        else if ((this_z<MAX_Z)&&(next_z>MAX_Z))  
+	    s[0]=(MAX_Z-this_z)/(next_z-this_z);
+	  /* determine point of intersection */
+	  if ((s[0]>0)&&(s[0]<=1)) {  /* crossed out of layer */
+	    xmid=this_x+s[0]*(next_x-this_x);
+	    ymid=this_y+s[0]*(next_y-this_y);
+	    zmid=this_z+s[0]*(next_z-this_z);
+	    ix=floor((xmid-MIN_X)/dx);
+	    iy=floor((ymid-MIN_Y)/dy);
+	    if (next_z>this_z) { /* exit bottom */
+	      iz=nz-1;
+	      side=5;
+            mu=(next_z-this_z)/tracklen;
+	      if ((in_layer)&&(IN_GRID(ctx->bananaptr,ix,iy,iz))) {
+              if (fabs(mu)>MU_LB)
+	          AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt/mu); 
+	        else
+	          AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt/(MU_LB/2)); 
+            }
+	    }
+          else { /* exit top */
+	      iz=0;
+	      side=0;
+            mu=-(next_z-this_z)/tracklen;
+	      if ((in_layer)&&(IN_GRID(ctx->bananaptr,ix,iy,iz))) {
+              if (fabs(mu)>MU_LB)
+	          AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt/mu);
+              else
+	          AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt/(MU_LB/2));
+            }
+          }
+	    in_layer=0;
+	    if (debug) {
+	    printf("out[side=%d,%d,%d,%d]=%e\n",side,ix,iy,iz,
+			    out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)]);
+	    printf("exit layer at (x,y,z)=(%f,%f,%f)\n",xmid,ymid,zmid);
+	    printf("exit: dist_in_vox(%d,%d,%d)=%f\n",ix,iy,iz,
+	                sqrt((this_x-xmid)*(this_x-xmid)+
+	                     (this_y-ymid)*(this_y-ymid)+
+	                     (this_z-zmid)*(this_z-zmid))); 
+	    }
+	  } /* crossed out of layer */
+      } /* check if exit layer */
+      /* boundary collision moving up on its first segment: save the */
+      /* exiting weight and start from the voxel above               */
+      if ((in_layer)&&(!dead)&&(bcol==1)&&(this_z>next_z)&&(this_z==zmid)) {
+        if (IN_GRID(ctx->bananaptr,ix,iy,iz)) {
+          if (fabs(mu)>MU_LB)
+            AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt/mu);
+          else
+            AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,side)],phot_disc_wt/(MU_LB/2));
+        }
+        --iz;
+      }
+      /* Amanatides-Woo traversal from the current voxel to the one   */
+      /* holding next: t runs 0..1 along this->next, tmax[a] is the t */
+      /* at which the track leaves the current voxel along axis a and */
+      /* tdelta[a] the t-width of one voxel along a. Only axes still  */
+      /* short of the target voxel can be stepped, so a track that    */
+      /* starts on a face needs no tolerance and always terminates.   */
+      if ((in_layer)&&(!dead)) {
+        idx[0]=ix; idx[1]=iy; idx[2]=iz;
+        for (a=0;a<3;++a) {
+          tgt[a]=(int)floor((p1[a]-lo[a])/h[a]);
+          step[a]=(tgt[a]>idx[a])?1:((tgt[a]<idx[a])?-1:0);
+          if ((step[a]==0)||(dir[a]==0.0)) {
+            tmax[a]=tcur;  /* off-target with no motion: step at once */
+            tdelta[a]=0.0;
+          }
+          else {
+            tmax[a]=(lo[a]+(idx[a]+(step[a]>0))*h[a]-p0[a])/dir[a];
+            tdelta[a]=h[a]/fabs(dir[a]);
+          }
+        }
+        while ((idx[0]!=tgt[0])||(idx[1]!=tgt[1])||(idx[2]!=tgt[2])) {
+          if (!IN_GRID(ctx->bananaptr,idx[0],idx[1],idx[2])) {
+            in_layer=0;
+            break;
+          }
+          /* leave through the nearest face still short of the target */
+          a=-1;
+          for (j=0;j<3;++j)
+            if ((idx[j]!=tgt[j])&&((a<0)||(tmax[j]<tmax[a]))) a=j;
+          t=tmax[a];
+          if (t<tcur) t=tcur;
+          if (t>1.0) t=1.0;
+          side=exit_face[a][step[a]>0];
+          mu=fabs(dir[a])/tracklen;
+          /* save weights since exiting current voxel */
+          if (fabs(mu)>MU_LB)
+            AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,idx[0],idx[1],idx[2],side)],phot_disc_wt/mu);
+          else
+            AddVox(ctx,&out_vox[ALLVOX_IDX(ctx->bananaptr,idx[0],idx[1],idx[2],side)],phot_disc_wt/(MU_LB/2));
+          if (debug) printf("out[side=%d,%d,%d,%d] t=%f\n",side,idx[0],idx[1],idx[2],t);
+          /* move to the next voxel */
+          idx[a]+=step[a];
+          tmax[a]+=tdelta[a];
+          tcur=t;
+          side=opposite_face[side];
+          if (!IN_GRID(ctx->bananaptr,idx[0],idx[1],idx[2])) {
+            in_layer=0;
+            break;
+          }
+          /* adjoint: save weights since entering voxel */
+          AddVox(ctx,&in_vox[ALLVOX_IDX(ctx->bananaptr,idx[0],idx[1],idx[2],side)],phot_disc_wt); 
+          if (st->visits.record) Add_Visit_allvox(ctx,idx[0],idx[1],idx[2],ktrk,side);
+        } /* while not in the voxel holding next */
+        ix=idx[0]; iy=idx[1]; iz=idx[2];
+        if (debug) printf("track ended in (ix,iy,iz)=(%d,%d,%d)\n",ix,iy,iz);
+      } /* if in layer */
+    } /* not out sides */
+    /* only deweight non-boundary collisions */
+    if ((bcol==0)||(ktrk==0)) {
+      /* last layer with zbegin<=z<=zend, 0 outside the tissue */
+      curr_layer=0;
+      if ((this_z>=zb[0])&&(this_z<=zb[ctx->tissptr->num_layers]))
+        curr_layer=LayerAt(ctx,this_z);
+      phot_disc_wt*=ctx->tissptr->layerprops[curr_layer].mus/
+          (ctx->tissptr->layerprops[curr_layer].mus+
+           ctx->tissptr->layerprops[curr_layer].mua);
+    } /* if not boundary collision */
+    else
+      ++bdry_col;
+  } /* if not dead */
+  st->in_layer=in_layer;
+  st->dead=dead;
+  st->bdry_col=bdry_col;
+  st->ix=ix; st->iy=iy; st->iz=iz;
+  st->side=side;
+  st->mu=mu;
+  st->phot_disc_wt=phot_disc_wt;
+  ++st->ktrk;
+}
+/**************************************************************/
+/* append a voxel visit; the buffer only grows (doubling), and  */
+/* Start_Track_allvox() empties it by resetting the count       */
+void Add_Visit_allvox(struct SimContext *ctx, 
+                int ix, int iy, int iz, int col, int sa_idx)
+{
+  struct VoxVisitBuffer *vb=&ctx->allvox_trk.visits;
+  struct VoxVisit *temp;
+  if (vb->num==vb->cap) {
+    vb->cap=(vb->cap>0)?2*vb->cap:256;
+    if ((temp=realloc(vb->rec,vb->cap*sizeof(*temp)))==NULL) 
+      nrerror("allocation failure in Add_Visit_allvox()");
+    vb->rec=temp;
+  }
+  temp=&vb->rec[vb->num++];
+  temp->ix=ix;
+  temp->iy=iy;
+  temp->iz=iz;
+  temp->col=col;
+  temp->sa_idx=sa_idx;
+}
+/************************************************************/
+/* count each voxel the photon entered once: the stamp holds  */
+/* the last photon (curr_n, never 0) that entered the voxel   */
+void Count_Visits_allvox(struct SimContext *ctx)
+{
+  struct VoxVisitBuffer *vb=&ctx->allvox_trk.visits;
+  struct bvolume *b=ctx->bananaptr;
+  int i,n=ctx->photptr->curr_n;
+  size_t v;
+
+  for (i=0;i<vb->num;++i) {
+    v=VOX_IDX(b,vb->rec[i].ix,vb->rec[i].iy,vb->rec[i].iz);
+    if (b->visit_stamp[v]!=n) {
+      b->visit_stamp[v]=n;
+      ctx->outptr->visits_allvox[v]+=1.0;
+    }
+  }
+}
+/************************************************************/
+void Free_Visits_allvox(struct SimContext *ctx)
+{
+  struct VoxVisitBuffer *vb=&ctx->allvox_trk.visits;
+  free(vb->rec);
+  vb->rec=NULL;
+  vb->num=vb->cap=0;
+}
+/************************************************************/
+void Output_Wts_allvox(struct SimContext *ctx)
+ {
+   FILE *ofp[6];
+   int ix,iy,iz,iw,N,num_sides=6;
+   char tmp[256];
+   /* QFIX: assume symmetry -> use forward for adjoint */
+   double src_NA=ctx->source->src_NA,det_NA=src_NA;
+   double dx,dy,dz,delmu,delphi,Rhoog_norm;
+   double Asrc,Adet,n=ctx->tissptr->layerprops[1].n;
+   /* delmu=1.0/ctx->bananaptr->num_mu;
+   delphi=2*PI/ctx->bananaptr->num_phi; */
+   delmu=1.0; /* assume 1 angular bin now */
+   delphi=2*PI;
+   dx=ctx->detector->dr;
+   dy=ctx->detector->dr;
+   dz=ctx->detector->dz;
+   N=ctx->source->num_photons;
+   /* NOTE: norm/denom(dx*dy*dz*dmu*dphi) factor of adjoint files */
+     for (iw=0;iw<num_sides;++iw) {
+       sprintf(tmp,"%s%i","wts_out_side",iw);
+       ofp[iw]=fopen(tmp,"w");
+       for(iz=0;iz<ctx->bananaptr->nz;++iz) {
+         for(ix=0;ix<ctx->bananaptr->nx;++ix) {
+           for(iy=0;iy<ctx->bananaptr->ny;++iy) {
+             fprintf(ofp[iw],"%.6e ",
+               ctx->outptr->out_side_allvox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,iw)]); // CKH 09jan31 make consist with c#
+           } /* for iy */
+         } /* for ix */
+         fprintf(ofp[iw],"\n");
+       } /* for iz */
+       fclose(ofp[iw]);
+     } /* for iw */
+     if (ctx->source->beam_radius==0.0)
+       Asrc=1;
+     else
+       Asrc=PI*ctx->source->beam_radius*ctx->source->beam_radius;
+     /* Adet=PI*ctx->detector->det_rad*ctx->detector->det_rad; */
+     Adet=Asrc;
+     Rhoog_norm=Asrc*2*PI*(1-sqrt(1-(src_NA/n)*(src_NA/n)))*
+	        Adet*2*PI*(1-sqrt(1-(det_NA/n)*(det_NA/n)));
+     //printf("in_side[0][200][0][0]=%e\n",outptr->in_side_allvox[0][200][0][0]);
+     for (iw=0;iw<num_sides;++iw) {
+       sprintf(tmp,"%s%i","wts_in_side",iw);
+       ofp[iw]=fopen(tmp,"w");
+       for(iz=0;iz<ctx->bananaptr->nz;++iz) {
+         for(ix=0;ix<ctx->bananaptr->nx;++ix) {
+           for(iy=0;iy<ctx->bananaptr->ny;++iy) {
+             if ((iw==0)||(iw==5)) {
+               fprintf(ofp[iw],"%.6e ",
+                 Rhoog_norm*ctx->outptr->in_side_allvox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,iw)]/
+		 (delmu*delphi*dx*dy*N*N));
+                
+             }
+             else if ((iw==1)||(iw==3)) {
+               fprintf(ofp[iw],"%.6e ",
+                 Rhoog_norm*ctx->outptr->in_side_allvox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,iw)]/
+		 (delmu*delphi*dx*dz*N*N));
+	     }
+             else if ((iw==2)||(iw==4)) {
+               fprintf(ofp[iw],"%.6e ",
+                 Rhoog_norm*ctx->outptr->in_side_allvox[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,iw)]/
+		 (delmu*delphi*dy*dz*N*N));
+             }
+           } /* for iy */
+         } /* for ix */
+         fprintf(ofp[iw],"\n");
+       } /* for iz */
+       fclose(ofp[iw]);
+     } /* for iw */
+   /* fraction of the photons that entered each voxel */
+   if (ctx->outptr->visits_allvox!=NULL) {
+     ofp[0]=fopen("wts_visits","w");
+     for(iz=0;iz<ctx->bananaptr->nz;++iz) {
+       for(ix=0;ix<ctx->bananaptr->nx;++ix) {
+         for(iy=0;iy<ctx->bananaptr->ny;++iy) {
+           fprintf(ofp[0],"%.6e ",
+             ctx->outptr->visits_allvox[VOX_IDX(ctx->bananaptr,ix,iy,iz)]/N);
+         } /* for iy */
+       } /* for ix */
+       fprintf(ofp[0],"\n");
+     } /* for iz */
+     fclose(ofp[0]);
+   }
+   /* relative errors, same layout; unchanged by the scaling above */
+   if (ctx->moments.on) {
+     for (iw=0;iw<2*num_sides;++iw) {
+       double *v=(iw<num_sides) ? ctx->outptr->in_side_allvox : ctx->outptr->out_side_allvox;
+       sprintf(tmp,"%s%i_relerr",(iw<num_sides) ? "wts_in_side" : "wts_out_side",iw%num_sides);
+       ofp[0]=fopen(tmp,"w");
+       for(iz=0;iz<ctx->bananaptr->nz;++iz) {
+         for(ix=0;ix<ctx->bananaptr->nx;++ix) {
+           for(iy=0;iy<ctx->bananaptr->ny;++iy) {
+             fprintf(ofp[0],"%.6e ",
+               RelErr(ctx,&v[ALLVOX_IDX(ctx->bananaptr,ix,iy,iz,iw%num_sides)]));
+           } /* for iy */
+         } /* for ix */
+         fprintf(ofp[0],"\n");
+       } /* for iz */
+       fclose(ofp[0]);
+     } /* for iw */
+   }
+ }
@@ -0,0 +1,604 @@
+/* Batch transport engine.
+*
+*  Advances BATCH_LANES photons at a time, held in structure-of-arrays
+*  form so that step sampling, the layer-boundary test, the move and
+*  Henyey-Greenstein scattering run as vector kernels over all lanes.
+*  The kernels come in a generic C version and an AVX2 version picked
+*  at run time from the CPU. The log() of the step and the cos/sin of
+*  the azimuth are evaluated in the kernels by polynomials (BatchLog,
+*  BatchSinCos2Pi) instead of one libm call per lane. Both versions do
+*  the same IEEE operations in the same order (no FMA), so they give
+*  bit-identical results; against the scalar engine the results agree
+*  statistically, not bit for bit.
+*
+*  Each lane draws from its own photon's Philox stream, so the engine
+*  requires RNG_PHILOX. Layer crossings (Fresnel, R/T tallies) are
+*  rare and are done by the scalar CrossLayer() on the lane's state.
+*  A lane whose photon dies is refilled with the next photon from
+*  init_photon() so the vector units stay busy. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "pert.h"
+#include "mc_batch.h"
+#include "mc_stats.h"
+#include "protos.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (_MSC_VER>=1700) && (defined(_M_X64) || defined(_M_IX86))
+#define BATCH_AVX2 1
+#define AVX2_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#define ONE (1.0-1e-12)
+#define PI_D 3.14159265358979323846	/* full precision, PI in mc_main.h is short */
+
+/*****************************************************************/
+/* polynomial log and sincos shared by both kernel sets          */
+
+/* log(m)=2*atanh(s), s=(m-1)/(m+1), |s|<0.172 for m in [sqrt(.5),sqrt(2)) */
+static const double log_coef[11]={
+	1.0/21,1.0/19,1.0/17,1.0/15,1.0/13,1.0/11,1.0/9,1.0/7,1.0/5,1.0/3,1.0
+};
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+#define SQRT2 1.41421356237309504880
+
+/* Taylor coefficients in a for |a|<=pi/4, highest order first */
+static const double sin_coef[9]={
+	1.0/355687428096000.0,-1.0/1307674368000.0,1.0/6227020800.0,-1.0/39916800.0,
+	1.0/362880.0,-1.0/5040.0,1.0/120.0,-1.0/6.0,1.0
+};
+static const double cos_coef[10]={
+	-1.0/6402373705728000.0,1.0/20922789888000.0,-1.0/87178291200.0,1.0/479001600.0,
+	-1.0/3628800.0,1.0/40320.0,-1.0/720.0,1.0/24.0,-1.0/2.0,1.0
+};
+
+/* natural log for 0<x<inf */
+static double BatchLog(double x)
+{
+	int e;
+	double m,s,s2,p;
+	int i;
+
+	m=2.0*frexp(x,&e);	/* x=m*2^(e-1), m in [1,2) */
+	e=e-1;
+	if (m>SQRT2) {
+		m=m*0.5;
+		e=e+1;
+	}
+	s=(m-1.0)/(m+1.0);
+	s2=s*s;
+	p=log_coef[0];
+	for (i=1;i<11;++i)
+		p=p*s2+log_coef[i];
+	return (double)e*LN2_HI+((2.0*s)*p+(double)e*LN2_LO);
+}
+
+/* sin and cos of 2*pi*u, reduced to an octant exactly in u */
+static void BatchSinCos2Pi(double u, double *sin_out, double *cos_out)
+{
+	double t,q,a,a2,sa,ca;
+	int i;
+
+	t=u-floor(u+0.5);	/* [-1/2,1/2] */
+	q=floor(4.0*t+0.5);	/* quadrant -2..2 */
+	a=(2.0*PI_D)*(t-0.25*q);	/* [-pi/4,pi/4] */
+	a2=a*a;
+	sa=sin_coef[0];
+	for (i=1;i<9;++i)
+		sa=sa*a2+sin_coef[i];
+	sa=sa*a;
+	ca=cos_coef[0];
+	for (i=1;i<10;++i)
+		ca=ca*a2+cos_coef[i];
+	if (q==0.0) {
+		*sin_out=sa; *cos_out=ca;
+	}
+	else if (q==1.0) {
+		*sin_out=ca; *cos_out=-sa;
+	}
+	else if (q==-1.0) {
+		*sin_out=-ca; *cos_out=sa;
+	}
+	else {
+		*sin_out=-sa; *cos_out=-ca;
+	}
+}
+
+/*****************************************************************/
+/* generic kernels                                               */
+static void StepGeneric(struct PhotonBatch *b)
+{
+	int l;
+
+	for (l=0;l<BATCH_LANES;++l) {
+		if (b->sleft[l]==0.0)
+			b->s[l]=-BatchLog(b->rn_step[l])/b->mut[l];
+		else {
+			b->s[l]=b->sleft[l]/b->mut[l];
+			b->sleft[l]=0.0;
+		}
+	}
+}
+
+static void BoundaryGeneric(struct PhotonBatch *b)
+{
+	int l;
+	double dbound;
+
+	for (l=0;l<BATCH_LANES;++l) {
+		dbound=((b->uz[l]<0.0) ? b->zbegin[l] : b->zend[l])-b->z[l];
+		dbound=dbound/b->uz[l];
+		if ((b->uz[l]!=0.0)&&(b->s[l]>dbound)) {
+			b->hit[l]=1.0;
+			b->sleft[l]=(b->s[l]-dbound)*b->mut[l];
+			b->s[l]=dbound;
+		}
+		else
+			b->hit[l]=0.0;
+	}
+}
+
+static void MoveGeneric(struct PhotonBatch *b)
+{
+	int l;
+	double x,y,z;
+
+	for (l=0;l<BATCH_LANES;++l) {
+		x=b->x[l]+b->s[l]*b->ux[l];
+		y=b->y[l]+b->s[l]*b->uy[l];
+		z=b->z[l]+b->s[l]*b->uz[l];
+		/* same as the history-based length in Move_Photon() */
+		b->step_len[l]=sqrt((x-b->x[l])*(x-b->x[l])+(y-b->y[l])*(y-b->y[l])+
+			(z-b->z[l])*(z-b->z[l]));
+		b->x[l]=x;
+		b->y[l]=y;
+		b->z[l]=z;
+	}
+}
+
+static void ScatterGeneric(struct PhotonBatch *b)
+{
+	int l;
+	double g,cost,sint,temp,ux,uy,uz,cosp,sinp;
+
+	for (l=0;l<BATCH_LANES;++l) {
+		if (b->scat[l]==0.0)
+			continue;
+		BatchSinCos2Pi(b->rn_psi[l],&sinp,&cosp);
+		g=b->g[l];
+		if (g==0.0)
+			cost=2*b->rn_theta[l]-1;
+		else {
+			temp=(1-g*g)/(1-g+2*g*b->rn_theta[l]);
+			cost=(1+g*g-temp*temp)/(2*g);
+			if (cost<-1) cost=-1;
+			else if (cost>1) cost=1;
+		}
+		sint=sqrt(1.0-cost*cost);
+		ux=b->ux[l];
+		uy=b->uy[l];
+		uz=b->uz[l];
+		if (fabs(uz)>(1-1e-10)) {
+			b->ux[l]=sint*cosp;
+			b->uy[l]=sint*sinp;
+			b->uz[l]=cost*uz/fabs(uz);
+		}
+		else {
+			temp=sqrt(1.0-uz*uz);
+			b->ux[l]=sint*(ux*uz*cosp-uy*sinp)/temp+ux*cost;
+			b->uy[l]=sint*(uy*uz*cosp+ux*sinp)/temp+uy*cost;
+			b->uz[l]=-sint*cosp*temp+uz*cost;
+		}
+	}
+}
+
+static const struct BatchKernels generic_kernels={
+	"generic",StepGeneric,BoundaryGeneric,MoveGeneric,ScatterGeneric
+};
+
+#ifdef BATCH_AVX2
+/*****************************************************************/
+/* AVX2 kernels: 4 lanes per register, branches become blends    */
+#define NV (BATCH_LANES/4)
+
+AVX2_TARGET static __m256d Poly4(__m256d x, const double *coef, int n)
+{
+	__m256d p=_mm256_set1_pd(coef[0]);
+	int i;
+
+	for (i=1;i<n;++i)
+		p=_mm256_add_pd(_mm256_mul_pd(p,x),_mm256_set1_pd(coef[i]));
+	return p;
+}
+
+/* BatchLog() on 4 lanes, exponent and mantissa split with integer ops */
+AVX2_TARGET static __m256d Log4(__m256d x)
+{
+	__m256i bits=_mm256_castpd_si256(x);
+	__m256i magic=_mm256_set1_epi64x(0x4330000000000000LL);	/* 2^52 */
+	__m256d one=_mm256_set1_pd(1.0);
+	__m256d m,e,big,s,s2,p;
+
+	/* biased exponent as a double via the 2^52 trick */
+	e=_mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits,52),magic)),
+		_mm256_set1_pd(4503599627370496.0+1023.0));
+	m=_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits,
+		_mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),_mm256_castpd_si256(one)));
+	big=_mm256_cmp_pd(m,_mm256_set1_pd(SQRT2),_CMP_GT_OQ);
+	m=_mm256_blendv_pd(m,_mm256_mul_pd(m,_mm256_set1_pd(0.5)),big);
+	e=_mm256_blendv_pd(e,_mm256_add_pd(e,one),big);
+	s=_mm256_div_pd(_mm256_sub_pd(m,one),_mm256_add_pd(m,one));
+	s2=_mm256_mul_pd(s,s);
+	p=Poly4(s2,log_coef,11);
+	return _mm256_add_pd(_mm256_mul_pd(e,_mm256_set1_pd(LN2_HI)),
+		_mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0),s),p),
+		_mm256_mul_pd(e,_mm256_set1_pd(LN2_LO))));
+}
+
+/* BatchSinCos2Pi() on 4 lanes */
+AVX2_TARGET static void SinCos2Pi4(__m256d u, __m256d *sin_out, __m256d *cos_out)
+{
+	__m256d half=_mm256_set1_pd(0.5),sign_bit=_mm256_set1_pd(-0.0);
+	__m256d t,q,a,a2,sa,ca,q1,qm1,q2,sn,cs;
+
+	t=_mm256_sub_pd(u,_mm256_floor_pd(_mm256_add_pd(u,half)));
+	q=_mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(4.0),t),half));
+	a=_mm256_mul_pd(_mm256_set1_pd(2.0*PI_D),_mm256_sub_pd(t,_mm256_mul_pd(_mm256_set1_pd(0.25),q)));
+	a2=_mm256_mul_pd(a,a);
+	sa=_mm256_mul_pd(Poly4(a2,sin_coef,9),a);
+	ca=Poly4(a2,cos_coef,10);
+	q1=_mm256_cmp_pd(q,_mm256_set1_pd(1.0),_CMP_EQ_OQ);
+	qm1=_mm256_cmp_pd(q,_mm256_set1_pd(-1.0),_CMP_EQ_OQ);
+	q2=_mm256_cmp_pd(_mm256_andnot_pd(sign_bit,q),_mm256_set1_pd(2.0),_CMP_EQ_OQ);
+	sn=_mm256_blendv_pd(sa,ca,q1);
+	cs=_mm256_blendv_pd(ca,_mm256_xor_pd(sa,sign_bit),q1);
+	sn=_mm256_blendv_pd(sn,_mm256_xor_pd(ca,sign_bit),qm1);
+	cs=_mm256_blendv_pd(cs,sa,qm1);
+	sn=_mm256_blendv_pd(sn,_mm256_xor_pd(sa,sign_bit),q2);
+	cs=_mm256_blendv_pd(cs,_mm256_xor_pd(ca,sign_bit),q2);
+	*sin_out=sn;
+	*cos_out=cs;
+}
+
+AVX2_TARGET static void StepAVX2(struct PhotonBatch *b)
+{
+	__m256d zero=_mm256_setzero_pd(),sign_bit=_mm256_set1_pd(-0.0);
+	__m256d sleft,mut,is_new,s,neg_log;
+	int v;
+
+	for (v=0;v<NV;++v) {
+		sleft=_mm256_loadu_pd(b->sleft+4*v);
+		mut=_mm256_loadu_pd(b->mut+4*v);
+		is_new=_mm256_cmp_pd(sleft,zero,_CMP_EQ_OQ);
+		neg_log=_mm256_xor_pd(Log4(_mm256_loadu_pd(b->rn_step+4*v)),sign_bit);
+		s=_mm256_div_pd(_mm256_blendv_pd(sleft,neg_log,is_new),mut);
+		_mm256_storeu_pd(b->s+4*v,s);
+		_mm256_storeu_pd(b->sleft+4*v,zero);
+	}
+}
+
+AVX2_TARGET static void BoundaryAVX2(struct PhotonBatch *b)
+{
+	__m256d zero=_mm256_setzero_pd(),one=_mm256_set1_pd(1.0);
+	__m256d uz,z,s,mut,dbound,hit;
+	int v;
+
+	for (v=0;v<NV;++v) {
+		uz=_mm256_loadu_pd(b->uz+4*v);
+		z=_mm256_loadu_pd(b->z+4*v);
+		s=_mm256_loadu_pd(b->s+4*v);
+		mut=_mm256_loadu_pd(b->mut+4*v);
+		dbound=_mm256_blendv_pd(_mm256_loadu_pd(b->zend+4*v),_mm256_loadu_pd(b->zbegin+4*v),
+			_mm256_cmp_pd(uz,zero,_CMP_LT_OQ));
+		dbound=_mm256_div_pd(_mm256_sub_pd(dbound,z),uz);
+		hit=_mm256_and_pd(_mm256_cmp_pd(uz,zero,_CMP_NEQ_OQ),_mm256_cmp_pd(s,dbound,_CMP_GT_OQ));
+		_mm256_storeu_pd(b->hit+4*v,_mm256_and_pd(hit,one));
+		/* sleft is 0 here, StepAVX2 just cleared it */
+		_mm256_storeu_pd(b->sleft+4*v,_mm256_and_pd(hit,_mm256_mul_pd(_mm256_sub_pd(s,dbound),mut)));
+		_mm256_storeu_pd(b->s+4*v,_mm256_blendv_pd(s,dbound,hit));
+	}
+}
+
+AVX2_TARGET static void MoveAVX2(struct PhotonBatch *b)
+{
+	__m256d s,x0,y0,z0,x,y,z,dx,dy,dz;
+	int v;
+
+	for (v=0;v<NV;++v) {
+		s=_mm256_loadu_pd(b->s+4*v);
+		x0=_mm256_loadu_pd(b->x+4*v);
+		y0=_mm256_loadu_pd(b->y+4*v);
+		z0=_mm256_loadu_pd(b->z+4*v);
+		x=_mm256_add_pd(x0,_mm256_mul_pd(s,_mm256_loadu_pd(b->ux+4*v)));
+		y=_mm256_add_pd(y0,_mm256_mul_pd(s,_mm256_loadu_pd(b->uy+4*v)));
+		z=_mm256_add_pd(z0,_mm256_mul_pd(s,_mm256_loadu_pd(b->uz+4*v)));
+		dx=_mm256_sub_pd(x,x0);
+		dy=_mm256_sub_pd(y,y0);
+		dz=_mm256_sub_pd(z,z0);
+		_mm256_storeu_pd(b->step_len+4*v,_mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(
+			_mm256_mul_pd(dx,dx),_mm256_mul_pd(dy,dy)),_mm256_mul_pd(dz,dz))));
+		_mm256_storeu_pd(b->x+4*v,x);
+		_mm256_storeu_pd(b->y+4*v,y);
+		_mm256_storeu_pd(b->z+4*v,z);
+	}
+}
+
+AVX2_TARGET static void ScatterAVX2(struct PhotonBatch *b)
+{
+	__m256d zero=_mm256_setzero_pd(),one=_mm256_set1_pd(1.0),two=_mm256_set1_pd(2.0);
+	__m256d sign_bit=_mm256_set1_pd(-0.0),normal=_mm256_set1_pd(1-1e-10);
+	__m256d g,rn,cost,cost_iso,temp,sint,ux,uy,uz,abs_uz,cosp,sinp,scat,is_normal;
+	__m256d ux_n,uy_n,uz_n,ux_o,uy_o,uz_o;
+	int v;
+
+	for (v=0;v<NV;++v) {
+		scat=_mm256_cmp_pd(_mm256_loadu_pd(b->scat+4*v),zero,_CMP_NEQ_OQ);
+		if (_mm256_movemask_pd(scat)==0)
+			continue;
+		g=_mm256_loadu_pd(b->g+4*v);
+		rn=_mm256_loadu_pd(b->rn_theta+4*v);
+		SinCos2Pi4(_mm256_loadu_pd(b->rn_psi+4*v),&sinp,&cosp);
+		ux=_mm256_loadu_pd(b->ux+4*v);
+		uy=_mm256_loadu_pd(b->uy+4*v);
+		uz=_mm256_loadu_pd(b->uz+4*v);
+
+		/* Henyey-Greenstein, isotropic where g==0 */
+		cost_iso=_mm256_sub_pd(_mm256_mul_pd(two,rn),one);
+		temp=_mm256_div_pd(_mm256_sub_pd(one,_mm256_mul_pd(g,g)),
+			_mm256_add_pd(_mm256_sub_pd(one,g),_mm256_mul_pd(_mm256_mul_pd(two,g),rn)));
+		cost=_mm256_div_pd(_mm256_sub_pd(_mm256_add_pd(one,_mm256_mul_pd(g,g)),_mm256_mul_pd(temp,temp)),
+			_mm256_mul_pd(two,g));
+		cost=_mm256_max_pd(_mm256_min_pd(cost,one),_mm256_sub_pd(zero,one));
+		cost=_mm256_blendv_pd(cost,cost_iso,_mm256_cmp_pd(g,zero,_CMP_EQ_OQ));
+		sint=_mm256_sqrt_pd(_mm256_sub_pd(one,_mm256_mul_pd(cost,cost)));
+
+		/* near-normal incidence */
+		abs_uz=_mm256_andnot_pd(sign_bit,uz);
+		is_normal=_mm256_cmp_pd(abs_uz,normal,_CMP_GT_OQ);
+		ux_n=_mm256_mul_pd(sint,cosp);
+		uy_n=_mm256_mul_pd(sint,sinp);
+		uz_n=_mm256_div_pd(_mm256_mul_pd(cost,uz),abs_uz);
+
+		/* general rotation */
+		temp=_mm256_sqrt_pd(_mm256_sub_pd(one,_mm256_mul_pd(uz,uz)));
+		ux_o=_mm256_add_pd(_mm256_div_pd(_mm256_mul_pd(sint,_mm256_sub_pd(
+			_mm256_mul_pd(_mm256_mul_pd(ux,uz),cosp),_mm256_mul_pd(uy,sinp))),temp),
+			_mm256_mul_pd(ux,cost));
+		uy_o=_mm256_add_pd(_mm256_div_pd(_mm256_mul_pd(sint,_mm256_add_pd(
+			_mm256_mul_pd(_mm256_mul_pd(uy,uz),cosp),_mm256_mul_pd(ux,sinp))),temp),
+			_mm256_mul_pd(uy,cost));
+		uz_o=_mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_xor_pd(sint,sign_bit),cosp),temp),
+			_mm256_mul_pd(uz,cost));
+
+		ux_o=_mm256_blendv_pd(ux_o,ux_n,is_normal);
+		uy_o=_mm256_blendv_pd(uy_o,uy_n,is_normal);
+		uz_o=_mm256_blendv_pd(uz_o,uz_n,is_normal);
+		_mm256_storeu_pd(b->ux+4*v,_mm256_blendv_pd(ux,ux_o,scat));
+		_mm256_storeu_pd(b->uy+4*v,_mm256_blendv_pd(uy,uy_o,scat));
+		_mm256_storeu_pd(b->uz+4*v,_mm256_blendv_pd(uz,uz_o,scat));
+	}
+}
+
+static const struct BatchKernels avx2_kernels={
+	"avx2",StepAVX2,BoundaryAVX2,MoveAVX2,ScatterAVX2
+};
+
+static int CpuHasAVX2(void)
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	int info[4];
+
+	__cpuid(info,1);
+	/* OSXSAVE and AVX, and the OS saves the ymm registers */
+	if (((info[2]&(1<<27))==0)||((info[2]&(1<<28))==0))
+		return 0;
+	if ((_xgetbv(0)&6)!=6)
+		return 0;
+	__cpuidex(info,7,0);
+	return (info[1]&(1<<5))!=0;
+#endif
+}
+#endif /* BATCH_AVX2 */
+
+/*****************************************************************/
+/* best kernel set for this CPU; MC_BATCH_ISA=generic forces the  */
+/* portable one                                                   */
+const struct BatchKernels *SelectBatchKernels(void)
+{
+	const char *isa=getenv("MC_BATCH_ISA");
+
+	if ((isa!=NULL)&&(strcmp(isa,"generic")==0))
+		return &generic_kernels;
+#ifdef BATCH_AVX2
+	if (CpuHasAVX2())
+		return &avx2_kernels;
+#endif
+	return &generic_kernels;
+}
+
+/*****************************************************************/
+int UseBatchEngine(struct SimContext *ctx)
+{
+	return (ctx->flagptr->TransportEngine==ENGINE_BATCH)&&
+		(ctx->flagptr->RngType==RNG_PHILOX)&&
+		(ctx->flagptr->AbsWtType==ABS_DISCRETE)&&
+		(ctx->flagptr->Allvox==ALLVOX_OFF)&&
+		(ctx->whiteptr==NULL)&&
+		(ctx->flagptr->Tracking==TRACK_SURFACE)&&
+		!ctx->flagptr->TallySecondMoment&&
+		(ctx->tissptr->do_ellip_layer<3);
+}
+
+/*****************************************************************/
+/* move lane l into ctx->photptr so the scalar routines can run  */
+static void LoadLane(struct SimContext *ctx, struct PhotonBatch *b, int l)
+{
+	struct Photon *p=ctx->photptr;
+
+	p->x=b->x[l]; p->y=b->y[l]; p->z=b->z[l];
+	p->ux=b->ux[l]; p->uy=b->uy[l]; p->uz=b->uz[l];
+	p->w=b->w[l];
+	p->s=b->s[l];
+	p->sleft=b->sleft[l];
+	p->curr_layer=b->curr_layer[l];
+	p->curr_n=b->n[l];
+	p->dead=0;
+	ctx->prng=b->prng[l];
+	ctx->histptr->cum_path_length=b->cum_path_length[l];
+}
+
+static void StoreLane(struct SimContext *ctx, struct PhotonBatch *b, int l)
+{
+	struct Photon *p=ctx->photptr;
+
+	b->x[l]=p->x; b->y[l]=p->y; b->z[l]=p->z;
+	b->ux[l]=p->ux; b->uy[l]=p->uy; b->uz[l]=p->uz;
+	b->w[l]=p->w;
+	b->s[l]=p->s;
+	b->sleft[l]=p->sleft;
+	b->curr_layer[l]=p->curr_layer;
+	b->prng[l]=ctx->prng;
+	b->cum_path_length[l]=ctx->histptr->cum_path_length;
+}
+
+/* start photon n in lane l, or empty the lane if n is past the range */
+static void FillLane(struct SimContext *ctx, struct PhotonBatch *b, int l, int n, int last)
+{
+	if (n>last) {
+		b->n[l]=0;
+		b->x[l]=b->y[l]=b->z[l]=0.0;
+		b->ux[l]=b->uy[l]=0.0;
+		b->uz[l]=1.0;
+		b->w[l]=0.0;
+		b->sleft[l]=0.0;
+		b->curr_layer[l]=1;
+		return;
+	}
+	ctx->photptr->curr_n=n;
+	SeedPhotonStream(ctx,n);
+	init_photon(ctx);
+	ctx->photptr->dead=0;
+	StoreLane(ctx,b,l);
+	b->n[l]=n;
+	b->num_steps[l]=1;
+}
+
+/*****************************************************************/
+/* RunPhotonRange() with photons advanced BATCH_LANES at a time  */
+void RunPhotonRangeBatch(struct SimContext *ctx, int first, int last)
+{
+	const struct BatchKernels *k=SelectBatchKernels();
+	struct PhotonBatch *b;
+	struct Layer *lp;
+	int l,active,next_n=first;
+	int num_in_range=last-first+1;
+	int status_every=num_in_range/10;
+	short ir,iz;
+	double RN,dw,prr;
+
+	if ((ctx->worker<=1)&&(first==1))
+		printf("batch engine: %d lanes, %s kernels\n",BATCH_LANES,k->name);
+	b=(struct PhotonBatch *)calloc(1,sizeof(struct PhotonBatch));
+	for (l=0;l<BATCH_LANES;++l)
+		FillLane(ctx,b,l,next_n++,last);
+
+	do {
+		/* gather layer data and draw the step lengths */
+		for (l=0;l<BATCH_LANES;++l) {
+			lp=&ctx->tissptr->layerprops[b->curr_layer[l]];
+			b->mut[l]=lp->mua+lp->mus;
+			b->g[l]=lp->g;
+			b->zbegin[l]=lp->zbegin;
+			b->zend[l]=lp->zend;
+			b->rn_step[l]=0.5;
+			b->scat[l]=0.0;
+			if (b->n[l]&&(b->sleft[l]==0.0)) {
+				do RN=PhiloxNum(&b->prng[l]);
+				while ((RN<=0.0)||(RN>ONE));
+				b->rn_step[l]=RN;
+			}
+		}
+		k->step(b);
+		k->boundary(b);
+		k->move(b);
+
+		/* per-lane events: layer crossing, or absorb and set up the scatter */
+		for (l=0;l<BATCH_LANES;++l) {
+			if (!b->n[l])
+				continue;
+			++b->num_steps[l];
+			ctx->pertptr->pathlen_in_layer[b->curr_layer[l]]+=b->step_len[l];
+			b->cum_path_length[l]+=b->step_len[l];
+			if (b->hit[l]!=0.0) {
+				STATS_INC(ctx,boundary_hits);
+				LoadLane(ctx,b,l);
+				CrossLayer(ctx);
+				StoreLane(ctx,b,l);
+				if (ctx->photptr->dead) {
+					STATS_END_PHOTON(ctx,b->num_steps[l]);
+					b->num_steps[l]=0;	/* marks the lane for refill */
+				}
+			}
+			else {
+				STATS_INC(ctx,collisions);
+				++ctx->pertptr->col_in_layer[b->curr_layer[l]];
+				lp=&ctx->tissptr->layerprops[b->curr_layer[l]];
+				/* same binning and deweighting as Absorb() */
+				iz=(short)(b->z[l]/ctx->detector->dz);
+				if (iz>ctx->detector->nz-1) iz=ctx->detector->nz-1;
+				ir=(short)(sqrt(b->x[l]*b->x[l]+b->y[l]*b->y[l])/ctx->detector->dr);
+				if (ir>ctx->detector->nr-1) ir=ctx->detector->nr-1;
+				dw=b->w[l]*lp->mua/(lp->mua+lp->mus);
+				b->w[l]-=dw;
+				ctx->outptr->A_layer[b->curr_layer[l]]+=dw;
+				ctx->outptr->A_rz[ir][iz]+=dw;
+
+				b->scat[l]=1.0;
+				b->rn_theta[l]=PhiloxNum(&b->prng[l]);
+				b->rn_psi[l]=PhiloxNum(&b->prng[l]);
+			}
+		}
+		k->scatter(b);
+
+		/* retire dead photons and refill their lanes */
+		active=0;
+		for (l=0;l<BATCH_LANES;++l) {
+			if (!b->n[l])
+				continue;
+			/* TestWeight() roulette, drawn from the lane's stream */
+			if ((b->num_steps[l]!=0)&&
+				(b->w[l]<ctx->pertptr->layer_wt_cut[b->curr_layer[l]])) {
+				prr=ctx->pertptr->layer_prr[b->curr_layer[l]];
+				if ((b->w[l]!=0.0)&&(PhiloxNum(&b->prng[l])<prr))
+					b->w[l]/=prr;
+				else {
+					++ctx->pertptr->tot_rouletted;
+					STATS_END_PHOTON(ctx,b->num_steps[l]);
+					b->num_steps[l]=0;
+				}
+			}
+			if (b->num_steps[l]==0) {
+				if ((ctx->worker==0)&&(status_every>0)&&((next_n-first)%status_every==0))
+					DisplayStatus(next_n-first,num_in_range);
+				FillLane(ctx,b,l,next_n++,last);
+			}
+			if (b->n[l])
+				++active;
+		}
+	} while (active>0);
+
+	free(b);
+}
@@ -0,0 +1,49 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+#define BATCH_LANES 8	/* photons in flight per batch */
+
+/* photon batch in structure-of-arrays form, one lane per photon */
+struct PhotonBatch{
+  double x[BATCH_LANES], y[BATCH_LANES], z[BATCH_LANES];
+  double ux[BATCH_LANES], uy[BATCH_LANES], uz[BATCH_LANES];
+  double w[BATCH_LANES];
+  double s[BATCH_LANES];
+  double sleft[BATCH_LANES];
+  double cum_path_length[BATCH_LANES];
+  double step_len[BATCH_LANES];	/* distance moved by the last step */
+  short curr_layer[BATCH_LANES];
+  int n[BATCH_LANES];	/* photon index, 0=lane empty */
+  int num_steps[BATCH_LANES];
+  struct PhiloxState prng[BATCH_LANES];
+
+  /* per-step scratch, filled before the kernels run */
+  double mut[BATCH_LANES];	/* mua+mus of curr_layer */
+  double g[BATCH_LANES];
+  double zbegin[BATCH_LANES], zend[BATCH_LANES];
+  double rn_step[BATCH_LANES];	/* RN for a new step */
+  double hit[BATCH_LANES];	/* 1.0 where the step hits a layer boundary */
+  double scat[BATCH_LANES];	/* 1.0 where the lane scatters this step */
+  double rn_theta[BATCH_LANES];
+  double rn_psi[BATCH_LANES];
+};
+
+/* vector kernels, one implementation per instruction set */
+struct BatchKernels{
+  const char *name;
+  void (*step)(struct PhotonBatch *);
+  void (*boundary)(struct PhotonBatch *);
+  void (*move)(struct PhotonBatch *);
+  void (*scatter)(struct PhotonBatch *);
+};
+
+int UseBatchEngine(struct SimContext *);
+const struct BatchKernels *SelectBatchKernels(void);
+void RunPhotonRangeBatch(struct SimContext *, int, int);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,525 @@
+/* Native microbenchmarks, the "bench" mode of main().
+*
+*  BenchSimContext() first traces the num_photons of its input once
+*  and reports photons per second. It then times the transport
+*  routines on that context one call at a time: Scatter, SetStepSize,
+*  HitLayer, HitEllip (ellipsoid inputs, do_ellip_layer 3), Fresnel,
+*  CrossUp, CrossDown, Compute_Prob_allvox on recorded photon
+*  histories, NormalizeResults on the raw tallies of the run and
+*  SaveTextResult. Run it on a few canonical inputs before and after
+*  a change to the engine.
+*
+*  A routine is called in runs of ops until BENCH_MIN_SECONDS have
+*  passed. Of BENCH_REPEATS such runs the fastest is reported as
+*  ns/op. Where perf_event_open() is available (Linux) the same run
+*  also counts cycles, instructions and cache misses of the calling
+*  thread, reported per op with the IPC; elsewhere, or when the
+*  kernel does not allow it, these columns are "-".
+*
+*  The routines that move a photon start each call from one of
+*  BENCH_STATES photons in random positions and directions. The
+*  "photon copy" row times that copy alone, to subtract.
+*  NormalizeResults gets the raw tallies back before every call,
+*  outside the timed part. Compute_Prob_allvox replays one of
+*  BENCH_TRACKS histories traced for it, copy included. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "mc_main.h"
+#include "mc_v.h"
+#include "mc_threads.h"
+#include "mc_moment.h"
+#include "mc_bench.h"
+#include "pert.h"
+#include "protos.h"
+
+#define BENCH_MIN_SECONDS 0.2	/* per run */
+#define BENCH_REPEATS 5	/* runs per routine, the fastest counts */
+#define BENCH_STATES 1024	/* photon states to start from, a power of 2 */
+#define BENCH_TRACKS 64	/* photon histories for Compute_Prob_allvox */
+#define BENCH_EVENTS 3	/* cycles, instructions, cache misses */
+
+struct BenchCounters{
+	int fd;	/* group leader, -1 when there are no counters */
+	int fds[BENCH_EVENTS];
+	unsigned long long value[BENCH_EVENTS];	/* read by BenchCount() */
+};
+
+struct Bench{
+	struct SimContext *ctx;
+	struct BenchCounters counters;
+	struct Photon *state;	/* [BENCH_STATES] anywhere in their layer */
+	struct Photon *up;	/* [BENCH_STATES] at the top of their layer, heading up */
+	struct Photon *down;	/* [BENCH_STATES] at the bottom, heading down */
+	double *cosines;	/* [BENCH_STATES] for Fresnel */
+	int next;	/* state of the next call */
+	double *trk;	/* x, y and z of every history point */
+	int trk_first[BENCH_TRACKS],trk_len[BENCH_TRACKS];
+	double *arena;	/* raw tallies of the run */
+	size_t arena_num;
+	struct Output out;
+	double *sum2,tot2[3];	/* raw second moments of the run */
+	volatile double sink;	/* keeps pure routines from being optimized out */
+};
+
+typedef void (*BenchOp)(struct Bench *, long);
+typedef void (*BenchReset)(struct Bench *);
+
+/*****************************************************************/
+static double BenchNow(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER t,f;
+
+	QueryPerformanceCounter(&t);
+	QueryPerformanceFrequency(&f);
+	return (double)t.QuadPart/(double)f.QuadPart;
+#else
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+#endif
+}
+
+/*****************************************************************/
+static void *BenchAlloc(size_t n)
+{
+	void *p=malloc((n>0) ? n : 1);
+
+	if (p==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	return p;
+}
+
+/*****************************************************************/
+/* open the hardware counters of this thread, fd=-1 if there are none */
+static void BenchOpenCounters(struct BenchCounters *bc)
+{
+#ifdef __linux__
+	static const unsigned long long config[BENCH_EVENTS]={
+		PERF_COUNT_HW_CPU_CYCLES,PERF_COUNT_HW_INSTRUCTIONS,PERF_COUNT_HW_CACHE_MISSES};
+	struct perf_event_attr attr;
+	int k;
+
+	bc->fd=-1;
+	for (k=0;k<BENCH_EVENTS;++k) {
+		memset(&attr,0,sizeof(attr));
+		attr.type=PERF_TYPE_HARDWARE;
+		attr.size=sizeof(attr);
+		attr.config=config[k];
+		attr.disabled=(k==0);
+		attr.exclude_kernel=1;
+		attr.exclude_hv=1;
+		attr.read_format=PERF_FORMAT_GROUP;
+		bc->fds[k]=(int)syscall(__NR_perf_event_open,&attr,0,-1,bc->fd,0);
+		if (bc->fds[k]<0) {
+			while (--k>=0)
+				close(bc->fds[k]);
+			bc->fd=-1;
+			return;
+		}
+		if (k==0)
+			bc->fd=bc->fds[0];
+	}
+	ioctl(bc->fd,PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+#else
+	bc->fd=-1;
+#endif
+}
+
+/*****************************************************************/
+static void BenchCloseCounters(struct BenchCounters *bc)
+{
+#ifdef __linux__
+	int k;
+
+	for (k=0;(bc->fd>=0)&&(k<BENCH_EVENTS);++k)
+		close(bc->fds[k]);
+#endif
+	bc->fd=-1;
+}
+
+/*****************************************************************/
+/* current counts into bc->value */
+static void BenchCount(struct BenchCounters *bc)
+{
+#ifdef __linux__
+	unsigned long long buf[1+BENCH_EVENTS];
+	int k;
+
+	if ((bc->fd>=0)&&(read(bc->fd,buf,sizeof(buf))==(ssize_t)sizeof(buf)))
+		for (k=0;k<BENCH_EVENTS;++k)
+			bc->value[k]=buf[1+k];
+#endif
+}
+
+/*****************************************************************/
+/* one line of results; count[] are totals over ops, NULL for none */
+static void BenchReport(const char *name, double seconds, double ops,
+	const unsigned long long *count)
+{
+	printf("%-24s %12.1f ns/op",name,1e9*seconds/ops);
+	if (count!=NULL)
+		printf(" %10.1f cycles/op %6.2f IPC %10.3f misses/op\n",count[0]/ops,
+			(count[0]>0) ? (double)count[1]/count[0] : 0.0,count[2]/ops);
+	else
+		printf(" %10s cycles/op %6s IPC %10s misses/op\n","-","-","-");
+}
+
+/*****************************************************************/
+/* time op: batch ops per call after an untimed reset, if any */
+static void BenchRun(struct Bench *b, const char *name, BenchOp op, BenchReset reset, long batch)
+{
+	struct BenchCounters *bc=&b->counters;
+	unsigned long long start[BENCH_EVENTS],count[BENCH_EVENTS],best_count[BENCH_EVENTS];
+	double t0,seconds,best=0.0,best_ops=1.0;
+	long ops;
+	int rep,k;
+
+	for (rep=0;rep<BENCH_REPEATS;++rep) {
+		seconds=0.0;
+		ops=0;
+		memset(count,0,sizeof(count));
+		while (seconds<BENCH_MIN_SECONDS) {
+			if (reset!=NULL)
+				reset(b);
+			BenchCount(bc);
+			memcpy(start,bc->value,sizeof(start));
+			t0=BenchNow();
+			op(b,batch);
+			seconds+=BenchNow()-t0;
+			BenchCount(bc);
+			for (k=0;k<BENCH_EVENTS;++k)
+				count[k]+=bc->value[k]-start[k];
+			ops+=batch;
+		}
+		if ((rep==0)||(seconds/ops<best/best_ops)) {
+			best=seconds;
+			best_ops=(double)ops;
+			memcpy(best_count,count,sizeof(count));
+		}
+	}
+	BenchReport(name,best,best_ops,(bc->fd>=0) ? best_count : NULL);
+}
+
+/*****************************************************************/
+/* the tissue layer of state k */
+static short BenchLayer(struct SimContext *ctx, int k)
+{
+	/* ellipsoids, inclusions and voxels sit in one slab, layer 1 */
+	if (ctx->tissptr->do_ellip_layer>=3)
+		return 1;
+	return (short)(1+k%ctx->tissptr->num_layers);
+}
+
+/*****************************************************************/
+/* photons at random in the tallied volume of their layer */
+static void BenchSetupStates(struct Bench *b)
+{
+	struct SimContext *ctx=b->ctx;
+	struct Photon *ph=ctx->photptr;
+	struct Layer *lp;
+	double rmax=ctx->detector->nr*ctx->detector->dr;
+	double zmax=ctx->detector->nz*ctx->detector->dz;
+	double zlo,zhi,uz,sint,phi;
+	int k;
+
+	b->state=(struct Photon *)BenchAlloc(3*BENCH_STATES*sizeof(struct Photon));
+	b->up=b->state+BENCH_STATES;
+	b->down=b->up+BENCH_STATES;
+	b->cosines=(double *)BenchAlloc(BENCH_STATES*sizeof(double));
+	SeedPhotonStream(ctx,ctx->source->num_photons+1);
+	for (k=0;k<BENCH_STATES;++k) {
+		ph->curr_layer=BenchLayer(ctx,k);
+		lp=&ctx->tissptr->layerprops[ph->curr_layer];
+		zlo=lp->zbegin;
+		zhi=((lp->zend>zmax)&&(zmax>zlo)) ? zmax : lp->zend;
+		uz=2.0*RandomNum(ctx)-1.0;
+		sint=sqrt(1.0-uz*uz);
+		phi=2.0*PI*RandomNum(ctx);
+		ph->ux=sint*cos(phi);
+		ph->uy=sint*sin(phi);
+		ph->uz=uz;
+		ph->x=rmax*(2.0*RandomNum(ctx)-1.0);
+		ph->y=rmax*(2.0*RandomNum(ctx)-1.0);
+		ph->z=zlo+(zhi-zlo)*RandomNum(ctx);
+		if ((ctx->tissptr->do_ellip_layer==3)&&(InEllipsoid(ctx,ph->x,ph->y,ph->z)==1))
+			ph->curr_layer=2;
+		ph->w=1.0-ph->Rspec;
+		ph->dead=0;
+		ph->hit_bdry=0;
+		ph->sleft=0.0;
+		SetStepSize(ctx);
+		ph->sleft=0.0;
+		b->state[k]=*ph;
+		/* on the boundary it is heading for */
+		ph->curr_layer=BenchLayer(ctx,k);
+		ph->uz=-fabs(uz);
+		ph->z=lp->zbegin;
+		b->up[k]=*ph;
+		ph->uz=fabs(uz);
+		ph->z=lp->zend;
+		b->down[k]=*ph;
+		b->cosines[k]=RandomNum(ctx);
+	}
+	b->next=0;
+}
+
+/*****************************************************************/
+/* record the histories of BENCH_TRACKS photons past the run's */
+static void BenchSetupTracks(struct Bench *b)
+{
+	struct SimContext *ctx=b->ctx;
+	struct History *h=ctx->histptr;
+	int allvox=ctx->flagptr->Allvox;
+	int n=ctx->source->num_photons+BENCH_STATES+1;
+	int k,i,num=0;
+
+	ctx->flagptr->Allvox=ALLVOX_HISTORY;
+	if (h->xh==NULL)
+		AllocHistory(h);
+	b->trk=NULL;
+	for (k=0;k<BENCH_TRACKS;++k) {
+		RunPhotonRange(ctx,n+k,n+k);
+		b->trk=(double *)realloc(b->trk,3*(num+h->num_pts_stored)*sizeof(double));
+		if (b->trk==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		b->trk_first[k]=num;
+		b->trk_len[k]=h->num_pts_stored;
+		for (i=0;i<h->num_pts_stored;++i,++num) {
+			b->trk[3*num]=h->xh[i];
+			b->trk[3*num+1]=h->yh[i];
+			b->trk[3*num+2]=h->zh[i];
+		}
+	}
+	ctx->flagptr->Allvox=allvox;
+}
+
+/*****************************************************************/
+/* keep the raw tallies of the run */
+static void BenchSaveTallies(struct Bench *b)
+{
+	struct SimContext *ctx=b->ctx;
+	double *arena=TallyArenaSpan(ctx,&b->arena_num);
+
+	b->arena=(double *)BenchAlloc(b->arena_num*sizeof(double));
+	memcpy(b->arena,arena,b->arena_num*sizeof(double));
+	b->out=*ctx->outptr;
+	b->sum2=NULL;
+	if (ctx->moments.on) {
+		b->sum2=(double *)BenchAlloc(ctx->moments.num_slots*sizeof(double));
+		memcpy(b->sum2,ctx->moments.sum2,ctx->moments.num_slots*sizeof(double));
+		memcpy(b->tot2,ctx->moments.tot2,sizeof(b->tot2));
+	}
+}
+
+/*****************************************************************/
+static void BenchRestoreTallies(struct Bench *b)
+{
+	struct SimContext *ctx=b->ctx;
+	size_t num;
+
+	memcpy(TallyArenaSpan(ctx,&num),b->arena,b->arena_num*sizeof(double));
+	*ctx->outptr=b->out;
+	if (ctx->moments.on) {
+		memcpy(ctx->moments.sum2,b->sum2,ctx->moments.num_slots*sizeof(double));
+		memcpy(ctx->moments.tot2,b->tot2,sizeof(b->tot2));
+	}
+}
+
+/*****************************************************************/
+/* the routines, n calls each */
+#define BENCH_NEXT(b) ((b)->next=((b)->next+1)&(BENCH_STATES-1))
+
+static void BenchCopy(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->state[b->next];
+		BENCH_NEXT(b);
+	}
+}
+
+static void BenchScatter(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->state[b->next];
+		BENCH_NEXT(b);
+		Scatter(b->ctx);
+	}
+}
+
+static void BenchSetStepSize(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->state[b->next];
+		BENCH_NEXT(b);
+		SetStepSize(b->ctx);
+	}
+}
+
+static void BenchHitLayer(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->state[b->next];
+		BENCH_NEXT(b);
+		HitLayer(b->ctx);
+	}
+}
+
+static void BenchHitEllip(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->state[b->next];
+		BENCH_NEXT(b);
+		HitEllip(b->ctx);
+	}
+}
+
+static void BenchFresnel(struct Bench *b, long n)
+{
+	struct Layer *lp=b->ctx->tissptr->layerprops;
+	double uz_snell,r=0.0;
+
+	/* leaving the top layer, below and above the critical angle */
+	for (;n>0;--n) {
+		r+=Fresnel(lp[1].n,lp[0].n,b->cosines[b->next],&uz_snell);
+		BENCH_NEXT(b);
+	}
+	b->sink=r;
+}
+
+static void BenchCrossUp(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->up[b->next];
+		BENCH_NEXT(b);
+		CrossUp(b->ctx);
+	}
+}
+
+static void BenchCrossDown(struct Bench *b, long n)
+{
+	for (;n>0;--n) {
+		*b->ctx->photptr=b->down[b->next];
+		BENCH_NEXT(b);
+		CrossDown(b->ctx);
+	}
+}
+
+static void BenchAllvox(struct Bench *b, long n)
+{
+	struct History *h=b->ctx->histptr;
+	double *xh=h->xh,*yh=h->yh,*zh=h->zh;
+	int k,i,first;
+
+	for (;n>0;--n) {
+		k=b->next%BENCH_TRACKS;
+		BENCH_NEXT(b);
+		first=b->trk_first[k];
+		for (i=0;i<b->trk_len[k];++i) {
+			xh[i]=b->trk[3*(first+i)];
+			yh[i]=b->trk[3*(first+i)+1];
+			zh[i]=b->trk[3*(first+i)+2];
+		}
+		h->num_pts_stored=b->trk_len[k];
+		Compute_Prob_allvox(b->ctx);
+	}
+}
+
+static void BenchNormalize(struct Bench *b, long n)
+{
+	for (;n>0;--n)
+		NormalizeResults(b->ctx);
+}
+
+static void BenchSaveText(struct Bench *b, long n)
+{
+	for (;n>0;--n)
+		SaveTextResult(b->ctx);
+}
+
+/*****************************************************************/
+/* normalized tallies for SaveTextResult */
+static void BenchNormalized(struct Bench *b)
+{
+	BenchRestoreTallies(b);
+	NormalizeResults(b->ctx);
+}
+
+/*****************************************************************/
+/* trace and time ctx, which is set up but not run, and time its */
+/* routines; name is for the report. The output file is written  */
+/* from the run, the tallies in ctx are spent afterwards.         */
+__declspec(dllexport) void BenchSimContext(struct SimContext *ctx, const char *name)
+{
+	struct Bench b;
+	unsigned long long count[BENCH_EVENTS];
+	double t0,seconds;
+	int num_threads=NumWorkerThreads(ctx);
+	int k,num_pts=0;
+
+	memset(&b,0,sizeof(b));
+	b.ctx=ctx;
+	BenchOpenCounters(&b.counters);
+
+	/* end to end; the counters only see this thread */
+	BenchCount(&b.counters);
+	memcpy(count,b.counters.value,sizeof(count));
+	t0=BenchNow();
+	RunMCLoop(ctx);
+	seconds=BenchNow()-t0;
+	BenchCount(&b.counters);
+	for (k=0;k<BENCH_EVENTS;++k)
+		count[k]=b.counters.value[k]-count[k];
+	printf("\nbench %s: %d photons on %d threads, %.0f photons/s\n",
+		name,ctx->source->num_photons,num_threads,ctx->source->num_photons/seconds);
+	BenchReport("photon (end to end)",seconds,ctx->source->num_photons,
+		((b.counters.fd>=0)&&(num_threads==1)) ? count : NULL);
+
+	BenchSaveTallies(&b);
+	BenchRun(&b,"NormalizeResults",BenchNormalize,BenchRestoreTallies,1);
+	BenchNormalized(&b);
+	BenchRun(&b,"SaveTextResult",BenchSaveText,NULL,1);
+
+	BenchSetupStates(&b);
+	BenchRun(&b,"photon copy",BenchCopy,NULL,1000);
+	BenchRun(&b,"Scatter",BenchScatter,NULL,1000);
+	BenchRun(&b,"SetStepSize",BenchSetStepSize,NULL,1000);
+	BenchRun(&b,"HitLayer",BenchHitLayer,NULL,1000);
+	if (ctx->tissptr->do_ellip_layer==3)
+		BenchRun(&b,"HitEllip",BenchHitEllip,NULL,1000);
+	else
+		printf("%-24s (no ellipsoid in this input)\n","HitEllip");
+	BenchRun(&b,"Fresnel",BenchFresnel,NULL,1000);
+	BenchRun(&b,"CrossUp",BenchCrossUp,NULL,1000);
+	BenchRun(&b,"CrossDown",BenchCrossDown,NULL,1000);
+	BenchSetupTracks(&b);
+	for (k=0;k<BENCH_TRACKS;++k)
+		num_pts+=b.trk_len[k];
+	BenchRun(&b,"Compute_Prob_allvox",BenchAllvox,NULL,1);
+	printf("%-24s %12.1f points/photon\n","",(double)num_pts/BENCH_TRACKS);
+
+	BenchCloseCounters(&b.counters);
+	free(b.state);
+	free(b.cosines);
+	free(b.trk);
+	free(b.arena);
+	free(b.sum2);
+}
@@ -0,0 +1,415 @@
+/* Checkpoint and resume, the "checkpoint" and "resume" input lines,
+*  and the raw output that MergeSimContext() (mc_merge.c) sums.
+*
+*  A checkpoint holds everything NormalizeResults starts from: the raw
+*  tallies, the second-moment sums, the perturbation counters, the
+*  batch sums of a convergence run, the ran3 state, the seed and the
+*  number of photons in them. It is written every `every` photons and
+*  once more at the end of the run, to <file>.tmp first and then
+*  renamed, so a run killed while writing one keeps the one before.
+*
+*  "resume <file>" loads a checkpoint before tracing and the run only
+*  traces photons done+1..num_photons: the rest of a run that died,
+*  or more photons for a finished run when num_photons is raised.
+*  Philox streams are per photon, so these get the numbers they would
+*  have had in one long run. ran3 has one stream, which is only
+*  checkpointed for a serial run without batches.
+*
+*  The final checkpoint of a run is also its raw output: runs of one
+*  input with different "seed" lines are independent shards, and
+*  AddCheckpoint() adds the tallies and sums of one to ctx's, so any
+*  number of them can be normalized once as one run.
+*
+*  The file is a sequence of blocks, an 8 character tag, the byte
+*  count as an unsigned 64 bit integer and the bytes, in the byte
+*  order of the machine. Loading checks each tag and size against the
+*  tallies of this input. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mc_main.h"
+#include "mc_v.h"
+#include "mc_white.h"
+#include "mc_detect.h"
+#include "mc_conv.h"
+#include "mc_ckpt.h"
+#include "pert.h"
+
+#define CKPT_TAG 8
+
+#define CKPT_WRITE 0	/* save the tallies */
+#define CKPT_READ 1	/* load them in place of ctx's */
+#define CKPT_ADD 2	/* add them to ctx's */
+
+struct CkptIO{
+	FILE *file;
+	const char *name;
+	int mode;
+};
+
+/*****************************************************************/
+static struct Checkpoint *CheckpointOf(struct SimContext *ctx)
+{
+	if (ctx->ckpt==NULL) {
+		ctx->ckpt=(struct Checkpoint *)calloc(1,sizeof(struct Checkpoint));
+		if (ctx->ckpt==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+	}
+	return ctx->ckpt;
+}
+
+/*****************************************************************/
+/* write to file every photons (0: only at the end of the run) */
+void SetCheckpoint(struct SimContext *ctx, const char *file, int every)
+{
+	struct Checkpoint *ck=CheckpointOf(ctx);
+
+	strncpy(ck->file,file,sizeof(ck->file)-1);
+	ck->every=every;
+}
+
+/*****************************************************************/
+void SetResume(struct SimContext *ctx, const char *file)
+{
+	struct Checkpoint *ck=CheckpointOf(ctx);
+
+	strncpy(ck->resume,file,sizeof(ck->resume)-1);
+}
+
+/*****************************************************************/
+void FreeCheckpoint(struct SimContext *ctx)
+{
+	free(ctx->ckpt);
+	ctx->ckpt=NULL;
+}
+
+/*****************************************************************/
+/* write n bytes at p, or check the tag and size of the next block */
+/* and read it into p. optional blocks that do not match are       */
+/* skipped and 0 returned.                                         */
+static int CkptBlock(struct CkptIO *io, const char *tag, void *p, size_t n, int optional)
+{
+	char t[CKPT_TAG];
+	unsigned long long bytes=n;
+
+	if (io->mode==CKPT_WRITE) {
+		memset(t,0,CKPT_TAG);
+		memcpy(t,tag,strlen(tag));	/* tags are shorter than CKPT_TAG */
+		if ((fwrite(t,1,CKPT_TAG,io->file)!=CKPT_TAG)||
+			(fwrite(&bytes,sizeof(bytes),1,io->file)!=1)||
+			((n>0)&&(fwrite(p,1,n,io->file)!=n))) {
+			printf("\nERROR - could not write checkpoint %s\n",io->name);
+			exit(0);
+		}
+		return 1;
+	}
+	if ((fread(t,1,CKPT_TAG,io->file)!=CKPT_TAG)||
+		(fread(&bytes,sizeof(bytes),1,io->file)!=1)||
+		(strncmp(t,tag,CKPT_TAG)!=0)) {
+		printf("\nERROR - %s is not a checkpoint of this version, expected block %s\n",io->name,tag);
+		exit(0);
+	}
+	if (bytes!=n) {
+		if (optional) {
+			fseek(io->file,(long)bytes,SEEK_CUR);
+			return 0;
+		}
+		printf("\nERROR - checkpoint %s: %s has %llu bytes, this input %lu\n",
+			io->name,tag,bytes,(unsigned long)n);
+		exit(0);
+	}
+	if ((n>0)&&(fread(p,1,n,io->file)!=n)) {
+		printf("\nERROR - checkpoint %s is cut short in block %s\n",io->name,tag);
+		exit(0);
+	}
+	return 1;
+}
+
+/*****************************************************************/
+/* scratch space for a block that is added, not read in place */
+static void *CkptScratch(size_t n)
+{
+	void *p=malloc((n>0) ? n : 1);
+
+	if (p==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	return p;
+}
+
+/*****************************************************************/
+/* a block of sums: written, read or added to p */
+static void CkptDoubles(struct CkptIO *io, const char *tag, double *p, size_t n)
+{
+	double *add;
+	size_t i;
+
+	if (io->mode!=CKPT_ADD) {
+		CkptBlock(io,tag,p,n*sizeof(double),0);
+		return;
+	}
+	add=(double *)CkptScratch(n*sizeof(double));
+	CkptBlock(io,tag,add,n*sizeof(double),0);
+	for (i=0;i<n;++i)
+		p[i]+=add[i];
+	free(add);
+}
+
+/*****************************************************************/
+/* a block of counts: written, read or added to p */
+static void CkptInts(struct CkptIO *io, const char *tag, int *p, size_t n)
+{
+	int *add;
+	size_t i;
+
+	if (io->mode!=CKPT_ADD) {
+		CkptBlock(io,tag,p,n*sizeof(int),0);
+		return;
+	}
+	add=(int *)CkptScratch(n*sizeof(int));
+	CkptBlock(io,tag,add,n*sizeof(int),0);
+	for (i=0;i<n;++i)
+		p[i]+=add[i];
+	free(add);
+}
+
+/*****************************************************************/
+/* a tally matrix, rows and their padding in one block */
+static void CkptMatrix(struct CkptIO *io, const char *tag, double **m)
+{
+	struct MatrixInfo *info=MatrixInfoOf(m,0);
+
+	CkptDoubles(io,tag,info->data,(size_t)info->rows*info->stride);
+}
+
+/*****************************************************************/
+/* every block of a checkpoint, in file order */
+static void CkptBlocks(struct SimContext *ctx, struct CkptIO *io, int *photons, int *rng_type, int *seed)
+{
+	struct Output *out=ctx->outptr;
+	struct perturb *pp=ctx->pertptr;
+	struct WhiteMC *wh=ctx->whiteptr;
+	struct ConvStop *cs=ctx->conv;
+	int nl=ctx->tissptr->num_layers+2;
+	int head[4],pert[5],banana=0,num_sets,k,i;
+	struct Ran3State rng=ctx->rng;
+	short nr=ctx->detector->nr;
+	double wt[3],*conv=NULL;
+	size_t n,num_conv=0;
+
+	head[0]=CKPT_VERSION;
+	head[1]=*photons;
+	head[2]=*rng_type;
+	head[3]=*seed;
+	CkptBlock(io,"vtsckpt",head,sizeof(head),0);
+	if (head[0]!=CKPT_VERSION) {
+		printf("\nERROR - checkpoint %s is version %d, this is %d\n",io->name,head[0],CKPT_VERSION);
+		exit(0);
+	}
+	*photons=head[1];
+	*rng_type=head[2];
+	*seed=head[3];
+	CkptBlock(io,"ran3",&rng,sizeof(rng),0);
+	if ((io->mode==CKPT_READ)&&(*rng_type==RNG_RAN3)&&(ctx->flagptr->RngType==RNG_RAN3))
+		ctx->rng=rng;
+
+	/* the raw tallies; the ones NormalizeResults derives are left out */
+	CkptMatrix(io,"A_rz",out->A_rz);
+	CkptDoubles(io,"A_layer",out->A_layer,nl);
+	CkptMatrix(io,"R_ra",out->R_ra);
+	CkptDoubles(io,"R_r",out->R_r,nr);
+	CkptDoubles(io,"R_r2",out->R_r2,nr);
+	CkptMatrix(io,"R_rt",out->R_rt);
+	if (out->nomega>0) {
+		CkptMatrix(io,"re_rw",out->re_rw);
+		CkptMatrix(io,"im_rw",out->im_rw);
+	}
+	CkptDoubles(io,"R_fx_re",ctx->R_fx_re,ctx->nfx);
+	CkptDoubles(io,"R_fx_im",ctx->R_fx_im,ctx->nfx);
+	CkptMatrix(io,"T_ra",out->T_ra);
+	CkptMatrix(io,"R_xy",out->R_xy);
+	wt[0]=out->wt_pathlen_out_top;
+	wt[1]=out->wt_pathlen_out_bot;
+	wt[2]=out->wt_pathlen_out_sides;
+	CkptDoubles(io,"pathlen",wt,3);
+	out->wt_pathlen_out_top=wt[0];
+	out->wt_pathlen_out_bot=wt[1];
+	out->wt_pathlen_out_sides=wt[2];
+
+	pert[0]=pp->tot_phot;
+	pert[1]=pp->tot_rouletted;
+	pert[2]=pp->tot_out_top;
+	pert[3]=pp->tot_out_bot;
+	pert[4]=pp->col_hit_bdry;
+	CkptInts(io,"pert",pert,5);
+	pp->tot_phot=pert[0];
+	pp->tot_rouletted=pert[1];
+	pp->tot_out_top=pert[2];
+	pp->tot_out_bot=pert[3];
+	pp->col_hit_bdry=pert[4];
+	CkptInts(io,"col",pp->col_in_layer,nl);
+	CkptDoubles(io,"path",pp->pathlen_in_layer,nl);
+
+	n=(ctx->bananaptr!=NULL) ? ctx->bananaptr->num_tally : 0;
+	CkptDoubles(io,"allvox",out->in_side_allvox,n);
+	if (ctx->bananaptr!=NULL)
+		banana=ctx->bananaptr->banana_photons;
+	CkptInts(io,"banana",&banana,1);
+	if (ctx->bananaptr!=NULL)
+		ctx->bananaptr->banana_photons=banana;
+
+	n=(ctx->detptr!=NULL) ? ctx->detptr->num : 0;
+	CkptDoubles(io,"det",ctx->det_wt,n);
+	CkptDoubles(io,"written",ctx->photptr->num_photons_written,DetectorSlots(ctx));
+
+	n=ctx->moments.on ? ctx->moments.num_slots : 0;
+	CkptDoubles(io,"momsum",ctx->moments.sum2,n);
+	CkptDoubles(io,"momtot",ctx->moments.tot2,ctx->moments.on ? 3 : 0);
+
+	num_sets=(wh!=NULL) ? wh->num_sets : 0;
+	k=num_sets;
+	CkptBlock(io,"white",&k,sizeof(int),0);
+	if (k!=num_sets) {
+		printf("\nERROR - checkpoint %s has %d white MC sets, this input %d\n",io->name,k,num_sets);
+		exit(0);
+	}
+	for (k=0;k<num_sets;++k) {
+		CkptDoubles(io,"whiteRd",&wh->Rd[k],1);
+		CkptDoubles(io,"whiteTd",&wh->Td[k],1);
+		CkptDoubles(io,"whiteRr",wh->R_r[k],nr);
+		for (i=0;i<nr;++i)
+			CkptDoubles(io,"whiteRt",wh->R_rt[k][i],ctx->detector->nt);
+	}
+	for (i=0;(wh!=NULL)&&(i<nl);++i)
+		CkptDoubles(io,"whiteA",wh->A_layer[i],num_sets);
+
+	/* batch count and sums of a convergence run; when the run now */
+	/* watches other tallies they start over. the batches of       */
+	/* shards that are added do not make up one run's batches.     */
+	if ((cs!=NULL)&&(cs->last!=NULL)) {
+		num_conv=1+3*cs->num_tally;
+		conv=(double *)malloc(num_conv*sizeof(double));
+		if (conv==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		conv[0]=cs->num_batches;
+		memcpy(conv+1,cs->last,3*cs->num_tally*sizeof(double));
+	}
+	if (CkptBlock(io,"conv",conv,num_conv*sizeof(double),1)&&(io->mode==CKPT_READ)&&(conv!=NULL)) {
+		cs->num_batches=(int)conv[0];
+		memcpy(cs->last,conv+1,3*cs->num_tally*sizeof(double));
+	}
+	free(conv);
+}
+
+/*****************************************************************/
+/* the tallies hold photons 1..photons */
+void SaveCheckpoint(struct SimContext *ctx, int photons)
+{
+	struct Checkpoint *ck=ctx->ckpt;
+	struct CkptIO io;
+	char tmp_name[270];
+	int rng_type=ctx->flagptr->RngType,seed=ctx->flagptr->Seed;
+
+	if ((ck==NULL)||(ck->file[0]==0)||(ck->saved==photons))
+		return;
+	sprintf(tmp_name,"%s.tmp",ck->file);
+	io.name=tmp_name;
+	io.mode=CKPT_WRITE;
+	io.file=fopen(tmp_name,"wb");
+	if (io.file==NULL) {
+		printf("\nERROR - could not open checkpoint %s\n",tmp_name);
+		exit(0);
+	}
+	CkptBlocks(ctx,&io,&photons,&rng_type,&seed);
+	if (fclose(io.file)!=0) {
+		printf("\nERROR - could not write checkpoint %s\n",tmp_name);
+		exit(0);
+	}
+	remove(ck->file);	/* rename() does not replace on Windows */
+	if (rename(tmp_name,ck->file)!=0) {
+		printf("\nERROR - could not rename %s to %s\n",tmp_name,ck->file);
+		exit(0);
+	}
+	ck->saved=photons;
+	printf("checkpoint: %d photons in %s\n",photons,ck->file);
+}
+
+/*****************************************************************/
+/* the tallies hold photons 1..done: save them if it is time */
+void CheckpointIfDue(struct SimContext *ctx, int done)
+{
+	struct Checkpoint *ck=ctx->ckpt;
+
+	if ((ck==NULL)||(ck->every<=0)||(done<ck->next_at))
+		return;
+	SaveCheckpoint(ctx,done);
+	ck->next_at=(done/ck->every+1)*ck->every;
+}
+
+/*****************************************************************/
+/* load the resume file into the zeroed tallies and return the    */
+/* photons it holds; call once all tallies are set up             */
+int StartCheckpoints(struct SimContext *ctx, int num_threads)
+{
+	struct Checkpoint *ck=ctx->ckpt;
+	struct CkptIO io;
+	int done=0,rng_type=ctx->flagptr->RngType,seed=ctx->flagptr->Seed;
+
+	if ((ctx->flagptr->RngType==RNG_RAN3)&&((num_threads>1)||(ctx->conv!=NULL))) {
+		printf("\nERROR - checkpoints of ran3 runs need one thread and no stop line, or use Philox\n");
+		exit(0);
+	}
+	if (ck->resume[0]!=0) {
+		io.name=ck->resume;
+		io.mode=CKPT_READ;
+		io.file=fopen(ck->resume,"rb");
+		if (io.file==NULL) {
+			printf("\nERROR - could not open checkpoint %s\n",ck->resume);
+			exit(0);
+		}
+		CkptBlocks(ctx,&io,&done,&rng_type,&seed);
+		fclose(io.file);
+		if (rng_type!=ctx->flagptr->RngType) {
+			printf("\nERROR - checkpoint %s is of rng %s, this run has rng %s\n",ck->resume,
+				(rng_type==RNG_PHILOX)?"philox":"ran3",(ctx->flagptr->RngType==RNG_PHILOX)?"philox":"ran3");
+			exit(0);
+		}
+		if ((rng_type==RNG_PHILOX)&&(seed!=ctx->flagptr->Seed)) {
+			printf("\nERROR - checkpoint %s is of seed %d, this run has seed %d\n",
+				ck->resume,seed,ctx->flagptr->Seed);
+			exit(0);
+		}
+		printf("resuming from %s: %d photons\n",ck->resume,done);
+	}
+	ck->saved=-1;
+	if (ck->every>0)
+		ck->next_at=(done/ck->every+1)*ck->every;
+	return done;
+}
+
+/*****************************************************************/
+/* add the tallies of checkpoint file to ctx's, which must be set */
+/* up for the same input; returns the photons in it and its       */
+/* generator and seed                                             */
+int AddCheckpoint(struct SimContext *ctx, const char *file, int *rng_type, int *seed)
+{
+	struct CkptIO io;
+	int photons=0;
+
+	io.name=file;
+	io.mode=CKPT_ADD;
+	io.file=fopen(file,"rb");
+	if (io.file==NULL) {
+		printf("\nERROR - could not open checkpoint %s\n",file);
+		exit(0);
+	}
+	CkptBlocks(ctx,&io,&photons,rng_type,seed);
+	fclose(io.file);
+	return photons;
+}
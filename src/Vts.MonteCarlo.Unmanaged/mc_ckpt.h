@@ -0,0 +1,28 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+#define CKPT_VERSION 2
+
+  /* checkpoints of the raw tallies, see mc_ckpt.c */
+  struct Checkpoint{
+    char file[256];	/* written while tracing and at the end, "" for none */
+    int every;	/* photons between checkpoints, 0=only at the end */
+    int next_at;	/* photon count due for the next one */
+    int saved;	/* photons in the last one written */
+    char resume[256];	/* loaded before tracing, "" for none */
+  };
+
+void SetCheckpoint(struct SimContext *, const char *, int);
+void SetResume(struct SimContext *, const char *);
+void FreeCheckpoint(struct SimContext *);
+int StartCheckpoints(struct SimContext *, int);
+void CheckpointIfDue(struct SimContext *, int);
+void SaveCheckpoint(struct SimContext *, int);
+int AddCheckpoint(struct SimContext *, const char *, int *, int *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,230 @@
+/* Convergence-driven stopping, the "stop" and "conv" input lines.
+*
+*  Photons are traced in batches of batch_photons instead of all
+*  num_photons in one go. After each batch every selected tally, Rd
+*  or R(r) at a chosen bin, gives one batch mean per photon; with K
+*  batches the relative error of the run is
+*      sqrt((K*sum2-sum*sum)/(K-1))/|sum|
+*  The run stops once all selected tallies are at or below the target
+*  after CONV_MIN_BATCHES batches, once the wall-clock budget is used
+*  up, or at num_photons. num_photons is then set to the photons
+*  actually traced, so NormalizeResults and the files written after
+*  it divide by that. A resumed run (mc_ckpt.c) carries on with the
+*  batch sums of its checkpoint; the time budget is per run. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "mc_threads.h"
+#include "mc_conv.h"
+#include "mc_ckpt.h"
+#include "mc_stats.h"
+
+/*****************************************************************/
+static struct ConvStop *ConvStopOf(struct SimContext *ctx)
+{
+	if (ctx->conv==NULL) {
+		ctx->conv=(struct ConvStop *)calloc(1,sizeof(struct ConvStop));
+		if (ctx->conv==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+	}
+	return ctx->conv;
+}
+
+/*****************************************************************/
+/* target relative error (0=none), budget in s (0=none), photons */
+/* per batch (0=default)                                         */
+void SetConvStop(struct SimContext *ctx, double target, double max_seconds, int batch_photons)
+{
+	struct ConvStop *cs=ConvStopOf(ctx);
+
+	cs->target=target;
+	cs->max_seconds=max_seconds;
+	cs->batch_photons=batch_photons;
+}
+
+/*****************************************************************/
+/* watch CONV_RD or R_r bin ir */
+void AddConvTally(struct SimContext *ctx, int tally)
+{
+	struct ConvStop *cs=ConvStopOf(ctx);
+
+	cs->tally=(int *)realloc(cs->tally,(cs->num_tally+1)*sizeof(int));
+	if (cs->tally==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	cs->tally[cs->num_tally++]=tally;
+}
+
+/*****************************************************************/
+void FreeConvStop(struct SimContext *ctx)
+{
+	if (ctx->conv==NULL)
+		return;
+	free(ctx->conv->tally);
+	free(ctx->conv->last);
+	free(ctx->conv);
+	ctx->conv=NULL;
+}
+
+/*****************************************************************/
+/* unnormalized tally so far; R_r is summed while tracing */
+static double ConvRawSum(struct SimContext *ctx, int tally)
+{
+	double s=0.0;
+	short ir;
+
+	if (tally!=CONV_RD)
+		return ctx->outptr->R_r[tally];
+	for (ir=0;ir<ctx->detector->nr;ir++)
+		s+=ctx->outptr->R_r[ir];
+	return s;
+}
+
+/*****************************************************************/
+/* batch-means relative error of tally k, 1 while it is still 0 */
+static double ConvRelErr(const struct ConvStop *cs, int k)
+{
+	double s=cs->sum[k],s2=cs->sum2[k],v;
+	int K=cs->num_batches;
+
+	if ((K<2)||(s==0.0))
+		return 1.0;
+	v=(K*s2-s*s)/(K-1);
+	return (v>0.0) ? sqrt(v)/fabs(s) : 0.0;
+}
+
+/*****************************************************************/
+static double ConvMaxRelErr(const struct ConvStop *cs)
+{
+	double e,emax=0.0;
+	int k;
+
+	for (k=0;k<cs->num_tally;++k) {
+		e=ConvRelErr(cs,k);
+		if (e>emax)
+			emax=e;
+	}
+	return emax;
+}
+
+/*****************************************************************/
+/* a batch of num photons is in ctx's tallies */
+static void ConvAddBatch(struct SimContext *ctx, int num)
+{
+	struct ConvStop *cs=ctx->conv;
+	double raw,x;
+	int k;
+
+	for (k=0;k<cs->num_tally;++k) {
+		raw=ConvRawSum(ctx,cs->tally[k]);
+		x=(raw-cs->last[k])/num;
+		cs->last[k]=raw;
+		cs->sum[k]+=x;
+		cs->sum2[k]+=x*x;
+	}
+	cs->num_batches++;
+}
+
+/*****************************************************************/
+/* check the tallies and clear the batch sums; before a checkpoint */
+/* is loaded, which may restore them                               */
+void SetupConv(struct SimContext *ctx)
+{
+	struct ConvStop *cs=ctx->conv;
+	int k;
+
+	if (cs->num_tally==0)
+		AddConvTally(ctx,CONV_RD);
+	for (k=0;k<cs->num_tally;++k)
+		if ((cs->tally[k]!=CONV_RD)&&((cs->tally[k]<0)||(cs->tally[k]>=ctx->detector->nr))) {
+			printf("\nERROR - conv Rr %d: there are %d radial bins\n",cs->tally[k],ctx->detector->nr);
+			exit(0);
+		}
+	free(cs->last);
+	cs->last=(double *)calloc(3*cs->num_tally,sizeof(double));
+	if (cs->last==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	cs->sum=cs->last+cs->num_tally;
+	cs->sum2=cs->sum+cs->num_tally;
+	cs->num_batches=0;
+}
+
+/*****************************************************************/
+/* the tallies already hold photons 1..done */
+void RunMCLoopConverged(struct SimContext *ctx, int num_threads, int done)
+{
+	struct ConvStop *cs=ctx->conv;
+	struct SimContext **workers;
+	int N=ctx->source->num_photons;
+	int B=cs->batch_photons;
+	int last,k,next_report=1;
+	double start=WallSeconds();
+
+	cs->max_photons=N;
+	if (cs->num_batches==0)	/* batch sums not from a checkpoint */
+		for (k=0;k<cs->num_tally;++k)
+			cs->last[k]=ConvRawSum(ctx,cs->tally[k]);
+	if (B<=0) {
+		B=N/CONV_MIN_BATCHES;
+		if (B>CONV_BATCH_PHOTONS)
+			B=CONV_BATCH_PHOTONS;
+		if (B<1)
+			B=1;
+	}
+
+	printf("running up to %d photons on %d threads in batches of %d\n",N,num_threads,B);
+	workers=StartWorkers(ctx,num_threads);
+	cs->reason="all photons traced";
+	while (done<N) {
+		last=(N-done>B) ? done+B : N;
+		RunChunks(ctx,workers,num_threads,done+1,last,done,0);
+		ConvAddBatch(ctx,last-done);
+		done=last;
+		CheckpointIfDue(ctx,done);
+		cs->seconds=WallSeconds()-start;
+		if (cs->num_batches>=next_report) {
+			printf("batch %d: %d photons, %.1f s, rel. error %.3e\n",
+				cs->num_batches,done,cs->seconds,ConvMaxRelErr(cs));
+			next_report*=2;
+		}
+		if ((cs->target>0.0)&&(cs->num_batches>=CONV_MIN_BATCHES)&&
+			(ConvMaxRelErr(cs)<=cs->target)) {
+			cs->reason="target relative error reached";
+			break;
+		}
+		if ((cs->max_seconds>0.0)&&(cs->seconds>=cs->max_seconds)) {
+			cs->reason="time budget used up";
+			break;
+		}
+	}
+	StopWorkers(workers,num_threads);
+	printf("%d photons in %d batches, %.1f s, rel. error %.3e: %s\n",
+		done,cs->num_batches,cs->seconds,ConvMaxRelErr(cs),cs->reason);
+	ctx->source->num_photons=done;
+}
+
+/*****************************************************************/
+void SaveConvResults(struct SimContext *ctx, FILE *file)
+{
+	struct ConvStop *cs=ctx->conv;
+	int k;
+
+	if ((cs==NULL)||(cs->num_batches==0))
+		return;
+	fprintf(file,"Photons traced        = %d of %d in %d batches, %.1f s (%s)\n",
+		ctx->source->num_photons,cs->max_photons,cs->num_batches,cs->seconds,cs->reason);
+	for (k=0;k<cs->num_tally;++k) {
+		if (cs->tally[k]==CONV_RD)
+			fprintf(file,"Batch rel. error Rd   = %12.4E\n",ConvRelErr(cs,k));
+		else
+			fprintf(file,"Batch rel. error R(r=%.4e) = %12.4E\n",
+				(cs->tally[k]+0.5)*ctx->detector->dr,ConvRelErr(cs,k));
+	}
+}
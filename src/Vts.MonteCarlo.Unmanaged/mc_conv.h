@@ -0,0 +1,39 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include<stdio.h>
+
+struct SimContext;
+
+#define CONV_RD -1	/* tally index of Rd, R_r bins are 0..nr-1 */
+#define CONV_MIN_BATCHES 10	/* batches before the error estimate is trusted */
+#define CONV_BATCH_PHOTONS 10000	/* default batch size */
+
+  /* run in batches until the batch-means relative error of every */
+  /* selected tally is at most target, max_seconds have passed or */
+  /* num_photons are traced                                       */
+  struct ConvStop{
+    double target;	/* relative error to stop at, 0=none */
+    double max_seconds;	/* wall-clock budget, 0=none */
+    int batch_photons;	/* photons per batch, 0=default */
+    int num_tally;
+    int *tally;	/* [num_tally] CONV_RD or an R_r bin */
+    double *last;	/* [num_tally] raw sums after the previous batch */
+    double *sum, *sum2;	/* [num_tally] sums of the batch means and of their squares */
+    int num_batches;
+    int max_photons;	/* num_photons as read */
+    double seconds;	/* wall-clock time of the run */
+    const char *reason;	/* why the run stopped */
+  };
+
+void SetConvStop(struct SimContext *, double, double, int);
+void AddConvTally(struct SimContext *, int);
+void FreeConvStop(struct SimContext *);
+void SetupConv(struct SimContext *);
+void RunMCLoopConverged(struct SimContext *, int, int);
+void SaveConvResults(struct SimContext *, FILE *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
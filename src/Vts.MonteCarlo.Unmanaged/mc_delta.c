@@ -0,0 +1,149 @@
+/* Woodcock (delta) tracking, Flags.Tracking==TRACK_DELTA.
+*
+*  Steps are sampled with the majorant mut_max of all materials and
+*  run straight through index-matched interfaces: layers with equal
+*  n, the ellipsoid, inclusions and voxel material changes. At the
+*  end of a step the material there is looked up and the collision
+*  is real with probability mut/mut_max, otherwise it is virtual and
+*  the photon carries on unchanged. Surfaces where n changes still
+*  stop the step and go through CrossUp/CrossDown for Fresnel.
+*  A track that spans materials is booked to the material at its end
+*  in pathlen_in_layer, so the perturbation tallies need surface
+*  tracking. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "mc_delta.h"
+#include "mc_incl.h"
+#include "mc_voxel.h"
+#include "pert.h"
+#include "protos.h"
+
+#define DELTA_EPS 1e-9	/* cm, step back off a surface to find the material left */
+
+/*****************************************************************/
+/* turn delta tracking on if asked for and possible, find mut_max */
+/* and the Fresnel surfaces around each layer                     */
+void SetupDelta(struct SimContext *ctx)
+{
+	struct DeltaTrack *dt=&ctx->delta;
+	struct Layer *lp=ctx->tissptr->layerprops;
+	int num_layers=ctx->tissptr->num_layers;
+	double ztop=lp[1].zbegin,zbot=lp[num_layers].zend,mut;
+	int i,k;
+
+	FreeDelta(ctx);
+	dt->on=0;
+	if (ctx->flagptr->Tracking!=TRACK_DELTA)
+		return;
+	if ((ctx->flagptr->AbsWtType==ABS_CONTINUOUS)||(ctx->whiteptr!=NULL)) {
+		printf("delta tracking needs analog or discrete absorption weighting and no mua table: using surface tracking\n");
+		return;
+	}
+
+	dt->mut_max=0.0;
+	for (i=1;i<=num_layers;++i) {
+		mut=ctx->layers.mut[i];
+		if (mut>dt->mut_max)
+			dt->mut_max=mut;
+	}
+	if (!(dt->mut_max>0.0)) {
+		printf("\nERROR - delta tracking needs mua+mus>0 in some layer\n");
+		exit(0);
+	}
+	dt->inv_mut_max=1.0/dt->mut_max;
+
+	dt->z_up=(double *)malloc(2*(num_layers+2)*sizeof(double));
+	if (dt->z_up==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	dt->z_down=dt->z_up+num_layers+2;
+	if (ctx->tissptr->do_ellip_layer>=3) {
+		/* materials are index matched, only the tissue surfaces refract */
+		if (ctx->tissptr->do_ellip_layer==5)
+			zbot=ctx->voxptr->zmax;
+		else
+			zbot=lp[1].zend;
+		for (i=0;i<num_layers+2;++i) {
+			dt->z_up[i]=ztop;
+			dt->z_down[i]=zbot;
+		}
+	}
+	else {
+		for (i=1;i<=num_layers;++i) {
+			for (k=i;(k>1)&&(lp[k-1].n==lp[i].n);--k)
+				;
+			dt->z_up[i]=lp[k].zbegin;
+			for (k=i;(k<num_layers)&&(lp[k+1].n==lp[i].n);++k)
+				;
+			dt->z_down[i]=lp[k].zend;
+		}
+	}
+	dt->on=1;
+}
+
+/*****************************************************************/
+void FreeDelta(struct SimContext *ctx)
+{
+	free(ctx->delta.z_up);
+	ctx->delta.z_up=ctx->delta.z_down=NULL;
+	ctx->delta.on=0;
+}
+
+/*****************************************************************/
+/* layerprops index of the material at (x,y,z) */
+short MaterialAt(struct SimContext *ctx, double x, double y, double z)
+{
+	double p[3];
+
+	switch (ctx->tissptr->do_ellip_layer) {
+	case 3:
+		return (InEllipsoid(ctx,x,y,z)==1) ? 2 : 1;
+	case 4:
+		p[0]=x; p[1]=y; p[2]=z;
+		return InclusionLayerAt(ctx,p);
+	case 5:
+		return VoxelMaterialAt(ctx,x,y,z);
+	default:
+		return LayerAt(ctx,z);
+	}
+}
+
+/*****************************************************************/
+/* HitBoundary for delta tracking: returns 1 at a Fresnel surface, */
+/* 0 for a real collision, 5 for a virtual one; curr_layer is set  */
+/* to the material where the step ends                             */
+short HitDelta(struct SimContext *ctx)
+{
+	struct DeltaTrack *dt=&ctx->delta;
+	double s=ctx->photptr->s;
+	double ux=ctx->photptr->ux,uy=ctx->photptr->uy,uz=ctx->photptr->uz;
+	double x=ctx->photptr->x,y=ctx->photptr->y,z=ctx->photptr->z;
+	double dbound=0.0,mut;
+	short layer=ctx->photptr->curr_layer,mat;
+
+	if (uz<0.0)
+		dbound=(dt->z_up[layer]-z)/uz;
+	else if (uz>0.0)
+		dbound=(dt->z_down[layer]-z)/uz;
+	if ((uz!=0.0)&&(s>dbound)) {
+		ctx->photptr->hit_bdry=1;
+		ctx->photptr->sleft=(s-dbound)*dt->mut_max;
+		ctx->photptr->s=dbound;
+		/* CrossUp/CrossDown need the material on this side */
+		dbound-=DELTA_EPS;
+		ctx->photptr->curr_layer=MaterialAt(ctx,x+dbound*ux,y+dbound*uy,z+dbound*uz);
+		return 1;
+	}
+
+	mat=MaterialAt(ctx,x+s*ux,y+s*uy,z+s*uz);
+	ctx->photptr->curr_layer=mat;
+	mut=ctx->layers.mut[mat];
+	if ((mut>=dt->mut_max)||(RandomNum(ctx)*dt->mut_max<mut))
+		return 0;
+	ctx->photptr->hit_bdry=1;	/* no interaction, recorded like a boundary point */
+	return 5;
+}
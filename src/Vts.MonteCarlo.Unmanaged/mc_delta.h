@@ -0,0 +1,14 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+void SetupDelta(struct SimContext *);
+void FreeDelta(struct SimContext *);
+short MaterialAt(struct SimContext *, double, double, double);
+short HitDelta(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
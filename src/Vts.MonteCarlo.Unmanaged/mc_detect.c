@@ -0,0 +1,342 @@
+/* Detectors on the exit surface.
+*
+*  Any number of circles, annuli and rectangles sit on the surface
+*  chosen by detector->reflect_flag (top for reflectance, bottom for
+*  transmittance) and may overlap. The weight leaving through each one
+*  is tallied in det_wt by Reflect() or Transmit(). A uniform grid
+*  over the detectors' bounding boxes, about one cell per detector,
+*  lists the detectors overlapping each cell, so an exit point is
+*  tested only against the few detectors of its cell. The radial
+*  tests compare squared distances. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "mc_detect.h"
+#include "mc_moment.h"
+#include "pert.h"
+
+#define DET_GRID_MAX 1024	/* cells along one axis */
+
+/*****************************************************************/
+static int InDetector(const struct Detector *d, double x, double y)
+{
+	double dx=x-d->x,dy=y-d->y,r2;
+
+	if (d->type==DET_RECT)
+		return (fabs(dx)<=d->a)&&(fabs(dy)<=d->b);
+	r2=dx*dx+dy*dy;
+	return (r2>=d->a2)&&(r2<=d->b2);
+}
+
+/*****************************************************************/
+/* bounding box lo[0],lo[1],hi[0],hi[1] */
+static void DetectorBounds(const struct Detector *d, double *box)
+{
+	double hx=(d->type==DET_RECT)?d->a:d->b;
+
+	box[0]=d->x-hx;
+	box[1]=d->y-d->b;
+	box[2]=d->x+hx;
+	box[3]=d->y+d->b;
+}
+
+/*****************************************************************/
+/* grid cell along one axis, clamped to the grid */
+static int GridIndex(double p, double org, double inv_c, int n)
+{
+	int i=(int)((p-org)*inv_c);
+
+	if (i<0)
+		return 0;
+	if (i>=n)
+		return n-1;
+	return i;
+}
+
+/*****************************************************************/
+/* cell holding (x,y), -1 outside the grid */
+static int CellOf(const struct DetectorSet *ds, double x, double y)
+{
+	if ((x<ds->x0)||(x>ds->x1)||(y<ds->y0)||(y>ds->y1))
+		return -1;
+	return GridIndex(y,ds->y0,ds->inv_cy,ds->gy)*ds->gx+
+		GridIndex(x,ds->x0,ds->inv_cx,ds->gx);
+}
+
+/*****************************************************************/
+/* length of num_photons_written: at least MAX_DET, the database */
+/* files of Write_Photon_To_Disk()                                */
+int DetectorSlots(struct SimContext *ctx)
+{
+	if ((ctx->detptr!=NULL)&&(ctx->detptr->num>MAX_DET))
+		return ctx->detptr->num;
+	return MAX_DET;
+}
+
+/*****************************************************************/
+/* copy and check the detectors, build the grid and size ctx's  */
+/* per-detector tallies; num==0 removes all detectors            */
+void SetDetectors(struct SimContext *ctx, int num, const struct Detector *det)
+{
+	struct DetectorSet *ds;
+	struct Detector *d;
+	double box[4],w,h,cell;
+	int i,ix,iy,ix0,ix1,iy0,iy1,c,num_cells;
+
+	if (ctx->detptr!=NULL)
+		FreeDetectors(ctx->detptr);
+	ctx->detptr=NULL;
+	free(ctx->det_wt);
+	ctx->det_wt=NULL;
+
+	if (num>0) {
+		ds=(struct DetectorSet *)calloc(1,sizeof(struct DetectorSet));
+		if (ds==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		ds->det=(struct Detector *)malloc(num*sizeof(struct Detector));
+		if (ds->det==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		memcpy(ds->det,det,num*sizeof(struct Detector));
+		ds->num=num;
+
+		for (i=0;i<num;++i) {
+			d=&ds->det[i];
+			if (d->type==DET_CIRCLE)
+				d->a=0.0;
+			if (((d->type!=DET_CIRCLE)&&(d->type!=DET_ANNULUS)&&(d->type!=DET_RECT))||
+				!(d->b>0.0)||(d->a<0.0)||((d->type==DET_RECT)?!(d->a>0.0):!(d->a<d->b))) {
+				printf("\nERROR - detector %d: type %d with sizes %g, %g\n",i,d->type,d->a,d->b);
+				exit(0);
+			}
+			d->a2=d->a*d->a;
+			d->b2=d->b*d->b;
+			DetectorBounds(d,box);
+			if ((i==0)||(box[0]<ds->x0)) ds->x0=box[0];
+			if ((i==0)||(box[1]<ds->y0)) ds->y0=box[1];
+			if ((i==0)||(box[2]>ds->x1)) ds->x1=box[2];
+			if ((i==0)||(box[3]>ds->y1)) ds->y1=box[3];
+		}
+
+		/* square cells, about one per detector */
+		w=ds->x1-ds->x0;
+		h=ds->y1-ds->y0;
+		cell=sqrt(w*h/num);
+		ds->gx=(int)ceil(w/cell);
+		ds->gy=(int)ceil(h/cell);
+		if (ds->gx<1) ds->gx=1;
+		if (ds->gx>DET_GRID_MAX) ds->gx=DET_GRID_MAX;
+		if (ds->gy<1) ds->gy=1;
+		if (ds->gy>DET_GRID_MAX) ds->gy=DET_GRID_MAX;
+		ds->inv_cx=ds->gx/w;
+		ds->inv_cy=ds->gy/h;
+		num_cells=ds->gx*ds->gy;
+
+		/* count, prefix sum, fill: the lists come out in detector order */
+		ds->cell_start=(int *)calloc(num_cells+1,sizeof(int));
+		if (ds->cell_start==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		for (i=0;i<num;++i) {
+			DetectorBounds(&ds->det[i],box);
+			ix0=GridIndex(box[0],ds->x0,ds->inv_cx,ds->gx);
+			ix1=GridIndex(box[2],ds->x0,ds->inv_cx,ds->gx);
+			iy0=GridIndex(box[1],ds->y0,ds->inv_cy,ds->gy);
+			iy1=GridIndex(box[3],ds->y0,ds->inv_cy,ds->gy);
+			for (iy=iy0;iy<=iy1;++iy)
+				for (ix=ix0;ix<=ix1;++ix)
+					++ds->cell_start[iy*ds->gx+ix+1];
+		}
+		for (c=0;c<num_cells;++c)
+			ds->cell_start[c+1]+=ds->cell_start[c];
+		ds->cell_det=(int *)malloc(ds->cell_start[num_cells]*sizeof(int));
+		if (ds->cell_det==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		for (i=0;i<num;++i) {
+			DetectorBounds(&ds->det[i],box);
+			ix0=GridIndex(box[0],ds->x0,ds->inv_cx,ds->gx);
+			ix1=GridIndex(box[2],ds->x0,ds->inv_cx,ds->gx);
+			iy0=GridIndex(box[1],ds->y0,ds->inv_cy,ds->gy);
+			iy1=GridIndex(box[3],ds->y0,ds->inv_cy,ds->gy);
+			for (iy=iy0;iy<=iy1;++iy)
+				for (ix=ix0;ix<=ix1;++ix) {
+					c=iy*ds->gx+ix;
+					ds->cell_det[ds->cell_start[c]++]=i;
+				}
+		}
+		/* the fill advanced each start to the next cell's start */
+		for (c=num_cells;c>0;--c)
+			ds->cell_start[c]=ds->cell_start[c-1];
+		ds->cell_start[0]=0;
+
+		ctx->detptr=ds;
+		ctx->det_wt=(double *)calloc(num,sizeof(double));
+		if (ctx->det_wt==NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+	}
+
+	free(ctx->photptr->num_photons_written);
+	ctx->photptr->num_photons_written=(double *)calloc(DetectorSlots(ctx),sizeof(double));
+	if (ctx->photptr->num_photons_written==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+}
+
+/*****************************************************************/
+/* text file, one detector per line, lengths in cm, # comments:  */
+/*   c x y radius                                                 */
+/*   a x y inner_radius outer_radius                              */
+/*   r x y width height                                           */
+/* replaces the detectors of the input file                       */
+__declspec(dllexport) int ReadDetectors(struct SimContext *ctx, char *fname)
+{
+	FILE *file_ptr;
+	struct Detector *det=NULL,*p;
+	char line[512],type;
+	double v[4];
+	int n=0,cap=0,nv,line_num=0;
+
+	file_ptr=fopen(fname,"r");
+	if (file_ptr==NULL) {
+		printf("\nERROR - Could not find or open detector file %s\n",fname);
+		exit(0);
+	}
+	while (fgets(line,sizeof(line),file_ptr)!=NULL) {
+		++line_num;
+		if (sscanf(line," %c",&type)!=1 || type=='#')
+			continue;
+		nv=sscanf(line," %c %lf %lf %lf %lf",&type,&v[0],&v[1],&v[2],&v[3])-1;
+		if (n==cap) {
+			cap=(cap==0)?64:2*cap;
+			det=(struct Detector *)realloc(det,cap*sizeof(struct Detector));
+			if (det==NULL) {
+				printf("Memory allocation error\n");
+				exit(1);
+			}
+		}
+		p=&det[n];
+		memset(p,0,sizeof(struct Detector));
+		p->x=v[0];
+		p->y=v[1];
+		if ((type=='c')&&(nv==3)) {
+			p->type=DET_CIRCLE;
+			p->b=v[2];
+		}
+		else if ((type=='a')&&(nv==4)) {
+			p->type=DET_ANNULUS;
+			p->a=v[2];
+			p->b=v[3];
+		}
+		else if ((type=='r')&&(nv==4)) {
+			p->type=DET_RECT;
+			p->a=v[2]/2.0;
+			p->b=v[3]/2.0;
+		}
+		else {
+			printf("\nERROR - detector file %s line %d: expected c, a or r and its values\n",
+				fname,line_num);
+			exit(0);
+		}
+		++n;
+	}
+	fclose(file_ptr);
+	if (n==0) {
+		printf("\nERROR - detector file %s has no detectors\n",fname);
+		exit(0);
+	}
+	SetDetectors(ctx,n,det);
+	free(det);
+	printf("detectors: %d, %dx%d grid\n",n,ctx->detptr->gx,ctx->detptr->gy);
+	return n;
+}
+
+/*****************************************************************/
+void FreeDetectors(struct DetectorSet *ds)
+{
+	free(ds->det);
+	free(ds->cell_start);
+	free(ds->cell_det);
+	free(ds);
+}
+
+/*****************************************************************/
+/* lowest numbered detector holding (x,y), -1 for none */
+int FindDetector(struct SimContext *ctx, double x, double y)
+{
+	struct DetectorSet *ds=ctx->detptr;
+	int c,k;
+
+	if (ds==NULL)
+		return -1;
+	c=CellOf(ds,x,y);
+	if (c<0)
+		return -1;
+	for (k=ds->cell_start[c];k<ds->cell_start[c+1];++k)
+		if (InDetector(&ds->det[ds->cell_det[k]],x,y))
+			return ds->cell_det[k];
+	return -1;
+}
+
+/*****************************************************************/
+/* weight w leaves the detection surface at (x,y) */
+void ScoreDetectors(struct SimContext *ctx, double x, double y, double w)
+{
+	struct DetectorSet *ds=ctx->detptr;
+	int c,k,i;
+
+	c=CellOf(ds,x,y);
+	if (c<0)
+		return;
+	for (k=ds->cell_start[c];k<ds->cell_start[c+1];++k) {
+		i=ds->cell_det[k];
+		if (InDetector(&ds->det[i],x,y)) {
+			ctx->det_wt[i]+=w;
+			MOMENT_ADD(ctx,&ctx->det_wt[i],w);
+		}
+	}
+}
+
+/*****************************************************************/
+/* per detector: fraction of the launched weight collected and the */
+/* same per unit detector area                                     */
+void SaveDetectorResults(struct SimContext *ctx, FILE *file)
+{
+	struct DetectorSet *ds=ctx->detptr;
+	struct Detector *d;
+	double num_phot=ctx->source->num_photons,area,v;
+	int i;
+
+	if (ds==NULL)
+		return;
+	fprintf(file,"Detector %s\n",ctx->detector->reflect_flag ? "reflection" : "transmission");
+	fprintf(file,"det\ttype\tx(cm)\ty(cm)\tsize1(cm)\tsize2(cm)\tcollected[-]\tper area[1/cm2]%s\n",
+		ctx->moments.on ? "\trel. error" : "");
+	for (i=0;i<ds->num;++i) {
+		d=&ds->det[i];
+		if (d->type==DET_RECT)
+			area=4.0*d->a*d->b;
+		else
+			area=PI*(d->b2-d->a2);
+		v=ctx->det_wt[i]/num_phot;
+		fprintf(file,"%d\t%c\t%.4e\t%.4e\t%.4e\t%.4e\t%.4e\t%.4e",i,
+			(d->type==DET_RECT)?'r':((d->type==DET_ANNULUS)?'a':'c'),
+			d->x,d->y,(d->type==DET_RECT)?2.0*d->a:d->a,(d->type==DET_RECT)?2.0*d->b:d->b,
+			v,v/area);
+		if (ctx->moments.on)
+			fprintf(file,"\t%.4e",RelErr(ctx,&ctx->det_wt[i]));
+		fprintf(file,"\n");
+	}
+	fprintf(file,"\n\n");
+}
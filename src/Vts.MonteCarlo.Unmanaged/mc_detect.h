@@ -0,0 +1,45 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include<stdio.h>
+
+struct SimContext;
+
+#define DET_CIRCLE 0
+#define DET_ANNULUS 1
+#define DET_RECT 2
+
+  struct Detector{
+    int type;	/* DET_CIRCLE, DET_ANNULUS or DET_RECT */
+    double x, y;	/* center on the detection surface */
+    double a, b;	/* circle: 0,radius  annulus: inner,outer radius  rect: half widths */
+    double a2, b2;	/* a*a, b*b for the radial tests */
+  };
+
+  /* detectors on the surface picked by detector->reflect_flag, and a */
+  /* uniform grid over their bounding boxes: each cell lists the      */
+  /* detectors overlapping it, so finding the ones an exit point is   */
+  /* in costs about the same however many there are. Read only while  */
+  /* tracing, shared by the worker contexts.                          */
+  struct DetectorSet{
+    int num;
+    struct Detector *det;
+    int gx, gy;	/* grid cells along x and y */
+    double x0, y0, x1, y1;	/* grid bounds, the union of the bounding boxes */
+    double inv_cx, inv_cy;	/* 1/cell size */
+    int *cell_start;	/* [gx*gy+1], cell c holds cell_det[cell_start[c]..cell_start[c+1]-1] */
+    int *cell_det;	/* detector indices, ascending within a cell */
+  };
+
+__declspec(dllexport) int ReadDetectors(struct SimContext *, char *);
+void SetDetectors(struct SimContext *, int, const struct Detector *);
+void FreeDetectors(struct DetectorSet *);
+int DetectorSlots(struct SimContext *);
+int FindDetector(struct SimContext *, double, double);
+void ScoreDetectors(struct SimContext *, double, double, double);
+void SaveDetectorResults(struct SimContext *, FILE *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
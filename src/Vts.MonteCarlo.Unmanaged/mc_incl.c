@@ -0,0 +1,516 @@
+/* Embedded inclusions (do_ellip_layer==4).
+*
+*  Spheres, axis-aligned ellipsoids and finite cylinders sit inside
+*  the tissue slab (layer 1); each carries the layerprops index of its
+*  optical properties, so layers 2..num_layers act as a material table.
+*  Inclusions are index matched to the slab and must not overlap.
+*  A bounding-volume hierarchy (median split on the longest centroid
+*  axis) keeps the nearest-entry query of HitIncl at O(log n) boxes
+*  per step; the exact tests work on rays scaled by the precomputed
+*  inverse radii, so a sphere or ellipsoid is a unit-sphere test. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "mc_incl.h"
+
+#define INCL_EPS 1e-9	/* cm, a photon this close to a surface is on it */
+#define INV_ZERO 1e300	/* 1/u for a zero direction component */
+
+/*****************************************************************/
+static void InclBounds(struct Inclusion *p)
+{
+	double r,h,a;
+	int i;
+
+	for (i=0;i<3;++i) {
+		if (p->type==INCL_CYLINDER) {
+			r=1.0/p->inv_r[0];
+			h=p->half_len;
+			a=p->axis[i];
+			r=h*fabs(a)+r*sqrt((1.0-a*a>0.0)?1.0-a*a:0.0);
+		}
+		else
+			r=1.0/p->inv_r[i];
+		p->lo[i]=p->c[i]-r;
+		p->hi[i]=p->c[i]+r;
+	}
+}
+
+/*****************************************************************/
+/* distances tin<tout along unit u at which the line through o is */
+/* inside p; 0 if it misses                                       */
+static int InclInterval(const struct Inclusion *p, const double *o,
+	const double *u, double *tin, double *tout)
+{
+	double w[3],d[3],A=0.0,B=0.0,C=0.0,disc,sq,wa=0.0,ua=0.0,t1,t2,ir2;
+	int i;
+
+	if (p->type==INCL_CYLINDER) {
+		for (i=0;i<3;++i) {
+			wa+=(o[i]-p->c[i])*p->axis[i];
+			ua+=u[i]*p->axis[i];
+		}
+		ir2=p->inv_r[0]*p->inv_r[0];
+		for (i=0;i<3;++i) {
+			w[i]=o[i]-p->c[i]-wa*p->axis[i];
+			d[i]=u[i]-ua*p->axis[i];
+			A+=d[i]*d[i]*ir2;
+			B+=w[i]*d[i]*ir2;
+			C+=w[i]*w[i]*ir2;
+		}
+		C-=1.0;
+		if (A<1e-20) {	/* parallel to the axis */
+			if (C>0.0)
+				return 0;
+			*tin=-INV_ZERO;
+			*tout=INV_ZERO;
+		}
+		else {
+			disc=B*B-A*C;
+			if (disc<=0.0)
+				return 0;
+			sq=sqrt(disc);
+			*tin=(-B-sq)/A;
+			*tout=(-B+sq)/A;
+		}
+		/* clip to the end caps */
+		if (fabs(ua)<1e-20) {
+			if (fabs(wa)>p->half_len)
+				return 0;
+		}
+		else {
+			t1=(-p->half_len-wa)/ua;
+			t2=(p->half_len-wa)/ua;
+			if (t1>t2) {
+				sq=t1; t1=t2; t2=sq;
+			}
+			if (t1>*tin) *tin=t1;
+			if (t2<*tout) *tout=t2;
+		}
+		return (*tin<*tout);
+	}
+
+	/* sphere, ellipsoid: unit sphere in the frame scaled by inv_r */
+	for (i=0;i<3;++i) {
+		w[i]=(o[i]-p->c[i])*p->inv_r[i];
+		d[i]=u[i]*p->inv_r[i];
+		A+=d[i]*d[i];
+		B+=w[i]*d[i];
+		C+=w[i]*w[i];
+	}
+	C-=1.0;
+	disc=B*B-A*C;
+	if (disc<=0.0)
+		return 0;
+	sq=sqrt(disc);
+	*tin=(-B-sq)/A;
+	*tout=(-B+sq)/A;
+	return 1;
+}
+
+/*****************************************************************/
+/* does the segment o+t*u, 0<=t<=tmax, meet the box? */
+static int RayBox(const double *lo, const double *hi, const double *o,
+	const double *inv_u, double tmax)
+{
+	double t0=0.0,t1=tmax,ta,tb,tmp;
+	int i;
+
+	for (i=0;i<3;++i) {
+		ta=(lo[i]-o[i])*inv_u[i];
+		tb=(hi[i]-o[i])*inv_u[i];
+		if (ta>tb) {
+			tmp=ta; ta=tb; tb=tmp;
+		}
+		if (ta>t0) t0=ta;
+		if (tb<t1) t1=tb;
+		if (t0>t1)
+			return 0;
+	}
+	return 1;
+}
+
+/*****************************************************************/
+/* partial sort of order[lo..hi] so that the k-th entry by centroid */
+/* along axis is in place, smaller ones before it                   */
+static void SelectByAxis(struct InclusionSet *set, int lo, int hi, int k, int axis)
+{
+	int i,j,tmp;
+	double pivot;
+
+	while (lo<hi) {
+		pivot=set->incl[set->order[(lo+hi)/2]].c[axis];
+		i=lo;
+		j=hi;
+		while (i<=j) {
+			while (set->incl[set->order[i]].c[axis]<pivot) ++i;
+			while (set->incl[set->order[j]].c[axis]>pivot) --j;
+			if (i<=j) {
+				tmp=set->order[i]; set->order[i]=set->order[j]; set->order[j]=tmp;
+				++i;
+				--j;
+			}
+		}
+		if (k<=j)
+			hi=j;
+		else if (k>=i)
+			lo=i;
+		else
+			return;
+	}
+}
+
+/*****************************************************************/
+static int BuildNode(struct InclusionSet *set, int first, int count)
+{
+	struct BVHNode *nd;
+	double clo[3],chi[3],ext;
+	int id=set->num_nodes++,i,k,axis,left,right;
+
+	nd=&set->node[id];
+	for (k=0;k<3;++k) {
+		nd->lo[k]=clo[k]=INV_ZERO;
+		nd->hi[k]=chi[k]=-INV_ZERO;
+	}
+	for (i=first;i<first+count;++i) {
+		struct Inclusion *p=&set->incl[set->order[i]];
+		for (k=0;k<3;++k) {
+			if (p->lo[k]<nd->lo[k]) nd->lo[k]=p->lo[k];
+			if (p->hi[k]>nd->hi[k]) nd->hi[k]=p->hi[k];
+			if (p->c[k]<clo[k]) clo[k]=p->c[k];
+			if (p->c[k]>chi[k]) chi[k]=p->c[k];
+		}
+	}
+	nd->left=nd->right=-1;
+	nd->first=first;
+	nd->count=count;
+	if (count<=BVH_LEAF_SIZE)
+		return id;
+
+	axis=0;
+	ext=chi[0]-clo[0];
+	for (k=1;k<3;++k)
+		if (chi[k]-clo[k]>ext) {
+			ext=chi[k]-clo[k];
+			axis=k;
+		}
+	SelectByAxis(set,first,first+count-1,first+count/2,axis);
+	left=BuildNode(set,first,count/2);
+	right=BuildNode(set,first+count/2,count-count/2);
+	/* set->node may not move: it is sized 2*num up front */
+	set->node[id].left=left;
+	set->node[id].right=right;
+	set->node[id].count=0;
+	return id;
+}
+
+/*****************************************************************/
+/* nearest entry into any inclusion within tmax; -1 if none */
+static int NearestEntry(struct InclusionSet *set, const double *o,
+	const double *u, double tmax, double *tbest)
+{
+	int stack[BVH_MAX_DEPTH];
+	int sp=0,best=-1,i,k;
+	double inv_u[3],tin,tout;
+	struct BVHNode *nd;
+
+	for (k=0;k<3;++k)
+		inv_u[k]=(u[k]!=0.0)?1.0/u[k]:INV_ZERO;
+	*tbest=tmax;
+	stack[sp++]=0;
+	while (sp>0) {
+		nd=&set->node[stack[--sp]];
+		if (!RayBox(nd->lo,nd->hi,o,inv_u,*tbest))
+			continue;
+		if (nd->left<0) {
+			for (i=nd->first;i<nd->first+nd->count;++i) {
+				k=set->order[i];
+				/* entries ahead; a surface being left has tout~0 */
+				if (InclInterval(&set->incl[k],o,u,&tin,&tout)&&
+					(tin>=0.0)&&(tout>INCL_EPS)&&(tin<*tbest)) {
+					*tbest=tin;
+					best=k;
+				}
+			}
+		}
+		else {
+			stack[sp++]=nd->right;
+			stack[sp++]=nd->left;
+		}
+	}
+	return best;
+}
+
+/*****************************************************************/
+static int InsideIncl(const struct Inclusion *p, const double *x)
+{
+	double w[3],wa=0.0,r2=0.0;
+	int i;
+
+	if (p->type==INCL_CYLINDER) {
+		for (i=0;i<3;++i)
+			wa+=(x[i]-p->c[i])*p->axis[i];
+		if (fabs(wa)>p->half_len)
+			return 0;
+		for (i=0;i<3;++i) {
+			w[i]=(x[i]-p->c[i]-wa*p->axis[i])*p->inv_r[0];
+			r2+=w[i]*w[i];
+		}
+		return (r2<1.0);
+	}
+	for (i=0;i<3;++i) {
+		w[i]=(x[i]-p->c[i])*p->inv_r[i];
+		r2+=w[i]*w[i];
+	}
+	return (r2<1.0);
+}
+
+/*****************************************************************/
+/* copy and check the inclusions, build the hierarchy and switch  */
+/* the tissue to inclusion mode                                   */
+void SetInclusions(struct SimContext *ctx, int num, struct Inclusion *incl)
+{
+	struct InclusionSet *set;
+	double zbegin=ctx->tissptr->layerprops[1].zbegin;
+	double zend=ctx->tissptr->layerprops[1].zend;
+	int i,k;
+
+	if (ctx->inclptr!=NULL)
+		FreeInclusions(ctx->inclptr);
+	ctx->inclptr=NULL;
+	if (num<=0)
+		return;
+
+	set=(struct InclusionSet *)calloc(1,sizeof(struct InclusionSet));
+	if (set==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	set->num=num;
+	set->incl=(struct Inclusion *)malloc(num*sizeof(struct Inclusion));
+	set->order=(int *)malloc(num*sizeof(int));
+	set->node=(struct BVHNode *)malloc(2*num*sizeof(struct BVHNode));
+	if ((set->incl==NULL)||(set->order==NULL)||(set->node==NULL)) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	memcpy(set->incl,incl,num*sizeof(struct Inclusion));
+	for (i=0;i<num;++i) {
+		struct Inclusion *p=&set->incl[i];
+		if ((p->layer<2)||(p->layer>ctx->tissptr->num_layers)) {
+			printf("\nERROR - inclusion %d uses layer %d, materials are layers 2..%d\n",
+				i+1,p->layer,ctx->tissptr->num_layers);
+			exit(0);
+		}
+		for (k=0;k<3;++k)
+			if (!(p->inv_r[k]>0.0)) {
+				printf("\nERROR - inclusion %d has a radius <= 0\n",i+1);
+				exit(0);
+			}
+		if ((p->type==INCL_CYLINDER)&&!(p->half_len>0.0)) {
+			printf("\nERROR - inclusion %d has a length <= 0\n",i+1);
+			exit(0);
+		}
+		InclBounds(p);
+		if ((p->lo[2]<=zbegin)||(p->hi[2]>=zend)) {
+			printf("\nERROR - inclusion %d is not inside layer 1 (z=%f..%f)\n",
+				i+1,zbegin,zend);
+			exit(0);
+		}
+		set->order[i]=i;
+	}
+	BuildNode(set,0,num);
+	ctx->inclptr=set;
+	ctx->tissptr->do_ellip_layer=4;
+}
+
+/*****************************************************************/
+/* text file, one inclusion per line, # starts a comment:        */
+/*   s layer x y z r                  sphere                     */
+/*   e layer x y z rx ry rz           ellipsoid                  */
+/*   c layer x y z ax ay az r len     cylinder, axis (ax,ay,az)  */
+__declspec(dllexport) int ReadInclusions(struct SimContext *ctx, char *fname)
+{
+	FILE *file_ptr;
+	struct Inclusion *incl=NULL,*p;
+	char line[512],type;
+	double v[8],norm;
+	int n=0,cap=0,layer,nv,k,line_num=0;
+
+	file_ptr=fopen(fname,"r");
+	if (file_ptr==NULL) {
+		printf("\nERROR - Could not find or open inclusion file %s\n",fname);
+		exit(0);
+	}
+	while (fgets(line,sizeof(line),file_ptr)!=NULL) {
+		++line_num;
+		if (sscanf(line," %c",&type)!=1 || type=='#')
+			continue;
+		nv=sscanf(line," %c %d %lf %lf %lf %lf %lf %lf %lf %lf",&type,&layer,
+			&v[0],&v[1],&v[2],&v[3],&v[4],&v[5],&v[6],&v[7])-2;
+		if (n==cap) {
+			cap=(cap==0)?64:2*cap;
+			incl=(struct Inclusion *)realloc(incl,cap*sizeof(struct Inclusion));
+			if (incl==NULL) {
+				printf("Memory allocation error\n");
+				exit(1);
+			}
+		}
+		p=&incl[n];
+		memset(p,0,sizeof(struct Inclusion));
+		p->layer=(short)layer;
+		for (k=0;k<3;++k)
+			p->c[k]=v[k];
+		if ((type=='s')&&(nv==4)) {
+			p->type=INCL_SPHERE;
+			p->inv_r[0]=p->inv_r[1]=p->inv_r[2]=1.0/v[3];
+		}
+		else if ((type=='e')&&(nv==6)) {
+			p->type=INCL_ELLIPSOID;
+			for (k=0;k<3;++k)
+				p->inv_r[k]=1.0/v[3+k];
+		}
+		else if ((type=='c')&&(nv==8)) {
+			p->type=INCL_CYLINDER;
+			norm=sqrt(v[3]*v[3]+v[4]*v[4]+v[5]*v[5]);
+			if (norm==0.0) {
+				printf("\nERROR - inclusion file %s line %d: cylinder axis is 0\n",fname,line_num);
+				exit(0);
+			}
+			for (k=0;k<3;++k)
+				p->axis[k]=v[3+k]/norm;
+			p->inv_r[0]=p->inv_r[1]=p->inv_r[2]=1.0/v[6];
+			p->half_len=v[7]/2.0;
+		}
+		else {
+			printf("\nERROR - inclusion file %s line %d: expected s, e or c and its values\n",
+				fname,line_num);
+			exit(0);
+		}
+		++n;
+	}
+	fclose(file_ptr);
+	if (n==0) {
+		printf("\nERROR - inclusion file %s has no inclusions\n",fname);
+		exit(0);
+	}
+	SetInclusions(ctx,n,incl);
+	free(incl);
+	printf("inclusions: %d, %d BVH nodes\n",n,ctx->inclptr->num_nodes);
+	return n;
+}
+
+/*****************************************************************/
+void FreeInclusions(struct InclusionSet *set)
+{
+	free(set->incl);
+	free(set->order);
+	free(set->node);
+	free(set);
+}
+
+/*****************************************************************/
+/* HitBoundary for do_ellip_layer==4: nearest of the slab surfaces, */
+/* the exit of the inclusion holding the photon, or the entry into  */
+/* another one. Returns 1 slab, 2 entering, 4 leaving an inclusion, */
+/* 3 inside one with no hit, 0 otherwise, like HitEllip().          */
+short HitIncl(struct SimContext *ctx)
+{
+	struct InclusionSet *set=ctx->inclptr;
+	double o[3],u[3],tin,tout,t=0.0,dbound;
+	double s=ctx->photptr->s;
+	double mut=ctx->layers.mut[ctx->photptr->curr_layer];
+	double zbegin=ctx->tissptr->layerprops[1].zbegin;
+	double zend=ctx->tissptr->layerprops[1].zend;
+	short hit=0;
+	int k;
+
+	o[0]=ctx->photptr->x; o[1]=ctx->photptr->y; o[2]=ctx->photptr->z;
+	u[0]=ctx->photptr->ux; u[1]=ctx->photptr->uy; u[2]=ctx->photptr->uz;
+	dbound=s;
+
+	/* slab surfaces */
+	if (u[2]<0.0)
+		t=(zbegin-o[2])/u[2];
+	else if (u[2]>0.0)
+		t=(zend-o[2])/u[2];
+	if ((u[2]!=0.0)&&(t<dbound)) {
+		dbound=t;
+		hit=1;
+	}
+
+	if (ctx->curr_incl>=0) {
+		/* inclusions do not overlap: only its own surface counts */
+		if (!InclInterval(&set->incl[ctx->curr_incl],o,u,&tin,&tout))
+			tout=0.0;	/* grazing the surface: leave now */
+		if (tout<0.0)
+			tout=0.0;
+		if (tout<dbound) {
+			dbound=tout;
+			hit=4;
+			ctx->next_incl=-1;
+		}
+	}
+	else {
+		k=NearestEntry(set,o,u,dbound,&t);
+		if (k>=0) {
+			dbound=t;
+			hit=2;
+			ctx->next_incl=k;
+		}
+	}
+
+	if (hit) {
+		ctx->photptr->hit_bdry=1;
+		ctx->photptr->sleft=(mut>0.0)?(s-dbound)*mut:0.0;
+		ctx->photptr->s=dbound;
+	}
+	else if (ctx->curr_incl>=0)
+		hit=3;
+	return hit;
+}
+
+/*****************************************************************/
+/* index matched: no Fresnel, the photon changes material only */
+void CrossIncl(struct SimContext *ctx)
+{
+	ctx->curr_incl=ctx->next_incl;
+	if (ctx->curr_incl>=0)
+		ctx->photptr->curr_layer=ctx->inclptr->incl[ctx->curr_incl].layer;
+	else
+		ctx->photptr->curr_layer=1;
+}
+
+/*****************************************************************/
+/* layerprops index of the material at x: the inclusion holding */
+/* it, 1 in the slab                                            */
+short InclusionLayerAt(struct SimContext *ctx, const double *x)
+{
+	struct InclusionSet *set=ctx->inclptr;
+	int stack[BVH_MAX_DEPTH];
+	int sp=0,i,k;
+	struct BVHNode *nd;
+
+	stack[sp++]=0;
+	while (sp>0) {
+		nd=&set->node[stack[--sp]];
+		for (k=0;k<3;++k)
+			if ((x[k]<nd->lo[k])||(x[k]>nd->hi[k]))
+				break;
+		if (k<3)
+			continue;
+		if (nd->left<0) {
+			for (i=nd->first;i<nd->first+nd->count;++i)
+				if (InsideIncl(&set->incl[set->order[i]],x))
+					return set->incl[set->order[i]].layer;
+		}
+		else {
+			stack[sp++]=nd->right;
+			stack[sp++]=nd->left;
+		}
+	}
+	return 1;
+}
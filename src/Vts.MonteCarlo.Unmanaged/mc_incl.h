@@ -0,0 +1,50 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+#define INCL_SPHERE 0
+#define INCL_ELLIPSOID 1	/* axis aligned */
+#define INCL_CYLINDER 2	/* any axis, flat end caps */
+
+#define BVH_LEAF_SIZE 4	/* inclusions per leaf */
+#define BVH_MAX_DEPTH 64	/* traversal stack */
+
+/* one inclusion; ray tests run in the frame scaled by inv_r */
+struct Inclusion{
+  int type;
+  short layer;	/* layerprops index of its optical properties */
+  double c[3];	/* center */
+  double inv_r[3];	/* 1/radius per axis, cylinder uses [0] */
+  double axis[3];	/* cylinder unit axis */
+  double half_len;	/* cylinder half length */
+  double lo[3],hi[3];	/* bounding box */
+};
+
+struct BVHNode{
+  double lo[3],hi[3];
+  int left,right;	/* children, -1 in a leaf */
+  int first,count;	/* leaf: order[first..first+count-1] */
+};
+
+/* inclusions in a slab (layer 1); read only while tracing, */
+/* shared by the worker contexts                            */
+struct InclusionSet{
+  int num;
+  struct Inclusion *incl;
+  int num_nodes;
+  struct BVHNode *node;	/* node[0] is the root */
+  int *order;	/* inclusion indices in leaf order */
+};
+
+__declspec(dllexport) int ReadInclusions(struct SimContext *, char *);
+void SetInclusions(struct SimContext *, int, struct Inclusion *);
+void FreeInclusions(struct InclusionSet *);
+short HitIncl(struct SimContext *);
+short InclusionLayerAt(struct SimContext *, const double *);
+void CrossIncl(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -1,1184 +1,1839 @@
-/* Monte Carlo simulation of light propagation in
-*  mulit-layered tissues. This code was written by
-*  Andy Dunn, University of Texas at Austin, 1996.
-*
-*  The program prompts the user for an input filename
-*  (see example input file for details) and returns all
-*  of the output values to the output file specified by
-*  user in the input file.
-*
-*  Parts of this code were adapted from MCML, written
-*  by S. Jacques and L. Wang, MD Anderson Cancer Center.
-*  The major difference is that this program does not
-*  require a separate convolution program for finite beam
-*  diameters. */
-#include <stdio.h>
-#include <math.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-
-#include "mc_main.h"
-#include "mc_utils.h"
-#include "pert.h"
-#include "mc_read_input.h"
-#include "protos.h"
-
-#define Boolean char
-#define COS90D 1.0E-6
-#define COSZERO (1.0-1e-12)
-#define Weight_Limit 1.0e-4
-#define CHANCE 0.1
-#define ONE (1.0-1e-12)
-
-//#define PURE_ANALOG 0 field in flags structure now
-
-/* global variables */
-struct Photon *photptr;
-struct Tissue *tissptr;
-struct Output *outptr;
-struct perturb *pertptr;
-struct History *histptr;
-struct Flags *flagptr;
-struct SourceDefinition *source;
-struct DetectorDefinition *detector;
-
-
-/*************************************************************/
-/* begin main() */
-void main(int argc, char *argv[])
-{     
-	char name[256];
-	strcpy(name, "..\\..\\files\\MonteCarloTest\\infile_sphere.txt");  /*path of the input file*/
-	
-	RunMCCHInternal(name);
-}  /* end of main() */
-
-void RunMCCHInternal(char* inFileName)
-{
-	initialize(inFileName);
-	flagptr->AbsWtType=1; // set flags passed in by managed on external runs
-	flagptr->Seed=0;
-
-	RunMCLoop();
-
-	SaveResults();
-
-	FreeMemory(); // CKH: todo write to de-malloc all malloced
-}
-
-__declspec(dllexport) void RunTest(struct Photon *photptr_ex,
-	struct Tissue *tissptr_ex, struct Perturb *pertptr_ex, struct Output *outptr_ex)
-{
-    photptr = photptr_ex;
-	printf("mc_main:source->beam_radius=%f\n",source->beam_radius);
-	printf("mc_main:source->beamtype=%c\n",source->beamtype[0]);
-	printf("mc_main:source->src_NA=%f\n",source->src_NA);
-	printf("mc_main:tissptr->layerprops[1].mua=%f\n",tissptr->layerprops[1].mua);
-	tissptr = tissptr_ex;
-	printf("mc_main:detector->dr=%f\n",detector->dr);
-	printf("mc_main:source->num_photons=%d\n",source->num_photons);
-	pertptr = pertptr_ex;
-	printf("mc_main:tissptr->ellip_rad_y=%f\n",tissptr->ellip_rad_y);
-	outptr = outptr_ex;
-	printf("mc_main:output->Flu_rz[0][0]=%f\n",outptr->Flu_rz[0][0]);
-	printf("mc_main:output->Flu_rz[0][1]=%f\n",outptr->Flu_rz[0][1]);
-	printf("mc_main:output->Flu_rz[1][0]=%f\n",outptr->Flu_rz[1][0]);
-	printf("mc_main:output->Flu_rz[1][1]=%f\n",outptr->Flu_rz[1][1]);
-}
-
-__declspec(dllexport) void RunMCLoopExternal(struct Photon *photptr_ex, struct Tissue *tissptr_ex, 
-	struct SourceDefinition *source_ex, struct Output *outptr_ex,struct History *histptr_ex,struct Flags *flagptr_ex)
-{
-	photptr = photptr_ex;
-	tissptr = tissptr_ex;
-	outptr = outptr_ex;
-	source = source_ex;
-	histptr = histptr_ex;
-	flagptr = flagptr_ex;
-
-	printf("Seed=%d AbsWtType=%d\n",flagptr->Seed,flagptr->AbsWtType);
-
-	RunMCLoop();
-
-	printf("end of RunMCLooopExternal\n");
-}
-
-void RunMCLoop(void)
-{
-	int n=1;
-	short hit;
-
-	for (n=1; n<=source->num_photons; n++) {
-		printf("n=%d\n",n);
-		photptr->curr_n = n;
-		if (n%(source->num_photons/10) == 0)
-			DisplayStatus(n,source->num_photons);
-		init_photon();   
-		do { /* begin do while  */
-			
-			SetStepSize();
-			hit=HitBoundary();
-
-			if (hit == 1)  { /*begin if hit layer*/
-				Move_Photon();
-				CrossLayer(); 
-			} /*end if hit layer*/
-
-			else if (hit == 2|| hit==4) {  /*begin if hit ellipsoid*/      //------new
-				Move_Photon();
-				CrossEllip(); 
-			}/*end if hit ellipsoid*/
-
-			else if (hit == 0 || hit==3) { /*begin if no hit */
-				Move_Photon();
-				if(flagptr->AbsWtType==0) // ANALOG=0
-					Scatter_Or_Absorb();
-				else
-				{
-					Absorb(); 
-					Scatter(); /* 3D scattering */
-					/*Scatter1D();*/   /* 1D scattering */
-				}
-			}/*end if no hit*/
-
-			/*Test_Distance(); */
-			TestWeight();
-
-		} while (photptr->dead != 1); /* end do while */     
-
-		//pert();
-		//DCFIX UNCOMMENT!!!! Compute_Prob_allvox();  /* FIX added call */
-	} /* end of for n loop */
-}
-
-void SaveResults(void)
-{
-	int i=0;
-	NormalizeResults();
-	SaveTextResult();
-	Output_Wts_allvox(); /* FIX added call  */
-	for (i=0;i<detector->nr;++i)
-		printf("det at %f -> %i photons written\n",detector->det_ctr[i],
-		(int)photptr->num_photons_written[i]);
-	printf("tot phot out top=%i(%4.2f) bot=%i(%4.2f)\n",
-		pertptr->tot_out_top,(double)pertptr->tot_out_top/source->num_photons,
-		pertptr->tot_out_bot,(double)pertptr->tot_out_bot/source->num_photons);
-}
-
-/********************************************************/
-void DisplayIntro()
-{
-	printf("\n");
-	printf("     Monte Carlo Simulation of Light Propagation\n");
-	printf("           in a multi-layered tissue           \n");
-	printf("     with pMC and photon banana generation      \n");
-	printf("\n");
-	printf("             written by Dunn/Hayakawa           \n");
-	printf("            Beckman Laser Institute         \n");
-	printf("\n");
-}
-/********************************************************/
-double *AllocVector(short nl, short nh)  /* this mallocs AND inits */
-{
-	double *v;
-	short i;
-
-	v=(double *)malloc((unsigned) (nh-nl+1)*sizeof(double));
-	if (!v) {
-		printf("Memory allocation error\n");
-		exit(1);
-	}
-
-	v -= nl;
-	for(i=nl;i<=nh;i++) v[i] = 0.0;       /* init. */
-	return v;
-}
-
-/***********************************************************
-*      Allocate a matrix with row index from nrl to nrh 
-*      inclusive, and column index from ncl to nch
-*      inclusive.
-****/
-double **AllocMatrix(short nrl,short nrh,
-					 short ncl,short nch)
-{
-	short i,j;
-	double **m;
-
-	m=(double **) malloc((unsigned) (nrh-nrl+1)
-		*sizeof(double*));
-	if (!m) {
-		printf("allocation failure 1 in matrix()");
-		exit(1);
-	}
-	m -= nrl;
-
-	for(i=nrl;i<=nrh;i++) {
-		m[i]=(double *) malloc((unsigned) (nch-ncl+1)
-			*sizeof(double));
-		if (!m[i]) {
-			printf("allocation failure 2 in matrix()");
-			exit(1);
-		}
-		m[i] -= ncl;
-	}
-
-	for(i=nrl;i<=nrh;i++)
-		for(j=ncl;j<=nch;j++) m[i][j] = 0.0;
-	return m;
-}
-
-/********************************************************/
-void initialize(char* inFileName)
-{
-	int i;
-	//long n;
-	FILE * input_file_ptr;
-	double th;
-	double n;  
-	short nr,nz,na,nt,nx, ny;
-	char tmp_name[256];
-
-	printf("string entered is: %s\n", inFileName);
-	/* Allocate 4 global structures */
-	photptr=(struct Photon *)malloc(sizeof(struct Photon));
-	tissptr=(struct Tissue *)malloc(sizeof(struct Tissue));
-	outptr=(struct Output *)malloc(sizeof(struct Output));
-	pertptr=(struct perturb *)malloc(sizeof(struct perturb));
-	histptr=(struct History *)malloc(sizeof(struct History));
-	flagptr=(struct Flags *)malloc(sizeof(struct Flags));
-
-	// CKH 09jan31 malloc those structures that were changed to pointers
-	tissptr->layerprops=(struct Layer *)malloc(MAX_NUM_LAYERS*sizeof(struct Layer));
-	source->beamtype=malloc(10*sizeof(char));
-	photptr->num_photons_written=malloc(MAX_DET*sizeof(double));
-	outptr->in_side_allvox=malloc(6*sizeof(int));
-	outptr->out_side_allvox=malloc(6*sizeof(int));
-	histptr->xh=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->yh=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->zh=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->uxh=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->uyh=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->uzh=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->weight=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->pert_wt=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->path_length=malloc(MAX_HISTORY_PTS*sizeof(double));
-	histptr->boundary_col=malloc(MAX_HISTORY_PTS*sizeof(int));
-
-	input_file_ptr = fopen(inFileName, "r");
-	DisplayIntro();
-	ReadInput(input_file_ptr);
-
-	n = tissptr->layerprops[1].n;  
-	nr=detector->nr;
-	nz=detector->nz;
-	na=detector->na;
-	nt=detector->nt;  
-	
-	nx=detector->nx;  //  ==================================
-	ny=detector->ny;
-
-	photptr->sleft = 0.0;
-	outptr->Rd = 0.0;
-	outptr->Rtot = 0.0;
-	outptr->Td = 0.0;
-	outptr->Atot = 0.0;
-	photptr->Rspec = Specular();
-
-	outptr->A_rz = AllocMatrix(0,nr-1,0,nz-1);
-	outptr->A_z = AllocVector(0,nz-1);
-	outptr->A_layer=AllocVector(0,tissptr->num_layers+1); 
-	outptr->Flu_rz = AllocMatrix(0,nr-1,0,nz-1);
-	outptr->Flu_z = AllocVector(0,nz-1);
-
-	outptr->R_ra = AllocMatrix(0,nr-1,0,na-1);
-	outptr->R_r = AllocVector(0,nr-1);
-	outptr->R_r2 = AllocVector(0,nr-1);
-
-	//outptr->Rev = AllocMatrix(0,1,0,nr-1); /* R for expect value */
-	outptr->R_rt = AllocMatrix(0,nr-1,0,nt-1); /* R(r,t) */
-
-	outptr->R_a = AllocVector(0,na-1);
-	outptr->T_ra = AllocMatrix(0,nr-1,0,na-1);
-	outptr->T_r = AllocVector(0,nr-1);
-	outptr->T_a = AllocVector(0,na-1);
-	//histptr->xh = AllocVector(0,MAX_HISTORY_PTS);
-	//histptr->yh = AllocVector(0,MAX_HISTORY_PTS);
-	//histptr->zh = AllocVector(0,MAX_HISTORY_PTS);
-	//histptr->uxh = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->uyh = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->uzh = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->weight = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->pert_wt = AllocVector(0,MAX_HISTORY_PTS); // CKH degrade pert_wt from [3,MAX_HISTORY_PTS]
- //   histptr->path_length = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->boundary_col = ivector(0,MAX_HISTORY_PTS);
-
-	//DCFIX (again later)
-	//	todo: the following is a bad idea. allocation logic
-            // should be done from higher-level constructs. here, it should 
-            // just use nx, ny, etc...
-	outptr->R_xy = AllocMatrix(0,2*nx,0,2*ny); 
-
-	//detector->nx=2*detector->nr+1;
-	/*  outptr->Banana= d3tensor(0,detector->nx-1,0,detector->nz-1,0,detector->nt-1);*/
-
-	/* Note: All arrays are initialized to 0.0 in AllocVector() */
-
-	/* compute beam radius! */
-	/*   if (detector->nA/n > 1.0) { */
-	/*     printf("NA > too big!\n exiting ...\n"); */
-	/*     exit(0); */
-	/*   } */
-	/*   th=asin(detector->nA/n); */
-	/*   source->beam_diam=tissptr->z_focus*tan(th); */
-
-
-	/*   printf("NA= %e\n",detector->nA); */
-	/*   printf("z_f= %f\n",tissptr->z_focus); */
-	printf("beam radius= %f\n",source->beam_radius);
-	printf("beam type = %c\n",source->beamtype[0]);
-
-	for (i=0;i<detector->nr;++i)
-		photptr->num_photons_written[i]=0;
-
-	/* initialize perturbation */
-	init_pert();
-	init_banana_allvox(); /* FIX added call */
-
-	/* create output binary datafile */
-	//for (i=0;i<detector->nr;++i)
-	//{
-	//	sprintf(tmp_name,"%s%5.3f",pertptr->output_filename,
-	//		detector->det_ctr[i]);
-	//	outptr->binary_file[i]=
-	//		fopen(tmp_name,"wb");
-	//}
-}
-
-/*****************************************************************/
-void DisplayStatus(long n, long num_phot)
-{
-	/* fraction of photons completed */
-	double frac=100*n/num_phot;
-	time_t t;
-	time(&t);
-	printf("%5.0f percent complete, %s", frac, ctime(&t)); 
-}
-
-/*****************************************************************/
-
-void Scatter()
-{
-	double ux = photptr->ux;
-	double uy = photptr->uy;
-	double uz = photptr->uz;
-	short curr_layer = photptr->curr_layer;
-	double g = tissptr->layerprops[curr_layer].g;
-	double cost, sint;    /* cosine and sine of theta */
-	double cosp, sinp;    /* cosine and sine of phi */
-	double psi;
-
-	if(g == 0.0)
-		cost = 2*RandomNum() -1;
-	else {
-		double temp = (1-g*g)/(1-g+2*g*RandomNum());
-		cost = (1+g*g - temp*temp)/(2*g);
-		if(cost < -1) cost = -1;
-		else if(cost > 1) cost = 1;
-	}
-	sint = sqrt(1.0 - cost*cost);
-
-	psi = 2.0*PI*RandomNum();
-	cosp = cos(psi);
-	sinp = sin(psi);
-
-	if(fabs(uz) > (1-1e-10))  {               /* normal incident. */
-		photptr->ux = sint*cosp;
-		photptr->uy = sint*sinp;
-		photptr->uz = cost*uz/fabs(uz);
-	}
-	else  {
-		double temp = sqrt(1.0 - uz*uz);
-		photptr->ux = sint*(ux*uz*cosp - uy*sinp)
-			/temp + ux*cost;
-		photptr->uy = sint*(uy*uz*cosp + ux*sinp)
-			/temp + uy*cost;
-		photptr->uz = -sint*cosp*temp + uz*cost;
-	}
-}
-
-/*****************************************************************/
-void init_photon()
-{
-	double x, y, z_f, denom;
-	double RN1, RN2;
-	double cosRN2, sinRN2;
-	double theta,cost,sint,cosp,sinp;  /* cos/sin of theta/phi */
-	photptr->w=1.0-photptr->Rspec; 
-
-	/* Assume Gaussian beam w\ starting coordinates as given */
-	/*  on p24 in Ch4 of AJW book  */
-	/* photptr->x = 0.0; */
-
-	if ( source->beam_radius == 0.0 )
-	{
-		photptr->x = 0.0;
-		photptr->y = 0.0;
-	}
-	else 
-	{
-		RN1=RandomNum();
-		RN2=RandomNum();
-		//printf("RN1=%f RN2=%f\n",RN1,RN2);
-		cosRN2=cos(2*PI*RN2);
-		sinRN2=sin(2*PI*RN2);
-
-		if ( (source->beamtype[0] =='f') || (source->beamtype[0] =='F'))
-		{
-			/* flat beam */
-			photptr->x = source->beam_radius*sqrt(RN1)*cosRN2; 
-			photptr->y = source->beam_radius*sqrt(RN1)*sinRN2; 
-		}
-		else if ( (source->beamtype[0] =='r') || (source->beamtype[0] =='R'))//==================new
-		{
-		  /* flat rectangular beam */
-		  photptr->x = source->beam_radius*(RN2-0.5)+source->beam_center_x; 
-		  //x=[-beam_radius/2+beam_center_x:beam_radius/2+beam_center_x]
-		  photptr->y = RN1*8-4; //y=[-3:3 cm]==========================must be changed if you need a different field of view
-		}
-		else  /* Gaussian beam */
-		{
-		  if (RN1==1.0) RN1=RandomNum();
- 		  photptr->x=source->beam_radius*sqrt(-log(1.0-RN1)/2.0)*cosRN2; 
- 		  photptr->y=source->beam_radius*sqrt(-log(1.0-RN1)/2.0)*sinRN2; 
-		}
-		
-	}
-	photptr->z = 0.0;
-	photptr->dead = 0;
-
-	x=photptr->x;
-	y=photptr->y;
-	z_f=tissptr->z_focus;
-	/*  denom=sqrt(x*x + y*y + z_f*z_f);*/
-
-	/*   photptr->ux = -x/denom; */
-	/*   photptr->uy = -y/denom; */
-	/*   photptr->uz = z_f/denom; */
-	/* photptr->ux=0.0;
-	photptr->uy=0.0;
-	photptr->uz=1.0;  */
-	theta=2.0*PI*RandomNum();
-	cost=cos(theta);
-	sint=sin(theta);
-	if (source->src_NA==0.0) {
-		photptr->ux=0;
-		photptr->uy=0;
-		photptr->uz=1;
-	}
-	else {
-		do {
-			cosp=RandomNum();
-			sinp=sqrt(1.0-cosp*cosp);
-		} while (sinp>(source->src_NA/tissptr->layerprops[1].n)); 
-		photptr->ux=cost*sinp;
-		photptr->uy=sint*sinp;
-		photptr->uz=cosp; 
-	}
-
-	photptr->curr_layer = 1;   /* photon starts in first tissue layer */
-	photptr->s = 0.0;
-	photptr->sleft = 0.0;
-
-	/* start recording history */
-	histptr->num_pts_stored=1;
-	histptr->xh[0]=photptr->x;
-	histptr->yh[0]=photptr->y;
-	histptr->zh[0]=photptr->z;
-
-	histptr->uxh[0]=photptr->ux;
-	histptr->uyh[0]=photptr->uy;
-	histptr->uzh[0]=photptr->uz;
-	histptr->boundary_col[0]=0;
-
-	histptr->weight[0]=photptr->w;
-	histptr->path_length[0]=0.0;
-	histptr->cum_path_length=0.0;
-}
-/*****************************************************************/
-void SetStepSize()
-{
-	short curr_layer = photptr->curr_layer;
-	double mua = tissptr->layerprops[curr_layer].mua;
-	double mus = tissptr->layerprops[curr_layer].mus;
-	double RN;
-	if (photptr->sleft == 0.0) {
-		do RN = RandomNum();
-		while ((RN <=0.0) || (RN>ONE));
-		photptr->s = -log(RN)/(mua+mus);  
-	}
-	else {
-		photptr->s = photptr->sleft/(mua+mus);  
-		photptr->sleft = 0.0;
-	}
-}
-/*****************************************************************/
-void Move_Photon()
-{
-	int index;
-	double delta_x,delta_y,delta_z;
-	double tmp,l,xsurf,ysurf,rsurf,amt;
-	int irsurf;
-
-	double ux = photptr->ux;
-	double uy = photptr->uy;
-	double uz = photptr->uz;
-	double dr = detector->dr;
-	double mut=tissptr->layerprops[1].mus+tissptr->layerprops[1].mua;
-
-	photptr->x += photptr->s*ux;
-	photptr->y += photptr->s*uy;
-	photptr->z += photptr->s*uz; 
-
-	/* record history */
-	histptr->num_pts_stored++;
-	index=histptr->num_pts_stored-1;
-	histptr->xh[index]=photptr->x;
-	histptr->yh[index]=photptr->y;
-	histptr->zh[index]=photptr->z;
-
-	//if ((photptr->curr_n==1)&&(histptr->num_pts_stored>120))
-	//printf("Move: N=%d photptr->x[%d],y,z=%15.10f,%15.10f,%15.10f\n",
-	//	photptr->curr_n,index,histptr->xh[index],histptr->yh[index],
-	//	histptr->zh[index]);
-
-	histptr->uxh[index]=photptr->ux;
-	histptr->uyh[index]=photptr->uy;
-	histptr->uzh[index]=photptr->uz;
-	if (photptr->hit_bdry==1)
-	{
-		histptr->boundary_col[index]=1;
-		photptr->hit_bdry=0;  /* reset for next hit */
-	}
-	else
-		histptr->boundary_col[index]=0;
-
-	delta_x=photptr->x-histptr->xh[index-1];
-	delta_y=photptr->y-histptr->yh[index-1];
-	delta_z=photptr->z-histptr->zh[index-1];
-	tmp=sqrt(delta_x*delta_x+delta_y*delta_y+delta_z*delta_z);
-
-	pertptr->pathlen_in_layer[photptr->curr_layer] += tmp;
-	if (histptr->boundary_col[index]==0)
-		++pertptr->col_in_layer[photptr->curr_layer];
-
-	/* path_length = length from the prev point to the curr point */
-	histptr->path_length[index]=tmp;
-	histptr->cum_path_length += histptr->path_length[index];
-
-}
-//DCFIX
-
-/***************************************************************/
-short HitBoundary()  //-------------------------------------------------------new
-{
-	short hit=0;        /* Determines if we've hit the boundary of
-						a layer (hit=1) 
-						or ellipse from outside (hit=2) 
-						or ellipse from inside (hit=4)
-						or nothing but we're in the ellipse (hit=3)
-						or nothing and we're in the hom. medium (hit=0).*/ 
-	if (tissptr->do_ellip_layer==3)
-		hit = HitEllip();
-	else 
-		hit = HitLayer();
-	return hit;
-}
-/**************************************************************************/
-short HitLayer() // returns 1 if hit layer, returns 0 if not-------------------copy and paste from original "HitBoundary()"
-{
-  short curr_layer = photptr->curr_layer;
-  double zbegin = tissptr->layerprops[curr_layer].zbegin;
-  double zend = tissptr->layerprops[curr_layer].zend;
-  double dbound;  /* distance to boundary */
-  double uz = photptr->uz;
-  double s = photptr->s;
-  double z = photptr->z;
-  double mus = tissptr->layerprops[curr_layer].mus;
-  double mua = tissptr->layerprops[curr_layer].mua;
-  short hit;
-  
-  if (uz<0.0)
-    dbound = (zbegin-z)/uz;
-  else if (uz>0.0)
-    dbound = (zend-z)/uz;
-  if ((uz != 0.0) && (s>dbound)) {
-    hit = 1;
-    photptr->hit_bdry=1;
-    photptr->sleft = (photptr->s - dbound)*(mua+mus); 
-    photptr->s = dbound;
-  }
-  else hit = 0;
-  return(hit);
-}
-/********************************************************************************/
-
-
-short HitEllip()    //-------------------------------------------------------new, based on "Ray_Intersect_Ellip" in pert.h and on "HitLayer"
-/* returns	2 if hit the ellipsoid from outside, 
-			3 if didn't hit nothing but ray is in the ellipsoid, 
-			4 if hit ellip from inside, 
-			0 else */
-{
-	double A,B,C,root1,root2,root,xto,yto,zto;
-	int one_in,two_in;
-	int numint;
-	short hit = 0; 
-	double x1= photptr->x;    
-	double y1= photptr->y;
-	double z1= photptr->z;
-	double x2= photptr->x + photptr->s * photptr->ux;
-	double y2= photptr->y + photptr->s * photptr->uy;
-	double z2= photptr->z + photptr->s * photptr->uz;
-	double dbound;  /* distance to boundary */
-	double s = photptr->s;
-	short curr_layer = photptr->curr_layer; 
-	double mus = tissptr->layerprops[curr_layer].mus; /*layer [2] represents ellipse optical properties*/
-	double mua = tissptr->layerprops[curr_layer].mua;
-
-  if (z2<0||z2>tissptr->layerprops[1].d){  // if hits upper or lower boundary (with air)    
-	  hit=HitLayer();
-  }
-  else {
-
-	/* determine intersection with ellipsoid*/ 
-	one_in=InEllipsoid(x1,y1,z1);//is (x1,y1,z1)in the ellip? 0=no, 1=yes, 3=on the boundary, 2=ellip doesn't exist
-	two_in=InEllipsoid(x2,y2,z2);
-
-	if ((one_in==1 || one_in==2 || one_in==3)&& 
-		(two_in==1 || two_in==2))  /* ray within ellipsoid */
-    {
-		hit = 3;
-	}
-	
-	else   //ray may cross the ellipsoid once, twice or never. 
-		   //ph MUST stop at first intersection. finds number of intersections numint
-    { 
-      // sanity check dimensions of ellipsoid 
-      if ((tissptr->ellip_rad_x == 0.0) ||
-          (tissptr->ellip_rad_y == 0.0) ||
-          (tissptr->ellip_rad_z == 0.0))
-        {
-          printf("PERT ERROR: one ellipsoid radial dimension = 0.0\n");
-        }
-      else
-        {// finds intersections
-          A=(x2-x1)*(x2-x1)/(tissptr->ellip_rad_x*tissptr->ellip_rad_x)+
-            (y2-y1)*(y2-y1)/(tissptr->ellip_rad_y*tissptr->ellip_rad_y)+
-            (z2-z1)*(z2-z1)/(tissptr->ellip_rad_z*tissptr->ellip_rad_z);
-          B=2*(x2-x1)*(x1-tissptr->ellip_x)/(tissptr->ellip_rad_x*tissptr->ellip_rad_x)+
-            2*(y2-y1)*(y1-tissptr->ellip_y)/(tissptr->ellip_rad_y*tissptr->ellip_rad_y)+
-            2*(z2-z1)*(z1-tissptr->ellip_z)/(tissptr->ellip_rad_z*tissptr->ellip_rad_z);
-          C=(x1-tissptr->ellip_x)*(x1-tissptr->ellip_x)/(tissptr->ellip_rad_x*tissptr->ellip_rad_x)+
-            (y1-tissptr->ellip_y)*(y1-tissptr->ellip_y)/(tissptr->ellip_rad_y*tissptr->ellip_rad_y)+
-            (z1-tissptr->ellip_z)*(z1-tissptr->ellip_z)/(tissptr->ellip_rad_z*tissptr->ellip_rad_z)-
-            1.0;
-          if (B*B-4*A*C > 0)  // roots are real 
-            {
-              root1=(-B-sqrt(B*B-4*A*C))/(2*A);
-              root2=(-B+sqrt(B*B-4*A*C))/(2*A);
-              numint=0;             //number of intersections
-              if ((root1<1)&&(root1>0)) 
-                {
-                  numint+=1;
-                  root=root1;
-                }
-              if ((root2<1)&&(root2>0)) 
-                {
-                  numint+=1;
-                  root=root2;
-                }
-			  switch (numint) 
-                {
-                  case 0: /* roots real but no intersection */         
-					 hit=0;
-					 break;  					  
-                  case 1:
-					if ((one_in==3)&&(fabs(root)<1e-7))  // CKH FIX 11/10/08
-					{
-						 hit=0;
-					}
-					else
-					{
-						if (one_in==1)
-						{
-							hit=4;       //exiting the ellipse 
-						} 
-						else 
-						{
-							hit=2;       //entering it    
-						}
-						/*entering or exiting ellipsoid. It's the same*/
-						xto=x1+root*(x2-x1); 
-						yto=y1+root*(y2-y1);
-						zto=z1+root*(z2-z1);
-
-						/*distance to the boundary*/
-						dbound=sqrt((xto-x1)*(xto-x1)+
-                              (yto-y1)*(yto-y1)+
-                              (zto-z1)*(zto-z1));
-					
-						photptr->hit_bdry=1;        
-						photptr->sleft = (photptr->s - dbound)*(mua+mus); 
-						photptr->s = dbound;
-                        
-					 }
-					 break;
-					 
-                  case 2:  /* went through ellipsoid: must stop at nearest intersection */
-                    /*wich is nearest?*/
-					if (one_in==3) {
-					  if (root1>root2) // CKH FIX 11/11/08
-					    root=root1;
-					  else root=root2;
-					}
-					else {
-					  if (root1<root2) // CKH FIX 11/11/08
-					    root=root1;
-					  else root=root2;
-					}
-					xto=x1+root*(x2-x1);  
-                    yto=y1+root*(y2-y1);
-                    zto=z1+root*(z2-z1);
-                    /*distance to the nearest boundary*/
-					dbound=sqrt((xto-x1)*(xto-x1)+
-                            (yto-y1)*(yto-y1)+
-                            (zto-z1)*(zto-z1));
-                    photptr->hit_bdry=1;        
-					photptr->sleft = (photptr->s - dbound)*(mua+mus); 
-					photptr->s = dbound;
-					
-					hit=2;
-					break;
-					
-			  } /* end switch */
-    
-            } /* BB-4AC>0 */
-		  else /* roots imaginary -> no intersection */
-            {
-				hit=0;
-            } 
-	  } /* check on radial axis of ellipsoid */
-	} /* intersection with ellipsoid */
-  }
-  return hit;
-  }
-///***************************************************************/
-//short HitBoundary()
-//{
-//	short curr_layer = photptr->curr_layer;
-//	double zbegin = tissptr->layerprops[curr_layer].zbegin;
-//	double zend = tissptr->layerprops[curr_layer].zend;
-//	double dbound;  /* distance to boundary */
-//	double uz = photptr->uz;
-//	double s = photptr->s;
-//	double z = photptr->z;
-//	double mus = tissptr->layerprops[curr_layer].mus;
-//	double mua = tissptr->layerprops[curr_layer].mua;
-//	short hit;
-//
-//	if (uz<0.0)
-//		dbound = (zbegin-z)/uz;
-//	else if (uz>0.0)
-//		dbound = (zend-z)/uz;
-//
-//	if ((uz != 0.0) && (s>dbound)) {
-//		hit = 1;
-//		photptr->hit_bdry=1;
-//		photptr->sleft = (photptr->s - dbound)*(mua+mus); 
-//		photptr->s = dbound;
-//	}
-//	else hit = 0;
-//	return(hit);
-//	printf("HitBound: hit=%i\n",photptr->hit_bdry);
-//}
-
-/*****************************************************************/
-double Fresnel(double n1, double n2, double ci, double * uz_snell)
-{
-	/* n1 is the index of the current layer */
-	/* n2 is the index of the next layer */
-	double ct, si, st;  /* cos(thi), cos(tht), sin(thi), sin(tht) */
-	double cd, cs, sd, ss; /* cos(thi+tht), cos(thi-tht), etc */
-	double r;
-
-	if (n1==n2) {
-		*uz_snell = ci;
-		r = 0.0;
-	}
-	else if (ci>COSZERO) {     /* normal incidence */
-		*uz_snell = ci;
-		r = (n2-n1)*(n2-n1)/((n2+n1)*(n2+n1));
-	}
-	else if (ci<COS90D) {
-		*uz_snell = 0.0;
-		r = 1.0;
-	}
-	else {
-		si = sqrt(1-ci*ci);
-		st = n1/n2*si;
-		ct = sqrt(1-st*st);
-		*uz_snell = ct;
-
-		/* Use trig identities */
-		sd = si*ct - ci*st;
-		ss = si*ct + ci*st;
-		cd = ci*ct + si*st;
-		cs = ci*ct - si*st;
-		/* printf("cd= %12.4e    ss = %12.4e\n"); */
-		r = 0.5*(sd*sd/(ss*ss)+sd*sd*cs*cs/(cd*cd*ss*ss));
-	}
-
-	return(r);
-}
-
-/*****************************************************************/
-void Transmit(double r)
-{
-	short ir,ia;
-	double x = photptr->x;
-	double y = photptr->y;
-	double dr = detector->dr;
-	double da = detector->da;
-
-	ir=(short)(sqrt(x*x+y*y)/dr);
-	if ( ir > detector->nr-1 )
-		ir = detector->nr-1;
-	ia=(short)(acos(photptr->uz)/da);
-	if ( ia > detector->na-1 )
-		ia = detector->na-1;
-
-	if ( photptr->uz <0 ) printf(">0!\n");
-
-	outptr->T_ra[ir][ia] += photptr->w*(1-r);
-	photptr->w *= r;
-}
-
-/*****************************************************************/
-void Reflect(double r)// for index-mismatched reflections 
-{
-	double amt_out;
-	short ir,ia,it,nt=detector->nt; /* FIXED-DC added it,nt */ 
-
-	//DCFIX
-	short ix, iy; 
-
-	double w = photptr->w;
-	double x = photptr->x;
-	double y = photptr->y;
-	double dr = detector->dr;
-	double da = detector->da;  
-	
-	//DCFIX
-	double nx = detector->nx;  //=========================================
-	double ny = detector->ny;
-	double dx = detector->dx;
-	double dy = detector->dy;
-
-	double t_delay,dt=detector->dt;  /* FIXED-DC added t_delay,dt */
-
-	ir=(short)(sqrt(x*x+y*y)/dr);
-	if ( ir > detector->nr-1 )
-		ir = detector->nr-1;
-	ia=(short)(acos(photptr->uz)/da);
-	if ( ia > detector->na-1 )
-		ia = detector->na-1;
-
-	amt_out = (1-r)*w;
-	outptr->R_r[ir] += amt_out;
-	outptr->R_ra[ir][ia] += amt_out;
-	outptr->R_r2[ir] += amt_out*amt_out;
-	photptr->w *= r;  /* w=w*r is the amt internally reflected */
-	
-	/* FIXED-DC save R(r,t) */
-	t_delay=histptr->cum_path_length/(.03/
-		tissptr->layerprops[1].n);  /* -> ps */
-	it=(int)floor(t_delay/dt); /* assumes tmin=0 */
-	if ((it>nt-1)||(it<0)) it=-1; /* if outside [tmin,tmax] */
-	if (it!=-1) {
-		outptr->R_rt[ir][it]+=amt_out;
-	} 
-	/* END FIX */
-
-	//DCFIX (cartesian reflectance)
-	ix=(short)((x+nx*dx)/dx); /* added and checked*/
-	iy=(short)((y+ny*dy)/dy); /* added and checked*/
-
-  //printf("Reflect: x=%f ix=%d y=%f iy=%d\n",x,ix,y,iy); //=============    cancella
-  if ((ix < detector->nx*2-1) && (ix >= 0) &&
-      (iy < detector->ny*2-1) && (iy >= 0)) {
-    //printf("Reflect: ix=%d iy=%d amt_out=%f\n",ix,iy,amt_out);//=================    cancella
-    outptr->R_xy[ix][iy] += amt_out; /* added*/
-  }
-	photptr->dead=1;
-}
-/*****************************************************************/
-void CrossDown()
-{
-	double r, uz_snell;
-	short curr_layer = photptr->curr_layer;
-	double uz = photptr->uz;
-	double n_curr = tissptr->layerprops[curr_layer].n;
-	double n_next = tissptr->layerprops[curr_layer+1].n;
-	double coscrit;
-
-	if (n_curr > n_next)
-		coscrit = sqrt(1.0-(n_next/n_curr)*(n_next/n_curr));
-	else coscrit = 0.0;
-
-	if (uz <= coscrit)
-		r = 1.0;
-	else {
-		r = Fresnel(n_curr, n_next, uz, &uz_snell);
-	}
-	//printf("CrossDown: curr_layer=%d\n",curr_layer);
-	/* Decide whether or not photon goes to next layer */
-	if (RandomNum() > r) {
-		/* transmitted to next layer */  // CKH FIX 11/11/08
-		if (((tissptr->do_ellip_layer!=3)&&(curr_layer == tissptr->num_layers))
-		    ||((tissptr->do_ellip_layer==3)&&(curr_layer == 1))) 
-		{
-			/* call reflect with fixed weight photons! */
-			Transmit(0.0); 
-			photptr->dead = 1;
-			photptr->ux *= n_curr/n_next;
-			photptr->uy *= n_curr/n_next;
-			photptr->uz = uz_snell;
-		}
-		else {
-			photptr->curr_layer++;
-			photptr->ux *= n_curr/n_next;
-			photptr->uy *= n_curr/n_next;
-			photptr->uz = uz_snell;
-		}
-	} /* end if(RandomNum() */
-	else {
-
-		photptr->uz = -uz;
-	}
-}
-
-/*****************************************************************/
-void CrossUp()
-{
-	double r, uz_snell;
-	short curr_layer = photptr->curr_layer,index;
-	double uz = photptr->uz;
-	double n_curr = tissptr->layerprops[curr_layer].n;
-	double n_next = tissptr->layerprops[curr_layer-1].n;
-	double coscrit,x_curr,y_curr,z_curr;
-
-	if (n_curr > n_next)
-		coscrit = sqrt(1.0-(n_next/n_curr)*(n_next/n_curr));
-	else coscrit = 0.0;
-
-	if (-uz <= coscrit) {
-		r = 1.0;
-	}
-	else {
-		r = Fresnel(n_curr, n_next, -uz, &uz_snell);
-	}
-
-	/* Decide on whether photon crosses into next layer */
-	if (RandomNum() > r) {    /* moves into next layer */
-		if (curr_layer == 1) { /* top layer-move out of tissue */
-			photptr->ux *= n_curr/n_next;
-			photptr->uy *= n_curr/n_next;
-			photptr->uz = uz_snell;
-
-			/* call reflect with fixed weight photons! */
-			Reflect(0.0); /* 0.0 b/c all or none refl */
-			photptr->dead = 1;
-		}
-		else {
-			photptr->curr_layer--;  /* moves across interface */
-			photptr->ux *= n_curr/n_next;
-			photptr->uy *= n_curr/n_next;
-			photptr->uz = -uz_snell;
-		}
-	}  /* end if(RandomNum() */
-	else
-		photptr->uz = -uz;
-}
-
-/*****************************************************************/
-void CrossLayer(void)
-{
-	double uz = photptr->uz;
-	if (uz<0.0)
-		CrossUp();
-	else
-		CrossDown();
-}
-
-/*****************************************************************/
-void CrossEllip()   //-----------------------------------------------------new
-/*based on CrossLayer, but without Fresnel (n doesn't change)=>no reflections at the boundary.*/
-{   
-  short curr_layer = photptr->curr_layer;
-  double n_curr, n_next;
-
-  if (curr_layer==2) 
-	  photptr->curr_layer--;
-  else
-	  photptr->curr_layer++;
-
-}
-
-/*****************************************************************/
-
-void Absorb(void)
-{
-	double dw;
-	short ir,iz;
-	short curr_layer = photptr->curr_layer;
-	double mua = tissptr->layerprops[curr_layer].mua;
-	double mus = tissptr->layerprops[curr_layer].mus;
-	double w = photptr->w;
-	double x = photptr->x;
-	double y = photptr->y;
-	int index=histptr->num_pts_stored-1;
-
-	if (photptr->sleft==0.0)  // only deweight if real not pseudo collision
-	{
-		/* Compute array indices from r and z */
-		iz=(short)(photptr->z/detector->dz);
-		if (iz>detector->nz-1) iz=detector->nz-1;
-		ir=(short)(sqrt(x*x+y*y)/detector->dr);
-		if (ir>detector->nr-1) ir=detector->nr-1;
-
-		/* no cont abs wt change here since weight in post */
-		dw = w*mua/(mua+mus); 
-		photptr->w -= dw;
-		if (curr_layer==3)
-			printf("curr_layer==3\n");
-		outptr->A_layer[curr_layer] += dw;
-		outptr->A_rz[ir][iz] += dw; 
-
-		/* update weight for history */
-		histptr->weight[index]=photptr->w;
-
-		if (flagptr->AbsWtType==0) // ANALOG=1;
-			photptr->dead=1;
-	}
-}
-
-/*****************************************************************/
-void Scatter_Or_Absorb()
-{
-	double RN;
-
-	RN=RandomNum();
-	if (RN<tissptr->layerprops[photptr->curr_layer].albedo)
-		Scatter();
-	else
-		Absorb();
-}
-
-/*****************************************************************/
-void Test_Distance(void)
-{
-	/* kill photon if it has gone too far */
-	if(histptr->cum_path_length>=photptr->max_path_length)
-		photptr->dead=1;
-}
-
-/*****************************************************************/
-void Roulette()
-{
-	if (photptr->w == 0.0)
-		photptr->dead = 1;
-	else if (RandomNum() < CHANCE)
-		photptr->w /= CHANCE;
-	else photptr->dead = 1;
-}
-
-/*****************************************************************/
-void TestWeight()
-{
-	/*   if (photptr->w < Weight_Limit) */
-	/*     Roulette();  */
-	if(histptr->num_pts_stored >= MAX_HISTORY_PTS-4)
-	{
-		photptr->dead=1;
-		printf("WARNING: MAX_HISTORY_PTS reached. Killing this photon\n"); 
-	}
-}
-
-/*****************************************************************/
-
-
-/********************************************************/
-void FreeVector(double *v,short nl,short nh)
-{
-	free((char*) (v+nl));
-}
-
-/***********************************************************
-*      Release the memory.
-****/
-void FreeMatrix(double **m,short nrl,short nrh,
-				short ncl,short nch)
-{
-	short i;
-
-	for(i=nrh;i>=nrl;i--) free((char*) (m[i]+ncl));
-	free((char*) (m+nrl));
-}
-
-/********************************************************/
-void FreeMemory()
-{
-	FreeMatrix(outptr->A_rz,0,detector->nr-1,0,detector->nz-1);
-	FreeVector(outptr->A_z,0,detector->nz-1);
-	FreeVector(outptr->A_layer,0,tissptr->num_layers+1);
-	FreeMatrix(outptr->Flu_rz,0,detector->nr-1,0,detector->nz-1);
-	FreeVector(outptr->Flu_z,0,detector->nz-1);
-	FreeMatrix(outptr->R_ra,0,detector->nr-1,0,detector->na-1);
-	FreeVector(outptr->R_r,0,detector->nr-1);
-	FreeVector(outptr->R_r2,0,detector->nr-1);
-	
-	FreeMatrix(outptr->R_rt,0,detector->nr-1,0,detector->nt-1);
-	FreeVector(outptr->R_a,0,detector->na-1);
-	FreeMatrix(outptr->T_ra,0,detector->nr-1,0,detector->na-1);
-	FreeVector(outptr->T_r,0,detector->nr-1);
-	FreeVector(outptr->T_a,0,detector->na-1);
-
-	//histptr->xh = AllocVector(0,MAX_HISTORY_PTS);
-	//histptr->yh = AllocVector(0,MAX_HISTORY_PTS);
-	//histptr->zh = AllocVector(0,MAX_HISTORY_PTS);
-	//histptr->uxh = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->uyh = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->uzh = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->weight = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->pert_wt = AllocVector(0,MAX_HISTORY_PTS); // CKH degrade pert_wt from [3,MAX_HISTORY_PTS]
- //   histptr->path_length = AllocVector(0,MAX_HISTORY_PTS);
- //   histptr->boundary_col = ivector(0,MAX_HISTORY_PTS);
- 
-	/*  free_d3tensor(outptr->Banana,0,detector->nx-1,0,detector->nz-1,
-	*	0,detector->nt-1);*/
-}
-
-/*********************************************************/
-void Scatter1D()
-{
-	short curr_layer = photptr->curr_layer;
-	double g = tissptr->layerprops[curr_layer].g;
-
-	if(RandomNum() < ((1+g)/2.0) )
-		photptr->uz *= 1.0;
-	else
-		photptr->uz *= -1.0;
-}
-
+/* Monte Carlo simulation of light propagation in
+*  mulit-layered tissues. This code was written by
+*  Andy Dunn, University of Texas at Austin, 1996.
+*
+*  The program prompts the user for an input filename
+*  (see example input file for details) and returns all
+*  of the output values to the output file specified by
+*  user in the input file.
+*
+*  Parts of this code were adapted from MCML, written
+*  by S. Jacques and L. Wang, MD Anderson Cancer Center.
+*  The major difference is that this program does not
+*  require a separate convolution program for finite beam
+*  diameters. */
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mc_main.h"
+#include "mc_utils.h"
+#include "pert.h"
+#include "mc_read_input.h"
+#include "mc_v.h"
+#include "mc_threads.h"
+#include "mc_batch.h"
+#include "mc_white.h"
+#include "mc_incl.h"
+#include "mc_voxel.h"
+#include "mc_delta.h"
+#include "mc_detect.h"
+#include "mc_moment.h"
+#include "mc_conv.h"
+#include "mc_ckpt.h"
+#include "mc_merge.h"
+#include "mc_bench.h"
+#include "mc_test.h"
+#include "mc_stats.h"
+#include "protos.h"
+
+#define Boolean char
+#define COS90D 1.0E-6
+#define COSZERO (1.0-1e-12)
+#define ONE (1.0-1e-12)
+#define FX_LANES 4	/* independent recurrences in ReflectSpatialFrequency() */
+
+//#define PURE_ANALOG 0 field in flags structure now
+
+/*************************************************************/
+/* argument i of main(), NULL when it is missing or "-" */
+static char *FileArg(int argc, char *argv[], int i)
+{
+	return ((argc>i)&&strcmp(argv[i],"-")) ? argv[i] : NULL;
+}
+
+/*************************************************************/
+/* begin main() */
+void main(int argc, char *argv[])
+{     
+	char name[256];
+	char *name_ptr=name;
+	strcpy(name, "..\\..\\files\\MonteCarloTest\\infile_sphere.txt");  /*path of the input file*/
+	
+	/* "merge mua incl vox det shard...": add up the raw output of */
+	/* the shards (mc_merge.c) instead of running                  */
+	if ((argc>1)&&(strcmp(argv[1],"merge")==0)) {
+		if (argc<7) {
+			printf("\nERROR - usage: merge mua incl vox det shard...\n");
+			exit(0);
+		}
+		MergeMCCHInternal(name,FileArg(argc,argv,2),FileArg(argc,argv,3),
+			FileArg(argc,argv,4),FileArg(argc,argv,5),argc-6,argv+6);
+		return;
+	}
+	/* "bench mua incl vox det [infile...]": time the engine on each */
+	/* input (mc_bench.c), the one above when none is given          */
+	if ((argc>1)&&(strcmp(argv[1],"bench")==0)) {
+		if (argc<6) {
+			printf("\nERROR - usage: bench mua incl vox det [infile...]\n");
+			exit(0);
+		}
+		BenchMCCHInternal((argc>6) ? argc-6 : 1,(argc>6) ? argv+6 : &name_ptr,
+			FileArg(argc,argv,2),FileArg(argc,argv,3),FileArg(argc,argv,4),FileArg(argc,argv,5));
+		return;
+	}
+	/* "test": the self tests (mc_test.c) on the input above; the */
+	/* exit status is 1 when one fails                            */
+	if ((argc>1)&&(strcmp(argv[1],"test")==0))
+		exit(SelfTestMC(name)>0);
+	/* optional arguments: table of mua vectors for absorption rescaling, */
+	/* inclusion file (mc_incl.c), voxel file (mc_voxel.c), detector */
+	/* file (mc_detect.c); "-" skips one */
+	RunMCCHInternal(name,FileArg(argc,argv,1),FileArg(argc,argv,2),
+		FileArg(argc,argv,3),FileArg(argc,argv,4));
+}  /* end of main() */
+
+/* a context for inFileName and the optional files (NULL: none) */
+static struct SimContext *CreateSimContextWithFiles(char* inFileName, char* muaFileName,
+	char* inclFileName, char* voxFileName, char* detFileName)
+{
+	struct SimContext *ctx;
+
+	ctx=CreateSimContext(inFileName);
+	if (muaFileName!=NULL)
+		ReadWhiteMuaSets(ctx,muaFileName);
+	if (inclFileName!=NULL)
+		ReadInclusions(ctx,inclFileName);
+	if (voxFileName!=NULL)
+		ReadVoxelGrid(ctx,voxFileName);
+	if (detFileName!=NULL)
+		ReadDetectors(ctx,detFileName);
+	return ctx;
+}
+
+void RunMCCHInternal(char* inFileName, char* muaFileName, char* inclFileName,
+					 char* voxFileName, char* detFileName)
+{
+	struct SimContext *ctx;
+
+	ctx=CreateSimContextWithFiles(inFileName,muaFileName,inclFileName,voxFileName,detFileName);
+
+	RunSimContext(ctx);
+
+	FreeSimContext(ctx);
+}
+
+/* the input and files of the shards, and the shards to add up */
+void MergeMCCHInternal(char* inFileName, char* muaFileName, char* inclFileName,
+					   char* voxFileName, char* detFileName, int numShards, char** shardFileNames)
+{
+	struct SimContext *ctx;
+
+	ctx=CreateSimContextWithFiles(inFileName,muaFileName,inclFileName,voxFileName,detFileName);
+
+	MergeSimContext(ctx,numShards,shardFileNames);
+
+	FreeSimContext(ctx);
+}
+
+/* trace and time each input with the optional files */
+void BenchMCCHInternal(int numInFiles, char** inFileNames, char* muaFileName,
+					   char* inclFileName, char* voxFileName, char* detFileName)
+{
+	struct SimContext *ctx;
+	int i;
+
+	for (i=0;i<numInFiles;++i) {
+		ctx=CreateSimContextWithFiles(inFileNames[i],muaFileName,inclFileName,voxFileName,detFileName);
+
+		BenchSimContext(ctx,inFileNames[i]);
+
+		FreeSimContext(ctx);
+	}
+}
+
+/*************************************************************/
+/* All state of one simulation lives in a SimContext so that  */
+/* several simulations can run side by side in one process.   */
+__declspec(dllexport) struct SimContext *CreateSimContext(char* inFileName)
+{
+	struct SimContext *ctx;
+
+	ctx=AllocSimContext();
+	/* set flags passed in by managed on external runs; before the */
+	/* input, whose keyword lines may change them                  */
+	ctx->flagptr->Seed=0;
+	ctx->flagptr->AbsWtType=ABS_DISCRETE;
+	ctx->flagptr->NumThreads=0; /* 0=use all available cores */
+	ctx->flagptr->RngType=RNG_RAN3;
+	ctx->flagptr->TransportEngine=ENGINE_SCALAR;
+	ctx->flagptr->Allvox=ALLVOX_OFF;
+	ctx->flagptr->Tracking=TRACK_SURFACE;
+	ctx->flagptr->TallySecondMoment=0;	/* "moments on": relative errors, at some cost */
+	STATS_BEGIN(ctx,STATS_INIT);
+	initialize(ctx,inFileName);
+	STATS_END(ctx,STATS_INIT);
+	return ctx;
+}
+
+__declspec(dllexport) void RunSimContext(struct SimContext *ctx)
+{
+	RunMCLoop(ctx);
+
+	SaveResults(ctx);
+}
+
+__declspec(dllexport) void FreeSimContext(struct SimContext *ctx)
+{
+	FreeMemory(ctx); // CKH: todo write to de-malloc all malloced
+	if (ctx->bananaptr!=NULL)
+		Free_Tally_allvox(ctx);
+	Free_Visits_allvox(ctx);
+	if (ctx->whiteptr!=NULL)
+		FreeWhiteMC(ctx,ctx->whiteptr);
+	if (ctx->inclptr!=NULL)
+		FreeInclusions(ctx->inclptr);
+	if (ctx->voxptr!=NULL)
+		FreeVoxelGrid(ctx->voxptr);
+	if (ctx->detptr!=NULL)
+		FreeDetectors(ctx->detptr);
+	free(ctx->det_wt);
+	FreeLayerTable(ctx);
+	FreeDelta(ctx);
+	FreeMoments(ctx);
+	FreeConvStop(ctx);
+	FreeCheckpoint(ctx);
+	FreePertLayers(ctx->pertptr);
+
+	free(ctx->tissptr->layerprops);
+	free(ctx->source->beamtype);
+	free(ctx->photptr->num_photons_written);
+	free(ctx->histptr->xh);
+	free(ctx->histptr->yh);
+	free(ctx->histptr->zh);
+	free(ctx->histptr->uxh);
+	free(ctx->histptr->uyh);
+	free(ctx->histptr->uzh);
+	free(ctx->histptr->weight);
+	free(ctx->histptr->pert_wt);
+	free(ctx->histptr->path_length);
+	free(ctx->histptr->boundary_col);
+
+	free(ctx->photptr);
+	free(ctx->tissptr);
+	free(ctx->outptr);
+	free(ctx->pertptr);
+	free(ctx->histptr);
+	free(ctx->flagptr);
+	free(ctx->source);
+	free(ctx->detector);
+	free(ctx->bananaptr);
+	free(ctx);
+}
+
+__declspec(dllexport) void RunTest(struct SimContext *ctx)
+{
+	printf("mc_main:source->beam_radius=%f\n",ctx->source->beam_radius);
+	printf("mc_main:source->beamtype=%c\n",ctx->source->beamtype[0]);
+	printf("mc_main:source->src_NA=%f\n",ctx->source->src_NA);
+	printf("mc_main:tissptr->layerprops[1].mua=%f\n",ctx->tissptr->layerprops[1].mua);
+	printf("mc_main:detector->dr=%f\n",ctx->detector->dr);
+	printf("mc_main:source->num_photons=%d\n",ctx->source->num_photons);
+	printf("mc_main:tissptr->ellip_rad_y=%f\n",ctx->tissptr->ellip_rad_y);
+	printf("mc_main:output->Flu_rz[0][0]=%f\n",ctx->outptr->Flu_rz[0][0]);
+	printf("mc_main:output->Flu_rz[0][1]=%f\n",ctx->outptr->Flu_rz[0][1]);
+	printf("mc_main:output->Flu_rz[1][0]=%f\n",ctx->outptr->Flu_rz[1][0]);
+	printf("mc_main:output->Flu_rz[1][1]=%f\n",ctx->outptr->Flu_rz[1][1]);
+}
+
+__declspec(dllexport) void RunMCLoopExternal(struct Photon *photptr_ex, struct Tissue *tissptr_ex, 
+	struct SourceDefinition *source_ex, struct Output *outptr_ex,struct History *histptr_ex,struct Flags *flagptr_ex,
+	struct DetectorDefinition *detector_ex)
+{
+	/* managed side owns the structures: wrap them in a context on the stack */
+	struct SimContext ctx_ex;
+	struct SimContext *ctx=&ctx_ex;
+	struct Flags flags_ex=*flagptr_ex;
+
+	/* its arrays are not in a tally arena: workers could not sum */
+	/* into them, nor the moments find them, and there is no      */
+	/* bvolume for allvox. Serial ran3 only, as before the flags  */
+	/* were added; NumThreads=0 (the default) means one thread    */
+	if ((flags_ex.NumThreads>1)||(flags_ex.RngType!=RNG_RAN3)||
+		(flags_ex.TransportEngine!=ENGINE_SCALAR)||(flags_ex.Allvox!=ALLVOX_OFF)||
+		(flags_ex.TallySecondMoment!=0)) {
+		printf("\nERROR - RunMCLoopExternal needs NumThreads 0 or 1, RngType ran3, TransportEngine scalar,\n"
+			"Allvox off and TallySecondMoment 0; got %d, %d, %d, %d, %d\n",flags_ex.NumThreads,
+			flags_ex.RngType,flags_ex.TransportEngine,flags_ex.Allvox,flags_ex.TallySecondMoment);
+		exit(0);
+	}
+	flags_ex.NumThreads=1;
+
+	memset(ctx,0,sizeof(struct SimContext));
+	ctx->photptr = photptr_ex;
+	ctx->tissptr = tissptr_ex;
+	ctx->outptr = outptr_ex;
+	ctx->source = source_ex;
+	ctx->histptr = histptr_ex;
+	ctx->flagptr = &flags_ex;
+	ctx->detector = detector_ex;
+	ctx->pertptr = (struct perturb *)calloc(1,sizeof(struct perturb));
+	AllocPertLayers(ctx->pertptr,ctx->tissptr->num_layers);
+	ctx->rng.first_time = 1;
+
+	printf("Seed=%d AbsWtType=%d\n",ctx->flagptr->Seed,ctx->flagptr->AbsWtType);
+
+	RunMCLoop(ctx);
+
+	FreeLayerTable(ctx);
+	FreeDelta(ctx);
+	FreeMoments(ctx);
+	FreePertLayers(ctx->pertptr);
+	free(ctx->pertptr);
+	printf("end of RunMCLooopExternal\n");
+}
+
+void RunMCLoop(struct SimContext *ctx)
+{
+	int num_threads=NumWorkerThreads(ctx);
+	int N=ctx->source->num_photons;
+	int done=0,last;
+
+	STATS_BEGIN(ctx,STATS_RUN);
+	ctx->stats.threads=num_threads;
+	if ((ctx->flagptr->TransportEngine==ENGINE_BATCH)&&!UseBatchEngine(ctx))
+		printf("batch engine needs Philox, discrete absorption weighting, layers only, surface tracking, no second moments, no allvox and no mua table: using scalar engine\n");
+	if (RECORD_HISTORY(ctx) && (ctx->histptr->xh==NULL))
+		AllocHistory(ctx->histptr);
+	if ((ctx->tissptr->do_ellip_layer==4)&&(ctx->inclptr==NULL)) {
+		printf("\nERROR - do_ellip_layer=4 needs an inclusion file\n");
+		exit(0);
+	}
+	if ((ctx->tissptr->do_ellip_layer==5)&&(ctx->voxptr==NULL)) {
+		printf("\nERROR - do_ellip_layer=5 needs a voxel file\n");
+		exit(0);
+	}
+	if (ctx->whiteptr!=NULL)
+		BeginWhiteWalk(ctx);
+	/* after BeginWhiteWalk(), which zeroes mua for the walk */
+	SetupLayerTable(ctx);
+	SetupDelta(ctx);
+	SetupMoments(ctx);
+	if (ctx->conv!=NULL)
+		SetupConv(ctx);
+	/* photons 1..done come from a checkpoint */
+	if (ctx->ckpt!=NULL)
+		done=StartCheckpoints(ctx,num_threads);
+	/* Philox runs always go through the chunked loop so that one
+	   thread sums the tallies in the same order as many, and so
+	   do convergence runs, a batch at a time */
+	if (ctx->conv!=NULL)
+		RunMCLoopConverged(ctx,num_threads,done);
+	else if ((num_threads>1)||(ctx->flagptr->RngType==RNG_PHILOX))
+		RunMCLoopParallel(ctx,num_threads,done);
+	else {
+		/* serial ran3: stop at each checkpoint */
+		for (;done<N;done=last) {
+			last=N;
+			if ((ctx->ckpt!=NULL)&&(ctx->ckpt->every>0)&&(ctx->ckpt->next_at<N))
+				last=ctx->ckpt->next_at;
+			RunPhotonRange(ctx,done+1,last);
+			CheckpointIfDue(ctx,last);
+		}
+	}
+	/* the tallies hold done photons when there were more in the */
+	/* checkpoint than asked for now                             */
+	if (ctx->source->num_photons<done)
+		ctx->source->num_photons=done;
+	if (ctx->ckpt!=NULL)
+		SaveCheckpoint(ctx,ctx->source->num_photons);
+	if (ctx->whiteptr!=NULL)
+		EndWhiteWalk(ctx);
+	STATS_END(ctx,STATS_RUN);
+}
+
+/* trace photons first..last (1-based, inclusive) into ctx's tallies */
+void RunPhotonRange(struct SimContext *ctx, int first, int last)
+{
+	int n=1;
+	short hit;
+	int num_in_range=last-first+1;
+	int status_every=num_in_range/10;
+
+	if (UseBatchEngine(ctx)) {
+		RunPhotonRangeBatch(ctx,first,last);
+		return;
+	}
+
+	for (n=first; n<=last; n++) {
+		ctx->photptr->curr_n = n;
+		if (ctx->flagptr->RngType==RNG_PHILOX)
+			SeedPhotonStream(ctx,n);
+		if ((ctx->worker==0) && (status_every>0) && ((n-first+1)%status_every == 0))
+			DisplayStatus(n-first+1,num_in_range);
+		init_photon(ctx);   
+		do { /* begin do while  */
+			
+			SetStepSize(ctx);
+			hit=HitBoundary(ctx);
+
+			if (hit == 1)  { /*begin if hit layer*/
+				STATS_INC(ctx,boundary_hits);
+				Move_Photon(ctx);
+				CrossLayer(ctx); 
+			} /*end if hit layer*/
+
+			else if (hit == 2|| hit==4) {  /*begin if hit ellipsoid*/      //------new
+				STATS_INC(ctx,region_crossings);
+				Move_Photon(ctx);
+				if (ctx->tissptr->do_ellip_layer==5)
+					CrossVoxel(ctx);
+				else if (ctx->tissptr->do_ellip_layer==4)
+					CrossIncl(ctx);
+				else
+					CrossEllip(ctx); 
+			}/*end if hit ellipsoid*/
+
+			else if (hit == 5) { /* virtual collision, delta tracking */
+				STATS_INC(ctx,virtual_collisions);
+				Move_Photon(ctx);
+			}
+
+			else if (hit == 0 || hit==3) { /*begin if no hit */
+				STATS_INC(ctx,collisions);
+				Move_Photon(ctx);
+				if(ctx->flagptr->AbsWtType==ABS_ANALOG)
+					Scatter_Or_Absorb(ctx);
+				else if(ctx->flagptr->AbsWtType==ABS_CONTINUOUS)
+					Scatter(ctx); /* absorbed along the track in Move_Photon */
+				else
+				{
+					Absorb(ctx); 
+					Scatter(ctx); /* 3D scattering */
+					/*Scatter1D(ctx);*/   /* 1D scattering */
+				}
+			}/*end if no hit*/
+
+			/*Test_Distance(ctx); */
+			TestWeight(ctx);
+
+		} while (ctx->photptr->dead != 1); /* end do while */     
+
+		//pert();
+		if (ctx->flagptr->Allvox==ALLVOX_HISTORY) {
+			STATS_BEGIN(ctx,STATS_ALLVOX);
+			Compute_Prob_allvox(ctx);  /* FIX added call */
+			STATS_END(ctx,STATS_ALLVOX);
+		}
+		if ((ctx->flagptr->Allvox!=ALLVOX_OFF)&&(ctx->allvox_trk.visits.record))
+			Count_Visits_allvox(ctx);
+		MomentEndPhoton(ctx);
+		STATS_END_PHOTON(ctx,ctx->histptr->num_pts_stored);
+	} /* end of for n loop */
+}
+
+void SaveResults(struct SimContext *ctx)
+{
+	int i=0;
+	STATS_BEGIN(ctx,STATS_NORMALIZE);
+	NormalizeResults(ctx);
+	STATS_END(ctx,STATS_NORMALIZE);
+	STATS_BEGIN(ctx,STATS_OUTPUT);
+	SaveTextResult(ctx);
+	Output_Wts_allvox(ctx); /* FIX added call  */
+	if (ctx->whiteptr!=NULL)
+		SaveWhiteResults(ctx);
+	STATS_END(ctx,STATS_OUTPUT);
+	STATS_SAVE(ctx);
+	if (ctx->detptr!=NULL) {
+		for (i=0;i<ctx->detptr->num;++i)
+			if (i<MAX_DET)
+				printf("det at %f,%f -> %i photons written\n",ctx->detptr->det[i].x,
+				ctx->detptr->det[i].y,(int)ctx->photptr->num_photons_written[i]);
+			else
+				printf("det at %f,%f -> no database file, the first %d detectors get one\n",
+				ctx->detptr->det[i].x,ctx->detptr->det[i].y,MAX_DET);
+	}
+	printf("tot phot out top=%i(%4.2f) bot=%i(%4.2f)\n",
+		ctx->pertptr->tot_out_top,(double)ctx->pertptr->tot_out_top/ctx->source->num_photons,
+		ctx->pertptr->tot_out_bot,(double)ctx->pertptr->tot_out_bot/ctx->source->num_photons);
+	printf("rouletted=%i(%4.2f)\n",ctx->pertptr->tot_rouletted,
+		(double)ctx->pertptr->tot_rouletted/ctx->source->num_photons);
+}
+
+/********************************************************/
+void DisplayIntro()
+{
+	printf("\n");
+	printf("     Monte Carlo Simulation of Light Propagation\n");
+	printf("           in a multi-layered tissue           \n");
+	printf("     with pMC and photon banana generation      \n");
+	printf("\n");
+	printf("             written by Dunn/Hayakawa           \n");
+	printf("            Beckman Laser Institute         \n");
+	printf("\n");
+}
+/********************************************************/
+double *AllocVector(short nl, short nh)  /* this mallocs AND inits */
+{
+	double *v;
+	short i;
+
+	v=(double *)malloc((unsigned) (nh-nl+1)*sizeof(double));
+	if (!v) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+
+	v -= nl;
+	for(i=nl;i<=nh;i++) v[i] = 0.0;       /* init. */
+	return v;
+}
+
+/***********************************************************
+*      Matrices are one TALLY_ALIGN aligned block laid out as
+*      [MatrixInfo][row pointers][rows*stride doubles], rows
+*      padded to a whole cache line. The double** returned
+*      indexes m[i][j] as before; MatrixInfoOf() recovers the
+*      stride for flat loops over the data.
+****/
+#define ALIGN_UP(n) (((n)+TALLY_ALIGN-1)&~(size_t)(TALLY_ALIGN-1))
+#define MATRIX_HDR ALIGN_UP(sizeof(struct MatrixInfo))
+
+static size_t MatrixBytes(int rows, int cols)
+{
+	size_t stride=ALIGN_UP(cols*sizeof(double))/sizeof(double);
+
+	return MATRIX_HDR+ALIGN_UP(rows*sizeof(double*))
+		+rows*stride*sizeof(double);
+}
+
+/* build the matrix view in the zeroed, aligned space at p */
+static double **CarveMatrix(char *p, short nrl, short nrh,
+							short ncl, short nch, void *block)
+{
+	struct MatrixInfo *info=(struct MatrixInfo *)p;
+	double **m=(double **)(p+MATRIX_HDR);
+	short i;
+
+	info->rows=nrh-nrl+1;
+	info->cols=nch-ncl+1;
+	info->stride=(int)(ALIGN_UP(info->cols*sizeof(double))/sizeof(double));
+	info->data=(double *)(p+MATRIX_HDR+ALIGN_UP(info->rows*sizeof(double*)));
+	info->block=block;
+
+	for(i=0;i<info->rows;i++)
+		m[i]=info->data+(size_t)i*info->stride-ncl;
+	return m-nrl;
+}
+
+struct MatrixInfo *MatrixInfoOf(double **m, short nrl)
+{
+	return (struct MatrixInfo *)((char *)(m+nrl)-MATRIX_HDR);
+}
+
+/***********************************************************
+*      Allocate a matrix with row index from nrl to nrh 
+*      inclusive, and column index from ncl to nch
+*      inclusive.
+****/
+double **AllocMatrix(short nrl,short nrh,
+					 short ncl,short nch)
+{
+	size_t bytes=MatrixBytes(nrh-nrl+1,nch-ncl+1);
+	void *block;
+	char *p;
+
+	block=calloc(1,bytes+TALLY_ALIGN-1);
+	if (!block) {
+		printf("allocation failure 1 in matrix()");
+		exit(1);
+	}
+	p=(char *)ALIGN_UP((size_t)block);
+	return CarveMatrix(p,nrl,nrh,ncl,nch,block);
+}
+
+/***********************************************************
+*      Tally arena: every AllocTallies() array is carved out
+*      of a single zeroed block, freed once in FreeMemory().
+****/
+struct TallyArena{
+	void *block;
+	char *next;	/* next free aligned byte */
+};
+
+static double *ArenaVector(struct TallyArena *a, short nl, short nh)
+{
+	double *v=(double *)a->next;
+
+	a->next+=ALIGN_UP((nh-nl+1)*sizeof(double));
+	return v-nl;
+}
+
+static double **ArenaMatrix(struct TallyArena *a, short nrl, short nrh,
+							short ncl, short nch)
+{
+	double **m=CarveMatrix(a->next,nrl,nrh,ncl,nch,NULL);
+
+	a->next+=MatrixBytes(nrh-nrl+1,nch-ncl+1);
+	return m;
+}
+
+/* the arena's doubles, for SetupMoments() */
+double *TallyArenaSpan(struct SimContext *ctx, size_t *num)
+{
+	struct TallyArena *a=ctx->tally_arena;
+	char *start;
+
+	if (a==NULL) {
+		*num=0;
+		return NULL;
+	}
+	start=(char *)ALIGN_UP((size_t)a->block);
+	*num=(size_t)(a->next-start)/sizeof(double);
+	return (double *)start;
+}
+
+/********************************************************/
+struct SimContext *AllocSimContext(void)
+{
+	struct SimContext *ctx;
+
+	/* Allocate the context and the structures it owns */
+	ctx=(struct SimContext *)calloc(1,sizeof(struct SimContext));
+	ctx->photptr=(struct Photon *)calloc(1,sizeof(struct Photon));
+	ctx->tissptr=(struct Tissue *)calloc(1,sizeof(struct Tissue));
+	ctx->outptr=(struct Output *)calloc(1,sizeof(struct Output));
+	ctx->pertptr=(struct perturb *)calloc(1,sizeof(struct perturb));
+	ctx->histptr=(struct History *)calloc(1,sizeof(struct History));
+	ctx->flagptr=(struct Flags *)calloc(1,sizeof(struct Flags));
+	ctx->source=(struct SourceDefinition *)calloc(1,sizeof(struct SourceDefinition));
+	ctx->detector=(struct DetectorDefinition *)calloc(1,sizeof(struct DetectorDefinition));
+	ctx->rng.first_time=1;
+
+	// CKH 09jan31 malloc those structures that were changed to pointers
+	/* tissptr->layerprops and the per-layer pert arrays are sized by ReadInput */
+	ctx->source->beamtype=malloc(10*sizeof(char));
+	ctx->photptr->num_photons_written=malloc(MAX_DET*sizeof(double)); /* resized by SetDetectors() */
+	/* History arrays are allocated by RunMCLoop, and only if needed */
+
+	return ctx;
+}
+
+/********************************************************/
+void AllocHistory(struct History *histptr)
+{
+	histptr->xh=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->yh=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->zh=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->uxh=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->uyh=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->uzh=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->weight=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->pert_wt=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->path_length=malloc(MAX_HISTORY_PTS*sizeof(double));
+	histptr->boundary_col=malloc(MAX_HISTORY_PTS*sizeof(int));
+}
+
+/********************************************************/
+void initialize(struct SimContext *ctx, char* inFileName)
+{
+	int i;
+	//long n;
+	FILE * input_file_ptr;
+	double th;
+	char tmp_name[256];
+
+	printf("string entered is: %s\n", inFileName);
+	input_file_ptr = fopen(inFileName, "r");
+	DisplayIntro();
+	ReadInput(ctx,input_file_ptr);
+
+	ctx->photptr->sleft = 0.0;
+	ctx->outptr->Rd = 0.0;
+	ctx->outptr->Rtot = 0.0;
+	ctx->outptr->Td = 0.0;
+	ctx->outptr->Atot = 0.0;
+	ctx->photptr->Rspec = Specular(ctx);
+
+	AllocTallies(ctx);
+
+	//detector->nx=2*detector->nr+1;
+	/*  ctx->outptr->Banana= d3tensor(0,ctx->detector->nx-1,0,ctx->detector->nz-1,0,ctx->detector->nt-1);*/
+
+	/* Note: All arrays are initialized to 0.0 in AllocVector() */
+
+	/* compute beam radius! */
+	/*   if (ctx->detector->nA/n > 1.0) { */
+	/*     printf("NA > too big!\n exiting ...\n"); */
+	/*     exit(0); */
+	/*   } */
+	/*   th=asin(ctx->detector->nA/n); */
+	/*   ctx->source->beam_diam=ctx->tissptr->z_focus*tan(th); */
+
+
+	/*   printf("NA= %e\n",ctx->detector->nA); */
+	/*   printf("z_f= %f\n",ctx->tissptr->z_focus); */
+	printf("beam radius= %f\n",ctx->source->beam_radius);
+	printf("beam type = %c\n",ctx->source->beamtype[0]);
+
+	for (i=0;i<DetectorSlots(ctx);++i)
+		ctx->photptr->num_photons_written[i]=0;
+
+	/* initialize perturbation */
+	init_pert(ctx);
+	init_banana_allvox(ctx); /* FIX added call */
+
+	/* create output binary datafile */
+	//for (i=0;i<detector->nr;++i)
+	//{
+	//	sprintf(tmp_name,"%s%5.3f",pertptr->output_filename,
+	//		detector->det_ctr[i]);
+	//	outptr->binary_file[i]=
+	//		fopen(tmp_name,"wb");
+	//}
+}
+
+/*****************************************************************/
+/* allocate (zeroed) output tallies sized by the detector, all in  */
+/* one arena so FreeMemory() releases them with a single free      */
+void AllocTallies(struct SimContext *ctx)
+{
+	short nr=ctx->detector->nr;
+	short nz=ctx->detector->nz;
+	short na=ctx->detector->na;
+	short nt=ctx->detector->nt;
+	short nx=ctx->detector->nx;
+	short ny=ctx->detector->ny;
+	short nl=ctx->tissptr->num_layers+2;
+	short nw=(short)ctx->outptr->nomega;
+	short nfx=ctx->nfx;
+	struct TallyArena *arena;
+	size_t bytes;
+
+	bytes=2*MatrixBytes(nr,nz)	/* A_rz, Flu_rz */
+		+2*MatrixBytes(nr,na)	/* R_ra, T_ra */
+		+MatrixBytes(nr,nt)	/* R_rt */
+		+MatrixBytes(2*nx+1,2*ny+1)	/* R_xy */
+		+2*ALIGN_UP(nz*sizeof(double))	/* A_z, Flu_z */
+		+ALIGN_UP(nl*sizeof(double))	/* A_layer */
+		+3*ALIGN_UP(nr*sizeof(double))	/* R_r, R_r2, T_r */
+		+2*ALIGN_UP(na*sizeof(double));	/* R_a, T_a */
+	if (nw>0)
+		bytes+=4*MatrixBytes(nr,nw);	/* re_rw, im_rw, Amp_rw, Phase_rw */
+	if (nfx>0)
+		bytes+=2*ALIGN_UP(nfx*sizeof(double));	/* R_fx_re, R_fx_im */
+
+	arena=(struct TallyArena *)malloc(sizeof(struct TallyArena));
+	if (arena!=NULL)
+		arena->block=calloc(1,bytes+TALLY_ALIGN-1);
+	if ((arena==NULL)||(arena->block==NULL)) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	arena->next=(char *)ALIGN_UP((size_t)arena->block);
+	ctx->tally_arena=arena;
+
+	ctx->outptr->A_rz = ArenaMatrix(arena,0,nr-1,0,nz-1);
+	ctx->outptr->A_z = ArenaVector(arena,0,nz-1);
+	ctx->outptr->A_layer=ArenaVector(arena,0,nl-1); 
+	ctx->outptr->Flu_rz = ArenaMatrix(arena,0,nr-1,0,nz-1);
+	ctx->outptr->Flu_z = ArenaVector(arena,0,nz-1);
+
+	ctx->outptr->R_ra = ArenaMatrix(arena,0,nr-1,0,na-1);
+	ctx->outptr->R_r = ArenaVector(arena,0,nr-1);
+	ctx->outptr->R_r2 = ArenaVector(arena,0,nr-1);
+
+	ctx->outptr->R_rt = ArenaMatrix(arena,0,nr-1,0,nt-1); /* R(r,t) */
+	if (nw>0) { /* R(r,f) */
+		ctx->outptr->re_rw = ArenaMatrix(arena,0,nr-1,0,nw-1);
+		ctx->outptr->im_rw = ArenaMatrix(arena,0,nr-1,0,nw-1);
+		ctx->outptr->Amp_rw = ArenaMatrix(arena,0,nr-1,0,nw-1);
+		ctx->outptr->Phase_rw = ArenaMatrix(arena,0,nr-1,0,nw-1);
+	}
+	if (nfx>0) { /* R(fx) */
+		ctx->R_fx_re = ArenaVector(arena,0,nfx-1);
+		ctx->R_fx_im = ArenaVector(arena,0,nfx-1);
+	}
+
+	ctx->outptr->R_a = ArenaVector(arena,0,na-1);
+	ctx->outptr->T_ra = ArenaMatrix(arena,0,nr-1,0,na-1);
+	ctx->outptr->T_r = ArenaVector(arena,0,nr-1);
+	ctx->outptr->T_a = ArenaVector(arena,0,na-1);
+
+	//DCFIX (again later)
+	//	todo: the following is a bad idea. allocation logic
+            // should be done from higher-level constructs. here, it should 
+            // just use nx, ny, etc...
+	ctx->outptr->R_xy = ArenaMatrix(arena,0,2*nx,0,2*ny);
+}
+
+/*****************************************************************/
+void DisplayStatus(long n, long num_phot)
+{
+	/* fraction of photons completed */
+	double frac=100*n/num_phot;
+	time_t t;
+	time(&t);
+	printf("%5.0f percent complete, %s", frac, ctime(&t)); 
+}
+
+/*****************************************************************/
+
+void Scatter(struct SimContext *ctx)
+{
+	double ux = ctx->photptr->ux;
+	double uy = ctx->photptr->uy;
+	double uz = ctx->photptr->uz;
+	short curr_layer = ctx->photptr->curr_layer;
+	double g = ctx->tissptr->layerprops[curr_layer].g;
+	double cost, sint;    /* cosine and sine of theta */
+	double cosp, sinp;    /* cosine and sine of phi */
+	double psi;
+
+	if(g == 0.0)
+		cost = 2*RandomNum(ctx) -1;
+	else {
+		double temp = (1-g*g)/(1-g+2*g*RandomNum(ctx));
+		cost = (1+g*g - temp*temp)/(2*g);
+		if(cost < -1) cost = -1;
+		else if(cost > 1) cost = 1;
+	}
+	sint = sqrt(1.0 - cost*cost);
+
+	psi = 2.0*PI*RandomNum(ctx);
+	cosp = cos(psi);
+	sinp = sin(psi);
+
+	if(fabs(uz) > (1-1e-10))  {               /* normal incident. */
+		ctx->photptr->ux = sint*cosp;
+		ctx->photptr->uy = sint*sinp;
+		ctx->photptr->uz = cost*uz/fabs(uz);
+	}
+	else  {
+		double temp = sqrt(1.0 - uz*uz);
+		ctx->photptr->ux = sint*(ux*uz*cosp - uy*sinp)
+			/temp + ux*cost;
+		ctx->photptr->uy = sint*(uy*uz*cosp + ux*sinp)
+			/temp + uy*cost;
+		ctx->photptr->uz = -sint*cosp*temp + uz*cost;
+	}
+}
+
+/*****************************************************************/
+void init_photon(struct SimContext *ctx)
+{
+	double x, y, z_f, denom;
+	double RN1, RN2;
+	double cosRN2, sinRN2;
+	double theta,cost,sint,cosp,sinp;  /* cos/sin of theta/phi */
+	ctx->photptr->w=1.0-ctx->photptr->Rspec; 
+
+	/* Assume Gaussian beam w\ starting coordinates as given */
+	/*  on p24 in Ch4 of AJW book  */
+	/* ctx->photptr->x = 0.0; */
+
+	if ( ctx->source->beam_radius == 0.0 )
+	{
+		ctx->photptr->x = 0.0;
+		ctx->photptr->y = 0.0;
+	}
+	else 
+	{
+		RN1=RandomNum(ctx);
+		RN2=RandomNum(ctx);
+		//printf("RN1=%f RN2=%f\n",RN1,RN2);
+		cosRN2=cos(2*PI*RN2);
+		sinRN2=sin(2*PI*RN2);
+
+		if ( (ctx->source->beamtype[0] =='f') || (ctx->source->beamtype[0] =='F'))
+		{
+			/* flat beam */
+			ctx->photptr->x = ctx->source->beam_radius*sqrt(RN1)*cosRN2; 
+			ctx->photptr->y = ctx->source->beam_radius*sqrt(RN1)*sinRN2; 
+		}
+		else if ( (ctx->source->beamtype[0] =='r') || (ctx->source->beamtype[0] =='R'))//==================new
+		{
+		  /* flat rectangular beam */
+		  ctx->photptr->x = ctx->source->beam_radius*(RN2-0.5)+ctx->source->beam_center_x; 
+		  //x=[-beam_radius/2+beam_center_x:beam_radius/2+beam_center_x]
+		  ctx->photptr->y = RN1*8-4; //y=[-3:3 cm]==========================must be changed if you need a different field of view
+		}
+		else  /* Gaussian beam */
+		{
+		  if (RN1==1.0) RN1=RandomNum(ctx);
+ 		  ctx->photptr->x=ctx->source->beam_radius*sqrt(-log(1.0-RN1)/2.0)*cosRN2; 
+ 		  ctx->photptr->y=ctx->source->beam_radius*sqrt(-log(1.0-RN1)/2.0)*sinRN2; 
+		}
+		
+	}
+	ctx->photptr->z = 0.0;
+	ctx->photptr->dead = 0;
+
+	x=ctx->photptr->x;
+	y=ctx->photptr->y;
+	z_f=ctx->tissptr->z_focus;
+	/*  denom=sqrt(x*x + y*y + z_f*z_f);*/
+
+	/*   ctx->photptr->ux = -x/denom; */
+	/*   ctx->photptr->uy = -y/denom; */
+	/*   ctx->photptr->uz = z_f/denom; */
+	/* ctx->photptr->ux=0.0;
+	ctx->photptr->uy=0.0;
+	ctx->photptr->uz=1.0;  */
+	theta=2.0*PI*RandomNum(ctx);
+	cost=cos(theta);
+	sint=sin(theta);
+	if (ctx->source->src_NA==0.0) {
+		ctx->photptr->ux=0;
+		ctx->photptr->uy=0;
+		ctx->photptr->uz=1;
+	}
+	else {
+		do {
+			cosp=RandomNum(ctx);
+			sinp=sqrt(1.0-cosp*cosp);
+		} while (sinp>(ctx->source->src_NA/ctx->tissptr->layerprops[1].n)); 
+		ctx->photptr->ux=cost*sinp;
+		ctx->photptr->uy=sint*sinp;
+		ctx->photptr->uz=cosp; 
+	}
+
+	ctx->photptr->curr_layer = 1;   /* photon starts in first tissue layer */
+	ctx->curr_incl = -1;
+	if (ctx->tissptr->do_ellip_layer==5)
+		ctx->photptr->curr_layer = VoxelMaterial(ctx);
+	ctx->photptr->s = 0.0;
+	ctx->photptr->sleft = 0.0;
+
+	/* start recording history */
+	ctx->histptr->num_pts_stored=1;
+	ctx->histptr->cum_path_length=0.0;
+	if (RECORD_HISTORY(ctx))
+	{
+		ctx->histptr->xh[0]=ctx->photptr->x;
+		ctx->histptr->yh[0]=ctx->photptr->y;
+		ctx->histptr->zh[0]=ctx->photptr->z;
+
+		ctx->histptr->uxh[0]=ctx->photptr->ux;
+		ctx->histptr->uyh[0]=ctx->photptr->uy;
+		ctx->histptr->uzh[0]=ctx->photptr->uz;
+		ctx->histptr->boundary_col[0]=0;
+
+		ctx->histptr->weight[0]=ctx->photptr->w;
+		ctx->histptr->path_length[0]=0.0;
+	}
+	if (ctx->flagptr->Allvox==ALLVOX_STREAM)
+		Start_Track_allvox(ctx);
+	if (ctx->whiteptr!=NULL)
+		WhiteStartPhoton(ctx);
+}
+/*****************************************************************/
+/* coefficient the step lengths are sampled with: mus alone with  */
+/* continuous absorption weighting, mua+mus otherwise.            */
+double StepMut(struct SimContext *ctx, short layer)
+{
+	double mua = ctx->tissptr->layerprops[layer].mua;
+	double mus = ctx->tissptr->layerprops[layer].mus;
+
+	if (ctx->flagptr->AbsWtType==ABS_CONTINUOUS)
+		return mus;
+	return mua+mus;
+}
+
+/*****************************************************************/
+/* boundaries, mut and 1/mut of every layer for the run about to  */
+/* start; the transport routines read these instead of layerprops */
+void SetupLayerTable(struct SimContext *ctx)
+{
+	struct LayerTable *lt=&ctx->layers;
+	int n=ctx->tissptr->num_layers,i;
+
+	FreeLayerTable(ctx);
+	lt->num_layers=n;
+	lt->zb=(double *)malloc((3*n+5)*sizeof(double));
+	if (lt->zb==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	lt->mut=lt->zb+n+1;
+	lt->inv_mut=lt->mut+n+2;
+	lt->zb[0]=ctx->tissptr->layerprops[1].zbegin;
+	for (i=1;i<=n;++i)
+		lt->zb[i]=ctx->tissptr->layerprops[i].zend;
+	for (i=0;i<n+2;++i) {
+		lt->mut[i]=StepMut(ctx,(short)i);
+		lt->inv_mut[i]=1.0/lt->mut[i];	/* inf for mut=0, as s/0 was */
+	}
+}
+
+/*****************************************************************/
+void FreeLayerTable(struct SimContext *ctx)
+{
+	free(ctx->layers.zb);
+	ctx->layers.zb=ctx->layers.mut=ctx->layers.inv_mut=NULL;
+}
+
+/*****************************************************************/
+/* layer 1..num_layers holding depth z by binary search, a depth */
+/* on a boundary going to the layer below, clamped at the ends   */
+short LayerAt(struct SimContext *ctx, double z)
+{
+	const double *zb=ctx->layers.zb;
+	int lo=1,hi=ctx->layers.num_layers,mid;
+
+	while (lo<hi) {
+		mid=(lo+hi)/2;
+		if (z<zb[mid])
+			hi=mid;
+		else
+			lo=mid+1;
+	}
+	return (short)lo;
+}
+
+/*****************************************************************/
+void SetStepSize(struct SimContext *ctx)
+{
+	double inv_mut = ctx->delta.on ? ctx->delta.inv_mut_max :
+		ctx->layers.inv_mut[ctx->photptr->curr_layer];
+	double RN;
+	if (ctx->photptr->sleft == 0.0) {
+		do RN = RandomNum(ctx);
+		while ((RN <=0.0) || (RN>ONE));
+		ctx->photptr->s = -log(RN)*inv_mut;  
+	}
+	else {
+		ctx->photptr->s = ctx->photptr->sleft*inv_mut;  
+		ctx->photptr->sleft = 0.0;
+	}
+}
+/*****************************************************************/
+void Move_Photon(struct SimContext *ctx)
+{
+	int index,bdry_col;
+	double delta_x,delta_y,delta_z;
+	double tmp,l,xsurf,ysurf,rsurf,amt;
+	int irsurf;
+
+	double ux = ctx->photptr->ux;
+	double uy = ctx->photptr->uy;
+	double uz = ctx->photptr->uz;
+	double x0 = ctx->photptr->x;
+	double y0 = ctx->photptr->y;
+	double z0 = ctx->photptr->z;
+	double dr = ctx->detector->dr;
+	double mut=ctx->tissptr->layerprops[1].mus+ctx->tissptr->layerprops[1].mua;
+
+	ctx->photptr->x += ctx->photptr->s*ux;
+	ctx->photptr->y += ctx->photptr->s*uy;
+	ctx->photptr->z += ctx->photptr->s*uz; 
+
+	if (ctx->photptr->hit_bdry==1)
+	{
+		bdry_col=1;
+		ctx->photptr->hit_bdry=0;  /* reset for next hit */
+	}
+	else
+		bdry_col=0;
+
+	delta_x=ctx->photptr->x-x0;
+	delta_y=ctx->photptr->y-y0;
+	delta_z=ctx->photptr->z-z0;
+	tmp=sqrt(delta_x*delta_x+delta_y*delta_y+delta_z*delta_z);
+
+	ctx->pertptr->pathlen_in_layer[ctx->photptr->curr_layer] += tmp;
+	if (bdry_col==0)
+		++ctx->pertptr->col_in_layer[ctx->photptr->curr_layer];
+	if (ctx->flagptr->AbsWtType==ABS_CONTINUOUS)
+		AbsorbAlongTrack(ctx,tmp);
+	if (ctx->whiteptr!=NULL)
+		WhiteTrack(ctx,tmp);
+
+	/* num_pts_stored counts steps even when nothing is stored */
+	ctx->histptr->num_pts_stored++;
+	ctx->histptr->cum_path_length += tmp;
+
+	if (ctx->flagptr->Allvox==ALLVOX_STREAM)
+		Score_Track_allvox(ctx,x0,y0,z0,
+			ctx->photptr->x,ctx->photptr->y,ctx->photptr->z);
+
+	if (!RECORD_HISTORY(ctx))
+		return;
+
+	/* record history */
+	index=ctx->histptr->num_pts_stored-1;
+	ctx->histptr->xh[index]=ctx->photptr->x;
+	ctx->histptr->yh[index]=ctx->photptr->y;
+	ctx->histptr->zh[index]=ctx->photptr->z;
+
+	//if ((photptr->curr_n==1)&&(histptr->num_pts_stored>120))
+	//printf("Move: N=%d photptr->x[%d],y,z=%15.10f,%15.10f,%15.10f\n",
+	//	photptr->curr_n,index,histptr->xh[index],histptr->yh[index],
+	//	histptr->zh[index]);
+
+	ctx->histptr->uxh[index]=ctx->photptr->ux;
+	ctx->histptr->uyh[index]=ctx->photptr->uy;
+	ctx->histptr->uzh[index]=ctx->photptr->uz;
+	ctx->histptr->boundary_col[index]=bdry_col;
+	if (ctx->flagptr->AbsWtType==ABS_CONTINUOUS)
+		ctx->histptr->weight[index]=ctx->photptr->w;
+
+	/* path_length = length from the prev point to the curr point */
+	ctx->histptr->path_length[index]=tmp;
+}
+//DCFIX
+
+/***************************************************************/
+short HitBoundary(struct SimContext *ctx)  //-------------------------------------------------------new
+{
+	short hit=0;        /* Determines if we've hit the boundary of
+						a layer (hit=1) 
+						or ellipse from outside (hit=2) 
+						or ellipse from inside (hit=4)
+						or nothing but we're in the ellipse (hit=3)
+						(same codes for inclusions, HitIncl;
+						voxels use 1 and 2, HitVoxel;
+						delta tracking 1, 0 and 5 for a
+						virtual collision, HitDelta)
+						or nothing and we're in the hom. medium (hit=0).*/ 
+	if (ctx->delta.on)
+		hit = HitDelta(ctx);
+	else if (ctx->tissptr->do_ellip_layer==3)
+		hit = HitEllip(ctx);
+	else if (ctx->tissptr->do_ellip_layer==4)
+		hit = HitIncl(ctx);
+	else if (ctx->tissptr->do_ellip_layer==5)
+		hit = HitVoxel(ctx);
+	else 
+		hit = HitLayer(ctx);
+	return hit;
+}
+/**************************************************************************/
+short HitLayer(struct SimContext *ctx) // returns 1 if hit layer, returns 0 if not-------------------copy and paste from original "HitBoundary()"
+{
+  short curr_layer = ctx->photptr->curr_layer;
+  double zbegin = ctx->tissptr->layerprops[curr_layer].zbegin;
+  double zend = ctx->tissptr->layerprops[curr_layer].zend;
+  double dbound;  /* distance to boundary */
+  double uz = ctx->photptr->uz;
+  double s = ctx->photptr->s;
+  double z = ctx->photptr->z;
+  double mut = ctx->layers.mut[curr_layer];
+  short hit;
+  
+  if (uz<0.0)
+    dbound = (zbegin-z)/uz;
+  else if (uz>0.0)
+    dbound = (zend-z)/uz;
+  if ((uz != 0.0) && (s>dbound)) {
+    hit = 1;
+    ctx->photptr->hit_bdry=1;
+    /* optical depth left; a layer with mut=0 (CAW, mus=0) just draws anew */
+    ctx->photptr->sleft = (mut>0.0) ? (ctx->photptr->s - dbound)*mut : 0.0; 
+    ctx->photptr->s = dbound;
+  }
+  else hit = 0;
+  return(hit);
+}
+/********************************************************************************/
+
+
+short HitEllip(struct SimContext *ctx)    //-------------------------------------------------------new, based on "Ray_Intersect_Ellip" in pert.h and on "HitLayer"
+/* returns	2 if hit the ellipsoid from outside, 
+			3 if didn't hit nothing but ray is in the ellipsoid, 
+			4 if hit ellip from inside, 
+			0 else */
+{
+	double A,B,C,root1,root2,root,xto,yto,zto;
+	int one_in,two_in;
+	int numint;
+	short hit = 0; 
+	double x1= ctx->photptr->x;    
+	double y1= ctx->photptr->y;
+	double z1= ctx->photptr->z;
+	double x2= ctx->photptr->x + ctx->photptr->s * ctx->photptr->ux;
+	double y2= ctx->photptr->y + ctx->photptr->s * ctx->photptr->uy;
+	double z2= ctx->photptr->z + ctx->photptr->s * ctx->photptr->uz;
+	double dbound;  /* distance to boundary */
+	double s = ctx->photptr->s;
+	short curr_layer = ctx->photptr->curr_layer; 
+	double mut = ctx->layers.mut[curr_layer]; /*layer [2] represents ellipse optical properties*/
+
+  if (z2<0||z2>ctx->tissptr->layerprops[1].d){  // if hits upper or lower boundary (with air)    
+	  hit=HitLayer(ctx);
+  }
+  else {
+
+	/* determine intersection with ellipsoid*/ 
+	one_in=InEllipsoid(ctx,x1,y1,z1);//is (x1,y1,z1)in the ellip? 0=no, 1=yes, 3=on the boundary, 2=ellip doesn't exist
+	two_in=InEllipsoid(ctx,x2,y2,z2);
+
+	if ((one_in==1 || one_in==2 || one_in==3)&& 
+		(two_in==1 || two_in==2))  /* ray within ellipsoid */
+    {
+		hit = 3;
+	}
+	
+	else   //ray may cross the ellipsoid once, twice or never. 
+		   //ph MUST stop at first intersection. finds number of intersections numint
+    { 
+      // sanity check dimensions of ellipsoid 
+      if ((ctx->tissptr->ellip_rad_x == 0.0) ||
+          (ctx->tissptr->ellip_rad_y == 0.0) ||
+          (ctx->tissptr->ellip_rad_z == 0.0))
+        {
+          printf("PERT ERROR: one ellipsoid radial dimension = 0.0\n");
+        }
+      else
+        {// finds intersections
+          A=(x2-x1)*(x2-x1)/(ctx->tissptr->ellip_rad_x*ctx->tissptr->ellip_rad_x)+
+            (y2-y1)*(y2-y1)/(ctx->tissptr->ellip_rad_y*ctx->tissptr->ellip_rad_y)+
+            (z2-z1)*(z2-z1)/(ctx->tissptr->ellip_rad_z*ctx->tissptr->ellip_rad_z);
+          B=2*(x2-x1)*(x1-ctx->tissptr->ellip_x)/(ctx->tissptr->ellip_rad_x*ctx->tissptr->ellip_rad_x)+
+            2*(y2-y1)*(y1-ctx->tissptr->ellip_y)/(ctx->tissptr->ellip_rad_y*ctx->tissptr->ellip_rad_y)+
+            2*(z2-z1)*(z1-ctx->tissptr->ellip_z)/(ctx->tissptr->ellip_rad_z*ctx->tissptr->ellip_rad_z);
+          C=(x1-ctx->tissptr->ellip_x)*(x1-ctx->tissptr->ellip_x)/(ctx->tissptr->ellip_rad_x*ctx->tissptr->ellip_rad_x)+
+            (y1-ctx->tissptr->ellip_y)*(y1-ctx->tissptr->ellip_y)/(ctx->tissptr->ellip_rad_y*ctx->tissptr->ellip_rad_y)+
+            (z1-ctx->tissptr->ellip_z)*(z1-ctx->tissptr->ellip_z)/(ctx->tissptr->ellip_rad_z*ctx->tissptr->ellip_rad_z)-
+            1.0;
+          if (B*B-4*A*C > 0)  // roots are real 
+            {
+              root1=(-B-sqrt(B*B-4*A*C))/(2*A);
+              root2=(-B+sqrt(B*B-4*A*C))/(2*A);
+              numint=0;             //number of intersections
+              if ((root1<1)&&(root1>0)) 
+                {
+                  numint+=1;
+                  root=root1;
+                }
+              if ((root2<1)&&(root2>0)) 
+                {
+                  numint+=1;
+                  root=root2;
+                }
+			  switch (numint) 
+                {
+                  case 0: /* roots real but no intersection */         
+					 hit=0;
+					 break;  					  
+                  case 1:
+					if ((one_in==3)&&(fabs(root)<1e-7))  // CKH FIX 11/10/08
+					{
+						 hit=0;
+					}
+					else
+					{
+						if (one_in==1)
+						{
+							hit=4;       //exiting the ellipse 
+						} 
+						else 
+						{
+							hit=2;       //entering it    
+						}
+						/*entering or exiting ellipsoid. It's the same*/
+						xto=x1+root*(x2-x1); 
+						yto=y1+root*(y2-y1);
+						zto=z1+root*(z2-z1);
+
+						/*distance to the boundary*/
+						dbound=sqrt((xto-x1)*(xto-x1)+
+                              (yto-y1)*(yto-y1)+
+                              (zto-z1)*(zto-z1));
+					
+						ctx->photptr->hit_bdry=1;        
+						ctx->photptr->sleft = (mut>0.0) ? (ctx->photptr->s - dbound)*mut : 0.0; 
+						ctx->photptr->s = dbound;
+                        
+					 }
+					 break;
+					 
+                  case 2:  /* went through ellipsoid: must stop at nearest intersection */
+                    /*wich is nearest?*/
+					if (one_in==3) {
+					  if (root1>root2) // CKH FIX 11/11/08
+					    root=root1;
+					  else root=root2;
+					}
+					else {
+					  if (root1<root2) // CKH FIX 11/11/08
+					    root=root1;
+					  else root=root2;
+					}
+					xto=x1+root*(x2-x1);  
+                    yto=y1+root*(y2-y1);
+                    zto=z1+root*(z2-z1);
+                    /*distance to the nearest boundary*/
+					dbound=sqrt((xto-x1)*(xto-x1)+
+                            (yto-y1)*(yto-y1)+
+                            (zto-z1)*(zto-z1));
+                    ctx->photptr->hit_bdry=1;        
+					ctx->photptr->sleft = (mut>0.0) ? (ctx->photptr->s - dbound)*mut : 0.0; 
+					ctx->photptr->s = dbound;
+					
+					hit=2;
+					break;
+					
+			  } /* end switch */
+    
+            } /* BB-4AC>0 */
+		  else /* roots imaginary -> no intersection */
+            {
+				hit=0;
+            } 
+	  } /* check on radial axis of ellipsoid */
+	} /* intersection with ellipsoid */
+  }
+  return hit;
+  }
+///***************************************************************/
+//short HitBoundary()
+//{
+//	short curr_layer = photptr->curr_layer;
+//	double zbegin = tissptr->layerprops[curr_layer].zbegin;
+//	double zend = tissptr->layerprops[curr_layer].zend;
+//	double dbound;  /* distance to boundary */
+//	double uz = photptr->uz;
+//	double s = photptr->s;
+//	double z = photptr->z;
+//	double mus = tissptr->layerprops[curr_layer].mus;
+//	double mua = tissptr->layerprops[curr_layer].mua;
+//	short hit;
+//
+//	if (uz<0.0)
+//		dbound = (zbegin-z)/uz;
+//	else if (uz>0.0)
+//		dbound = (zend-z)/uz;
+//
+//	if ((uz != 0.0) && (s>dbound)) {
+//		hit = 1;
+//		photptr->hit_bdry=1;
+//		photptr->sleft = (photptr->s - dbound)*(mua+mus); 
+//		photptr->s = dbound;
+//	}
+//	else hit = 0;
+//	return(hit);
+//	printf("HitBound: hit=%i\n",photptr->hit_bdry);
+//}
+
+/*****************************************************************/
+double Fresnel(double n1, double n2, double ci, double * uz_snell)
+{
+	/* n1 is the index of the current layer */
+	/* n2 is the index of the next layer */
+	double ct, si, st;  /* cos(thi), cos(tht), sin(thi), sin(tht) */
+	double cd, cs, sd, ss; /* cos(thi+tht), cos(thi-tht), etc */
+	double r;
+
+	if (n1==n2) {
+		*uz_snell = ci;
+		r = 0.0;
+	}
+	else if (ci>COSZERO) {     /* normal incidence */
+		*uz_snell = ci;
+		r = (n2-n1)*(n2-n1)/((n2+n1)*(n2+n1));
+	}
+	else if (ci<COS90D) {
+		*uz_snell = 0.0;
+		r = 1.0;
+	}
+	else {
+		si = sqrt(1-ci*ci);
+		st = n1/n2*si;
+		ct = sqrt(1-st*st);
+		*uz_snell = ct;
+
+		/* Use trig identities */
+		sd = si*ct - ci*st;
+		ss = si*ct + ci*st;
+		cd = ci*ct + si*st;
+		cs = ci*ct - si*st;
+		/* printf("cd= %12.4e    ss = %12.4e\n"); */
+		r = 0.5*(sd*sd/(ss*ss)+sd*sd*cs*cs/(cd*cd*ss*ss));
+	}
+
+	return(r);
+}
+
+/*****************************************************************/
+void Transmit(struct SimContext *ctx, double r)
+{
+	short ir,ia;
+	double x = ctx->photptr->x;
+	double y = ctx->photptr->y;
+	double dr = ctx->detector->dr;
+	double da = ctx->detector->da;
+
+	ir=(short)(sqrt(x*x+y*y)/dr);
+	if ( ir > ctx->detector->nr-1 )
+		ir = ctx->detector->nr-1;
+	ia=(short)(acos(ctx->photptr->uz)/da);
+	if ( ia > ctx->detector->na-1 )
+		ia = ctx->detector->na-1;
+
+	if ( ctx->photptr->uz <0 ) printf(">0!\n");
+
+	ctx->outptr->T_ra[ir][ia] += ctx->photptr->w*(1-r);
+	MOMENT_ADD(ctx,&ctx->outptr->T_ra[ir][ia],ctx->photptr->w*(1-r));
+	MOMENT_ADD(ctx,&ctx->outptr->T_r[ir],ctx->photptr->w*(1-r));	/* T_r, T_a are sums of T_ra */
+	MOMENT_ADD(ctx,&ctx->outptr->T_a[ia],ctx->photptr->w*(1-r));
+	if ((ctx->detptr!=NULL)&&!ctx->detector->reflect_flag)
+		ScoreDetectors(ctx,x,y,ctx->photptr->w*(1-r));
+	if (ctx->whiteptr!=NULL)
+		WhiteTransmit(ctx,ctx->photptr->w*(1-r));
+	ctx->photptr->w *= r;
+}
+
+/*****************************************************************/
+/* R(r,f): add w*exp(i*2*pi*f*t) at f=0,dfreq,2*dfreq,..; one     */
+/* sin/cos gives the rotation by 2*pi*dfreq*t, each frequency's   */
+/* phase factor is the previous one rotated once more             */
+static void ReflectFrequency(struct SimContext *ctx, short ir, double w, double t_delay)
+{
+	double *re=ctx->outptr->re_rw[ir], *im=ctx->outptr->im_rw[ir];
+	double dphi=2.0*PI*ctx->dfreq*1e-3*t_delay;	/* GHz*ps */
+	double c1=cos(dphi),s1=sin(dphi),c=1.0,s=0.0,tmp;
+	int k,nw=(int)ctx->outptr->nomega;
+
+	for (k=0;k<nw;++k) {
+		re[k]+=w*c;
+		im[k]+=w*s;
+		MOMENT_ADD(ctx,&re[k],w*c);
+		MOMENT_ADD(ctx,&im[k],w*s);
+		tmp=c*c1-s*s1;
+		s=s*c1+c*s1;
+		c=tmp;
+	}
+}
+
+/*****************************************************************/
+/* R(fx): add w*exp(-i*2*pi*fx*x) at fx=0,dfx,2*dfx,..; lane l    */
+/* starts at fx=l*dfx and is rotated FX_LANES frequencies at a    */
+/* time, so the lanes are independent and the inner loop          */
+/* vectorizes; two sin/cos per exit whatever nfx is               */
+static void ReflectSpatialFrequency(struct SimContext *ctx, double w, double x)
+{
+	double *re=ctx->R_fx_re, *im=ctx->R_fx_im;
+	double dphi=2.0*PI*ctx->dfx*10.0*x;	/* 1/mm*cm */
+	double c[FX_LANES],s[FX_LANES],cn,sn,tmp;
+	int k,l,nfx=ctx->nfx;
+
+	c[0]=1.0;
+	s[0]=0.0;
+	c[1]=cos(dphi);
+	s[1]=sin(dphi);
+	for (l=2;l<FX_LANES;++l) {
+		c[l]=c[l-1]*c[1]-s[l-1]*s[1];
+		s[l]=s[l-1]*c[1]+c[l-1]*s[1];
+	}
+	cn=cos(FX_LANES*dphi);
+	sn=sin(FX_LANES*dphi);
+
+	for (k=0;k+FX_LANES<=nfx;k+=FX_LANES) {
+		for (l=0;l<FX_LANES;++l) {
+			re[k+l]+=w*c[l];
+			im[k+l]-=w*s[l];
+			tmp=c[l]*cn-s[l]*sn;
+			s[l]=s[l]*cn+c[l]*sn;
+			c[l]=tmp;
+		}
+	}
+	for (l=0;k+l<nfx;++l) {
+		re[k+l]+=w*c[l];
+		im[k+l]-=w*s[l];
+	}
+	/* the same deposits for the second moments, one frequency at a */
+	/* time so that the loop above still vectorizes                 */
+	if (ctx->moments.on) {
+		cn=cos(dphi);
+		sn=sin(dphi);
+		c[0]=1.0;
+		s[0]=0.0;
+		for (k=0;k<nfx;++k) {
+			MomentAdd(ctx,&re[k],w*c[0]);
+			MomentAdd(ctx,&im[k],-w*s[0]);
+			tmp=c[0]*cn-s[0]*sn;
+			s[0]=s[0]*cn+c[0]*sn;
+			c[0]=tmp;
+		}
+	}
+}
+
+/*****************************************************************/
+void Reflect(struct SimContext *ctx, double r)// for index-mismatched reflections 
+{
+	double amt_out;
+	short ir,ia,it,nt=ctx->detector->nt; /* FIXED-DC added it,nt */ 
+
+	//DCFIX
+	short ix, iy; 
+
+	double w = ctx->photptr->w;
+	double x = ctx->photptr->x;
+	double y = ctx->photptr->y;
+	double dr = ctx->detector->dr;
+	double da = ctx->detector->da;  
+	
+	//DCFIX
+	double nx = ctx->detector->nx;  //=========================================
+	double ny = ctx->detector->ny;
+	double dx = ctx->detector->dx;
+	double dy = ctx->detector->dy;
+
+	double t_delay,dt=ctx->detector->dt;  /* FIXED-DC added t_delay,dt */
+
+	ir=(short)(sqrt(x*x+y*y)/dr);
+	if ( ir > ctx->detector->nr-1 )
+		ir = ctx->detector->nr-1;
+	ia=(short)(acos(ctx->photptr->uz)/da);
+	if ( ia > ctx->detector->na-1 )
+		ia = ctx->detector->na-1;
+
+	amt_out = (1-r)*w;
+	ctx->outptr->R_r[ir] += amt_out;
+	ctx->outptr->R_ra[ir][ia] += amt_out;
+	ctx->outptr->R_r2[ir] += amt_out*amt_out;
+	MOMENT_ADD(ctx,&ctx->outptr->R_r[ir],amt_out);
+	MOMENT_ADD(ctx,&ctx->outptr->R_ra[ir][ia],amt_out);
+	MOMENT_ADD(ctx,&ctx->outptr->R_a[ia],amt_out);	/* R_a is a sum of R_ra */
+	if ((ctx->detptr!=NULL)&&ctx->detector->reflect_flag)
+		ScoreDetectors(ctx,x,y,amt_out);
+	ctx->photptr->w *= r;  /* w=w*r is the amt internally reflected */
+	
+	/* FIXED-DC save R(r,t) */
+	t_delay=ctx->histptr->cum_path_length/(.03/
+		ctx->tissptr->layerprops[1].n);  /* -> ps */
+	it=(int)floor(t_delay/dt); /* assumes tmin=0 */
+	if ((it>nt-1)||(it<0)) it=-1; /* if outside [tmin,tmax] */
+	if (it!=-1) {
+		ctx->outptr->R_rt[ir][it]+=amt_out;
+		MOMENT_ADD(ctx,&ctx->outptr->R_rt[ir][it],amt_out);
+	} 
+	/* END FIX */
+	if (ctx->outptr->nomega>0)
+		ReflectFrequency(ctx,ir,amt_out,t_delay);
+	if (ctx->nfx>0)
+		ReflectSpatialFrequency(ctx,amt_out,x);
+	if (ctx->whiteptr!=NULL)
+		WhiteReflect(ctx,amt_out,ir,it);
+
+	//DCFIX (cartesian reflectance)
+	ix=(short)((x+nx*dx)/dx); /* added and checked*/
+	iy=(short)((y+ny*dy)/dy); /* added and checked*/
+
+  //printf("Reflect: x=%f ix=%d y=%f iy=%d\n",x,ix,y,iy); //=============    cancella
+  if ((ix < ctx->detector->nx*2-1) && (ix >= 0) &&
+      (iy < ctx->detector->ny*2-1) && (iy >= 0)) {
+    //printf("Reflect: ix=%d iy=%d amt_out=%f\n",ix,iy,amt_out);//=================    cancella
+    ctx->outptr->R_xy[ix][iy] += amt_out; /* added*/
+    MOMENT_ADD(ctx,&ctx->outptr->R_xy[ix][iy],amt_out);
+  }
+	ctx->photptr->dead=1;
+}
+/*****************************************************************/
+void CrossDown(struct SimContext *ctx)
+{
+	double r, uz_snell;
+	short curr_layer = ctx->photptr->curr_layer;
+	double uz = ctx->photptr->uz;
+	double n_curr = ctx->tissptr->layerprops[curr_layer].n;
+	double n_next = ctx->tissptr->layerprops[curr_layer+1].n;
+	double coscrit;
+
+	/* inclusions, voxels: layers are materials, the slab sits on the bottom medium */
+	if (ctx->tissptr->do_ellip_layer>=4)
+		n_next = ctx->tissptr->layerprops[ctx->tissptr->num_layers+1].n;
+
+	if (n_curr > n_next)
+		coscrit = sqrt(1.0-(n_next/n_curr)*(n_next/n_curr));
+	else coscrit = 0.0;
+
+	if (uz <= coscrit)
+		r = 1.0;
+	else {
+		r = Fresnel(n_curr, n_next, uz, &uz_snell);
+	}
+	//printf("CrossDown: curr_layer=%d\n",curr_layer);
+	/* Decide whether or not photon goes to next layer */
+	if (RandomNum(ctx) > r) {
+		/* transmitted to next layer */  // CKH FIX 11/11/08
+		if (((ctx->tissptr->do_ellip_layer<3)&&(curr_layer == ctx->tissptr->num_layers))
+		    ||((ctx->tissptr->do_ellip_layer>=3)&&(curr_layer == 1))
+		    ||(ctx->tissptr->do_ellip_layer==5)) 
+		{
+			/* call reflect with fixed weight photons! */
+			Transmit(ctx,0.0); 
+			ctx->photptr->dead = 1;
+			ctx->photptr->ux *= n_curr/n_next;
+			ctx->photptr->uy *= n_curr/n_next;
+			ctx->photptr->uz = uz_snell;
+		}
+		else {
+			ctx->photptr->curr_layer++;
+			ctx->photptr->ux *= n_curr/n_next;
+			ctx->photptr->uy *= n_curr/n_next;
+			ctx->photptr->uz = uz_snell;
+		}
+	} /* end if(RandomNum(ctx) */
+	else {
+		STATS_INC(ctx,fresnel_reflections);
+		ctx->photptr->uz = -uz;
+	}
+}
+
+/*****************************************************************/
+void CrossUp(struct SimContext *ctx)
+{
+	double r, uz_snell;
+	short curr_layer = ctx->photptr->curr_layer,index;
+	double uz = ctx->photptr->uz;
+	double n_curr = ctx->tissptr->layerprops[curr_layer].n;
+	double n_next = ctx->tissptr->layerprops[curr_layer-1].n;
+	double coscrit,x_curr,y_curr,z_curr;
+	/* voxels: any material can sit at the top surface */
+	int voxels = (ctx->tissptr->do_ellip_layer==5);
+
+	if (voxels)
+		n_next = ctx->tissptr->layerprops[0].n;
+
+	if (n_curr > n_next)
+		coscrit = sqrt(1.0-(n_next/n_curr)*(n_next/n_curr));
+	else coscrit = 0.0;
+
+	if (-uz <= coscrit) {
+		r = 1.0;
+	}
+	else {
+		r = Fresnel(n_curr, n_next, -uz, &uz_snell);
+	}
+
+	/* Decide on whether photon crosses into next layer */
+	if (RandomNum(ctx) > r) {    /* moves into next layer */
+		if ((curr_layer == 1)||voxels) { /* top layer-move out of tissue */
+			ctx->photptr->ux *= n_curr/n_next;
+			ctx->photptr->uy *= n_curr/n_next;
+			ctx->photptr->uz = uz_snell;
+
+			/* call reflect with fixed weight photons! */
+			Reflect(ctx,0.0); /* 0.0 b/c all or none refl */
+			ctx->photptr->dead = 1;
+		}
+		else {
+			ctx->photptr->curr_layer--;  /* moves across interface */
+			ctx->photptr->ux *= n_curr/n_next;
+			ctx->photptr->uy *= n_curr/n_next;
+			ctx->photptr->uz = -uz_snell;
+		}
+	}  /* end if(RandomNum(ctx) */
+	else {
+		STATS_INC(ctx,fresnel_reflections);
+		ctx->photptr->uz = -uz;
+	}
+}
+
+/*****************************************************************/
+void CrossLayer(struct SimContext *ctx)
+{
+	double uz = ctx->photptr->uz;
+	if (uz<0.0)
+		CrossUp(ctx);
+	else
+		CrossDown(ctx);
+}
+
+/*****************************************************************/
+void CrossEllip(struct SimContext *ctx)   //-----------------------------------------------------new
+/*based on CrossLayer, but without Fresnel (n doesn't change)=>no reflections at the boundary.*/
+{   
+  short curr_layer = ctx->photptr->curr_layer;
+  double n_curr, n_next;
+
+  if (curr_layer==2) 
+	  ctx->photptr->curr_layer--;
+  else
+	  ctx->photptr->curr_layer++;
+
+}
+
+/*****************************************************************/
+
+void Absorb(struct SimContext *ctx)
+{
+	double dw;
+	short ir,iz;
+	short curr_layer = ctx->photptr->curr_layer;
+	double mua = ctx->tissptr->layerprops[curr_layer].mua;
+	double mus = ctx->tissptr->layerprops[curr_layer].mus;
+	double w = ctx->photptr->w;
+	double x = ctx->photptr->x;
+	double y = ctx->photptr->y;
+	int index=ctx->histptr->num_pts_stored-1;
+
+	if (ctx->photptr->sleft==0.0)  // only deweight if real not pseudo collision
+	{
+		/* Compute array indices from r and z */
+		iz=(short)(ctx->photptr->z/ctx->detector->dz);
+		if (iz>ctx->detector->nz-1) iz=ctx->detector->nz-1;
+		ir=(short)(sqrt(x*x+y*y)/ctx->detector->dr);
+		if (ir>ctx->detector->nr-1) ir=ctx->detector->nr-1;
+
+		/* no cont abs wt change here since weight in post */
+		dw = w*mua/(mua+mus); 
+		ctx->photptr->w -= dw;
+		ctx->outptr->A_layer[curr_layer] += dw;
+		ctx->outptr->A_rz[ir][iz] += dw; 
+		MOMENT_ADD(ctx,&ctx->outptr->A_layer[curr_layer],dw);
+		MOMENT_ADD(ctx,&ctx->outptr->A_rz[ir][iz],dw);
+		MOMENT_ADD(ctx,&ctx->outptr->A_z[iz],dw);	/* A_z is a sum of A_rz */
+
+		/* update weight for history */
+		if (RECORD_HISTORY(ctx))
+			ctx->histptr->weight[index]=ctx->photptr->w;
+
+		if (ctx->flagptr->AbsWtType==0) // ANALOG=1;
+			ctx->photptr->dead=1;
+	}
+}
+
+/*****************************************************************/
+/* continuous absorption: exp(-mua*s) over a track of length s,  */
+/* deposited in the bin of the track's end point                 */
+void AbsorbAlongTrack(struct SimContext *ctx, double s)
+{
+	double dw;
+	short ir,iz;
+	short curr_layer = ctx->photptr->curr_layer;
+	double mua = ctx->tissptr->layerprops[curr_layer].mua;
+	double x = ctx->photptr->x;
+	double y = ctx->photptr->y;
+
+	iz=(short)(ctx->photptr->z/ctx->detector->dz);
+	if (iz>ctx->detector->nz-1) iz=ctx->detector->nz-1;
+	ir=(short)(sqrt(x*x+y*y)/ctx->detector->dr);
+	if (ir>ctx->detector->nr-1) ir=ctx->detector->nr-1;
+
+	dw = ctx->photptr->w*(1.0-exp(-mua*s));
+	ctx->photptr->w -= dw;
+	ctx->outptr->A_layer[curr_layer] += dw;
+	ctx->outptr->A_rz[ir][iz] += dw;
+	MOMENT_ADD(ctx,&ctx->outptr->A_layer[curr_layer],dw);
+	MOMENT_ADD(ctx,&ctx->outptr->A_rz[ir][iz],dw);
+	MOMENT_ADD(ctx,&ctx->outptr->A_z[iz],dw);
+}
+
+/*****************************************************************/
+void Scatter_Or_Absorb(struct SimContext *ctx)
+{
+	double RN;
+
+	RN=RandomNum(ctx);
+	if (RN<ctx->tissptr->layerprops[ctx->photptr->curr_layer].albedo)
+		Scatter(ctx);
+	else
+		Absorb(ctx);
+}
+
+/*****************************************************************/
+void Test_Distance(struct SimContext *ctx)
+{
+	/* kill photon if it has gone too far */
+	if(ctx->histptr->cum_path_length>=ctx->photptr->max_path_length)
+		ctx->photptr->dead=1;
+}
+
+/*****************************************************************/
+/* unbiased: survivors of the current layer's prr carry w/prr */
+void Roulette(struct SimContext *ctx)
+{
+	double prr = ctx->pertptr->layer_prr[ctx->photptr->curr_layer];
+
+	if (ctx->photptr->w == 0.0)
+		ctx->photptr->dead = 1;
+	else if (RandomNum(ctx) < prr)
+		ctx->photptr->w /= prr;
+	else ctx->photptr->dead = 1;
+	if (ctx->photptr->dead)
+		++ctx->pertptr->tot_rouletted;
+}
+
+/*****************************************************************/
+void TestWeight(struct SimContext *ctx)
+{
+	double w = ctx->photptr->w;
+
+	/* with a mua table the photon weighs as much as its least absorbed set */
+	if (ctx->whiteptr!=NULL)
+		w *= ctx->whiteptr->max_atten;
+	if ((ctx->flagptr->AbsWtType!=0) && (ctx->photptr->dead!=1) &&
+		(w < ctx->pertptr->layer_wt_cut[ctx->photptr->curr_layer]))
+		Roulette(ctx);
+	/* the History arrays hold MAX_HISTORY_PTS points; unrecorded */
+	/* photons have no such limit                                 */
+	if(RECORD_HISTORY(ctx) && (ctx->histptr->num_pts_stored >= MAX_HISTORY_PTS-4))
+	{
+		STATS_INC(ctx,history_kills);
+		ctx->photptr->dead=1;
+		printf("WARNING: MAX_HISTORY_PTS reached. Killing this photon\n"); 
+	}
+}
+
+/*****************************************************************/
+
+
+/********************************************************/
+void FreeVector(double *v,short nl,short nh)
+{
+	free((char*) (v+nl));
+}
+
+/***********************************************************
+*      Release the memory.
+****/
+void FreeMatrix(double **m,short nrl,short nrh,
+				short ncl,short nch)
+{
+	free(MatrixInfoOf(m,nrl)->block);
+}
+
+/********************************************************/
+void FreeMemory(struct SimContext *ctx)
+{
+	struct TallyArena *arena=ctx->tally_arena;
+
+	/* every AllocTallies() array, R_xy included, lives in the arena */
+	if (arena!=NULL) {
+		free(arena->block);
+		free(arena);
+		ctx->tally_arena=NULL;
+	}
+
+	//histptr->xh = AllocVector(0,MAX_HISTORY_PTS);
+	//histptr->yh = AllocVector(0,MAX_HISTORY_PTS);
+	//histptr->zh = AllocVector(0,MAX_HISTORY_PTS);
+	//histptr->uxh = AllocVector(0,MAX_HISTORY_PTS);
+ //   histptr->uyh = AllocVector(0,MAX_HISTORY_PTS);
+ //   histptr->uzh = AllocVector(0,MAX_HISTORY_PTS);
+ //   histptr->weight = AllocVector(0,MAX_HISTORY_PTS);
+ //   histptr->pert_wt = AllocVector(0,MAX_HISTORY_PTS); // CKH degrade pert_wt from [3,MAX_HISTORY_PTS]
+ //   histptr->path_length = AllocVector(0,MAX_HISTORY_PTS);
+ //   histptr->boundary_col = ivector(0,MAX_HISTORY_PTS);
+ 
+	/*  free_d3tensor(ctx->outptr->Banana,0,ctx->detector->nx-1,0,ctx->detector->nz-1,
+	*	0,ctx->detector->nt-1);*/
+}
+
+/*********************************************************/
+void Scatter1D(struct SimContext *ctx)
+{
+	short curr_layer = ctx->photptr->curr_layer;
+	double g = ctx->tissptr->layerprops[curr_layer].g;
+
+	if(RandomNum(ctx) < ((1+g)/2.0) )
+		ctx->photptr->uz *= 1.0;
+	else
+		ctx->photptr->uz *= -1.0;
+}
+
@@ -1,184 +1,381 @@
-#ifdef __cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
-#include<stdio.h>
-
-#define MAX_HISTORY_PTS 300000
-#define PI 3.141592654
-#define C_CM 3e10 /* speed of light in cm/s */
-#define MAX_COORD 30.0
-#define FACTOR 1e3 /* The resolution is defined as (1e-2)/FACTOR */
-#define MAX_NUM_LAYERS 14
-#define MAX_DET 10
-
-  struct Layer{
-    double n;
-    double mua;
-    double mus;
-    double albedo;
-    double g;
-    double d;
-    double zbegin, zend;
-	double scatter_length; // DAW/CAW add
-  };
-
-    struct Flags{
-	  int Seed;
-	  int AbsWtType;
-  };
-
-  struct History{
-    double *xh; /* CKH FIX */
-	double *yh;
-    double *zh;
-    double *uxh;
-    double *uyh;
-    double *uzh;
-    double *weight;
-	double *pert_wt; // CKH degrade pert_wt from [3,MAX_HISTORY_PTS]
-    double *path_length;
-    int *boundary_col;
-    int num_pts_stored;
-    double cum_path_length;
-  };
-
-  struct Photon{
-    double x,y,z;
-    double ux, uy, uz;
-    double s;
-    double sleft; /* remaining step size when photon hits boundary */
-    short dead;
-    double w;
-    double Rspec;			/* Specular reflectance */   
-    double max_path_length;
-    //struct str_history history;
-    short hit_bdry;
-	short curr_layer;		/* index for layerprops */
-	//struct Layer *layerprops;	/* CKH FIX pointer to Layer structure */
-    double *num_photons_written; /* CKH FIX */
-	int curr_n; // CKH added 12/6
-  };
-  
-  struct DetectorDefinition{	  
-    double dz, dr, da, dt, dx, dy;
-    short nz, nr, na, nt, nx, ny;
-
-	/* detector data */
-	int reflect_flag;  /* 1=reflect 0=transmit */
-	/* number of x-axis bins */
-	double det_ctr[MAX_DET];
-	double det_rad;
-	double det_NA;  
-  };
-
-  struct SourceDefinition{	  
-    int num_photons;  /* CKH FIX */
-	double beam_radius;
-    double beam_center_x;
-    char *beamtype; /* CKH FIX */
-    double src_NA;
-  };
-
-  struct Tissue{
-	int do_ellip_layer;  /* 0=nopert 1=pert:ellip 2=pert:layer 3=nopert:ellip */ 
-	/* ellipsoid data */
-	/* center position */
-	double ellip_x, ellip_y, ellip_z;
-	/* radius dimensions */
-	double ellip_rad_x, ellip_rad_y, ellip_rad_z;
-	/* layer info */
-	double layer_z_min, layer_z_max;
-    short num_layers;
-    double z_focus;    /* focus depth */
-    double NA;         /* NA */
-    double cylinder_radius,cylinder_height;
-    double zup,zlow;
-	struct Layer *layerprops;	/* CKH FIX pointer to Layer structure *
-  };
-  
-  struct OutputHeaderInfo{
-    struct Layer layerprops[MAX_NUM_LAYERS];
-    long num_photons;
-    short num_layers;
-    double det_rmin,det_rmax,det_radius;
-    short Absorption_Weighting_Used; /* flag for absorption weighting */
-  };
-  
-  struct Output{
-    double **A_rz;
-    double *A_z;
-    double *A_layer;
-    double Atot;
-    double **Flu_rz;
-    double *Flu_z;
-    double **R_ra;
-    double *R_r, *R_a, *R_r2; 
-    double **R_xy,**T_ra;
-    double *T_r, *T_a;
-    double Rd,Rtot;
-    double Td;
-    double **R_rt;
-    double wt_pathlen_out_top;
-    double wt_pathlen_out_bot;
-    double wt_pathlen_out_sides;
-    double ****in_side_allvox,****out_side_allvox; /* FIX added */
-    //double ****in_side2_allvox,****out_side2_allvox; /* FIX added */ 
-	double** Amp_rw, Phase_rw, re_rw, im_rw;
-	double* path_length_in_layer;
-	double** R0_rt; // Method DC
-    double*** D_rt_layer; // Method DC
-
-    double nomega;
-    double cramer_wt;
-    double Rconv,Rconv2;
-    int num_visit_conv,num_visit;
-    //FILE *cramer_start;
-    FILE *binary_file[MAX_DET];
-    //FILE *text_file;
-  };
-
-//typedef struct Photon PHOTON;
-//typedef struct Tissue TISSUE;
-//typedef struct Output OUTPUT;
-//typedef struct perturb PERTURB;
-
-  /*void UpdateBar(GtkWidget *, long);*/
-void ReadInput(FILE *);
-void DisplayInput();
-void initialize(char* inFileName);
-void DisplayIntro(void);
-void DisplayStatus(long, long);
-void Scatter(void);
-void init_photon(void);
-void init_photon_cramer(void);
-void SetStepSize(void);
-short HitBoundary(void);
-void CrossLayer(void);
-
-//DCFIX
-short HitLayer(void);
-short HitEllip(void);
-void CrossEllip(void); //========================
-
-void Move_Photon(void);
-void Absorb(void);
-void Scatter_Or_Absorb(void);
-void TestWeight(void);
-void FreeMemory(void);
-void Test_Distance(void);
-void TestWeight(void);
-void Scatter1D(void);
-
-void SaveResults(void);
-
-//__declspec(dllexport) void initialize_from_external(PHOTON *photptr_ex, TISSUE *tissptr_ex, OUTPUT *outptr_ex, PERTURB *pertptr_ex);
-void RunMCCHInternal(char* inFileName);
-void RunMCLoop(void);
-__declspec(dllexport) void RunMCLoopExternal(struct Photon *photptr_ex, struct Tissue *tissptr_ex, struct perturb *pertptr_ex, struct Output *outptr_ex);
-//__declspec(dllexport) void RunMCLoop();
-
-#ifdef __cplusplus
-}
-#endif /* __cplusplus */
-
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include<stdio.h>
+
+#define MAX_HISTORY_PTS 300000
+#define PI 3.141592654
+#define C_CM 3e10 /* speed of light in cm/s */
+#define MAX_COORD 30.0
+#define FACTOR 1e3 /* The resolution is defined as (1e-2)/FACTOR */
+#define MAX_DET 10
+#define TALLY_ALIGN 64 /* byte alignment of tally rows and vectors */
+
+  struct Layer{
+    double n;
+    double mua;
+    double mus;
+    double albedo;
+    double g;
+    double d;
+    double zbegin, zend;
+	double scatter_length; // DAW/CAW add
+  };
+
+    struct Flags{
+	  int Seed;
+	  int AbsWtType;	/* ABS_ANALOG, ABS_DISCRETE or ABS_CONTINUOUS */
+	  int NumThreads;	/* worker threads for RunMCLoop: 0=all cores, 1=serial */
+	  int RngType;	/* RNG_RAN3 or RNG_PHILOX */
+	  int TransportEngine;	/* ENGINE_SCALAR or ENGINE_BATCH */
+	  int Allvox;	/* ALLVOX_OFF, ALLVOX_HISTORY or ALLVOX_STREAM */
+	  int Tracking;	/* TRACK_SURFACE or TRACK_DELTA */
+	  int TallySecondMoment;	/* 1=per-photon second moments and relative errors */
+  };
+
+#define ABS_ANALOG 0	/* absorb or scatter at each collision */
+#define ABS_DISCRETE 1	/* deweight by mua/mut at each collision (DAW) */
+#define ABS_CONTINUOUS 2	/* steps sampled with mus, exp(-mua*s) along tracks (CAW) */
+
+#define RNG_RAN3 0	/* legacy single stream, results depend on thread count */
+#define RNG_PHILOX 1	/* one stream per photon, same results on any thread count */
+
+#define ENGINE_SCALAR 0	/* one photon at a time */
+#define ENGINE_BATCH 1	/* SIMD photon batches, layered tissue only (mc_batch.c) */
+
+#define ALLVOX_OFF 0	/* no allvox scoring */
+#define ALLVOX_HISTORY 1	/* score from the History arrays after each photon */
+#define ALLVOX_STREAM 2	/* score each track as it is taken, no History arrays */
+
+#define TRACK_SURFACE 0	/* stop at every boundary (HitLayer, HitEllip, ...) */
+#define TRACK_DELTA 1	/* Woodcock tracking, stop only at Fresnel surfaces (mc_delta.c) */
+
+/* History arrays are only filled for the consumers that read them back */
+#define RECORD_HISTORY(ctx) ((ctx)->flagptr->Allvox==ALLVOX_HISTORY)
+
+#ifdef _MSC_VER
+  typedef unsigned __int64 PHILOX_U64;
+  typedef unsigned __int64 STATS_U64;
+#else
+  typedef unsigned long long PHILOX_U64;
+  typedef unsigned long long STATS_U64;
+#endif
+
+  struct PhiloxState{	/* Philox4x32 stream of the photon being traced */
+    unsigned int key[2];	/* seed */
+    unsigned int ctr[4];	/* [0],[1] block counter, [2],[3] photon index */
+    double buf[4];	/* numbers of the current block */
+    int next;	/* next unused entry of buf */
+  };
+
+  struct Ran3State{	/* state of ran3(), was function statics */
+    int inext,inextp;
+    long ma[56];
+    int iff;
+    int idum;	/* seed for ran3 */
+    int first_time;
+  };
+
+  struct VoxVisit{	/* one voxel entered by the photon being traced */
+    int ix,iy,iz;
+    int col;	/* track index */
+    int sa_idx;	/* face entered through */
+  };
+
+  struct VoxVisitBuffer{	/* growable, reused photon to photon */
+    struct VoxVisit *rec;	/* rec[0..num-1] in the order entered */
+    int num,cap;
+    int record;	/* 1 = Score_Track_allvox appends every voxel entered ("visits on") */
+  };
+
+  struct AllvoxTrack{	/* allvox scoring state of the photon being traced */
+    int in_layer;
+    int dead;
+    int bdry_col;
+    int ix,iy,iz,side;
+    int ktrk;	/* tracks scored so far */
+    double mu;
+    double phot_disc_wt;
+    struct VoxVisitBuffer visits;	/* emptied by Start_Track_allvox */
+  };
+
+  struct DeltaTrack{	/* Woodcock tracking, set up by SetupDelta() */
+    int on;
+    double mut_max;	/* majorant of StepMut() over layers 1..num_layers */
+    double inv_mut_max;
+    /* Fresnel surfaces above and below each layer, [0..num_layers+1]; */
+    /* the tissue surfaces for inclusions and voxels                   */
+    double *z_up, *z_down;
+  };
+
+  struct LayerTable{	/* per-layer constants of a run, see SetupLayerTable() */
+    int num_layers;
+    double *zb;	/* [0..num_layers] sorted boundaries, layer i is zb[i-1]..zb[i] */
+    double *mut;	/* [0..num_layers+1] StepMut() of each layer */
+    double *inv_mut;	/* 1/mut */
+  };
+
+#define MOMENT_REGIONS 4	/* tally arena, allvox block, detector tallies, white MC block */
+#define MOMENT_RD 0	/* photon totals in MomentTrack.tot */
+#define MOMENT_TD 1
+#define MOMENT_ATOT 2
+
+  struct MomentTrack{	/* per-photon second moments, see mc_moment.c */
+    int on;
+    double *base[MOMENT_REGIONS];	/* first tally double of each region */
+    size_t num[MOMENT_REGIONS];	/* doubles in it */
+    size_t first[MOMENT_REGIONS];	/* its first slot */
+    size_t num_slots;
+    double *photon;	/* [num_slots] deposits of the photon being traced */
+    double *sum2;	/* [num_slots] sum over photons of photon^2, relative errors after MomentsToRelErr() */
+    size_t *touched;	/* slots this photon deposited in */
+    size_t num_touched, cap_touched;
+    double tot[3];	/* this photon's Rd, Td, Atot */
+    double tot2[3];	/* their squares summed, relative errors after MomentsToRelErr() */
+  };
+
+#define STATS_INIT 0	/* phases timed in EventStats.seconds */
+#define STATS_RUN 1
+#define STATS_ALLVOX 2
+#define STATS_NORMALIZE 3
+#define STATS_OUTPUT 4
+#define STATS_PHASES 5
+#define STATS_STEP_BINS 20	/* bin k: 2^k..2^(k+1)-1 steps, past MAX_HISTORY_PTS */
+
+  struct EventStats{	/* physics event counters and phase times, see mc_stats.c */
+    STATS_U64 photons;
+    STATS_U64 collisions;	/* real ones, Absorb/Scatter */
+    STATS_U64 virtual_collisions;	/* delta tracking */
+    STATS_U64 boundary_hits;	/* steps cut short by a layer boundary */
+    STATS_U64 fresnel_reflections;	/* internal reflections at layer boundaries */
+    STATS_U64 region_crossings;	/* ellipsoid, inclusion or voxel boundaries */
+    STATS_U64 history_kills;	/* photons killed at MAX_HISTORY_PTS */
+    STATS_U64 steps[STATS_STEP_BINS];	/* photons by steps in their history */
+    double start[STATS_PHASES];	/* WallSeconds() when the phase began */
+    double seconds[STATS_PHASES];	/* summed over threads for STATS_ALLVOX */
+    int threads;
+  };
+
+  struct History{
+    double *xh; /* CKH FIX */
+	double *yh;
+    double *zh;
+    double *uxh;
+    double *uyh;
+    double *uzh;
+    double *weight;
+	double *pert_wt; // CKH degrade pert_wt from [3,MAX_HISTORY_PTS]
+    double *path_length;
+    int *boundary_col;
+    int num_pts_stored;
+    double cum_path_length;
+  };
+
+  struct Photon{
+    double x,y,z;
+    double ux, uy, uz;
+    double s;
+    double sleft; /* remaining step size when photon hits boundary */
+    short dead;
+    double w;
+    double Rspec;			/* Specular reflectance */   
+    double max_path_length;
+    //struct str_history history;
+    short hit_bdry;
+	short curr_layer;		/* index for layerprops */
+	//struct Layer *layerprops;	/* CKH FIX pointer to Layer structure */
+    double *num_photons_written; /* CKH FIX */
+	int curr_n; // CKH added 12/6
+  };
+  
+  struct DetectorDefinition{	  
+    double dz, dr, da, dt, dx, dy;
+    short nz, nr, na, nt, nx, ny;
+
+	/* detector data */
+	int reflect_flag;  /* 1=reflect 0=transmit */
+	double det_rad;
+	double det_NA;  
+  };
+
+  struct SourceDefinition{	  
+    int num_photons;  /* CKH FIX */
+	double beam_radius;
+    double beam_center_x;
+    char *beamtype; /* CKH FIX */
+    double src_NA;
+  };
+
+  struct Tissue{
+	int do_ellip_layer;  /* 0=nopert 1=pert:ellip 2=pert:layer 3=nopert:ellip 4=nopert:inclusions 5=nopert:voxels */ 
+	/* ellipsoid data */
+	/* center position */
+	double ellip_x, ellip_y, ellip_z;
+	/* radius dimensions */
+	double ellip_rad_x, ellip_rad_y, ellip_rad_z;
+	/* layer info */
+	double layer_z_min, layer_z_max;
+    short num_layers;
+    double z_focus;    /* focus depth */
+    double NA;         /* NA */
+    double cylinder_radius,cylinder_height;
+    double zup,zlow;
+	struct Layer *layerprops;	/* CKH FIX pointer to Layer structure, num_layers+2 entries */
+  };
+  
+  struct OutputHeaderInfo{
+    struct Layer *layerprops;	/* num_layers+2 entries */
+    long num_photons;
+    short num_layers;
+    double det_rmin,det_rmax,det_radius;
+    short Absorption_Weighting_Used; /* flag for absorption weighting */
+  };
+  
+  struct MatrixInfo{	/* in front of every AllocMatrix() view, see MatrixInfoOf() */
+    int rows, cols;
+    int stride;	/* doubles from one row to the next, cols rounded up to TALLY_ALIGN */
+    double *data;	/* rows*stride contiguous doubles, TALLY_ALIGN aligned */
+    void *block;	/* what FreeMatrix() releases, NULL inside the tally arena */
+  };
+
+  struct Output{
+    double **A_rz;
+    double *A_z;
+    double *A_layer;
+    double Atot;
+    double **Flu_rz;
+    double *Flu_z;
+    double **R_ra;
+    double *R_r, *R_a, *R_r2; 
+    double **R_xy,**T_ra;
+    double *T_r, *T_a;
+    double Rd,Rtot;
+    double Td;
+    double **R_rt;
+    double wt_pathlen_out_top;
+    double wt_pathlen_out_bot;
+    double wt_pathlen_out_sides;
+    double *in_side_allvox,*out_side_allvox; /* FIX added, indexed by ALLVOX_IDX() */
+    double *visits_allvox; /* photons that entered each voxel, by VOX_IDX(); NULL unless visits.record */
+    //double ****in_side2_allvox,****out_side2_allvox; /* FIX added */ 
+	double **Amp_rw, **Phase_rw, **re_rw, **im_rw; /* R(r,f) [nr][nomega], see ReflectFrequency() */
+	double* path_length_in_layer;
+	double** R0_rt; // Method DC
+    double*** D_rt_layer; // Method DC
+
+    double nomega;	/* number of modulation frequencies, 0=no R(r,f) */
+    double cramer_wt;
+    double Rconv,Rconv2;
+    int num_visit_conv,num_visit;
+    //FILE *cramer_start;
+    FILE *binary_file[MAX_DET];
+    //FILE *text_file;
+  };
+
+  /* one simulation: every transport, tally and output routine takes this */
+  struct SimContext{
+    struct Photon *photptr;
+    struct Tissue *tissptr;
+    struct Output *outptr;
+    struct perturb *pertptr;
+    struct History *histptr;
+    struct Flags *flagptr;
+    struct SourceDefinition *source;
+    struct DetectorDefinition *detector;
+    struct bvolume *bananaptr;
+    struct Ran3State rng;
+    struct PhiloxState prng;
+    struct AllvoxTrack allvox_trk;
+    struct TallyArena *tally_arena;	/* single block behind outptr's arrays */
+    struct WhiteMC *whiteptr;	/* absorption rescaling, NULL when off (mc_white.c) */
+    struct InclusionSet *inclptr;	/* inclusions, NULL when off (mc_incl.c), shared by workers */
+    int curr_incl;	/* inclusion holding the photon, -1 in the slab */
+    int next_incl;	/* where CrossIncl() takes it */
+    struct VoxelGrid *voxptr;	/* voxel tissue, NULL when off (mc_voxel.c), shared by workers */
+    struct LayerTable layers;	/* shared by workers */
+    struct DeltaTrack delta;	/* shared by workers */
+    struct MomentTrack moments;	/* own per context */
+    struct EventStats stats;	/* own per context, workers' are added to the master's */
+    struct DetectorSet *detptr;	/* exit surface detectors, NULL when none (mc_detect.c), shared by workers */
+    double *det_wt;	/* [detptr->num] weight collected by each detector */
+    double dfreq;	/* GHz, R(r,f) is at f=0,dfreq,..,(nomega-1)*dfreq */
+    short nfx;	/* number of spatial frequencies, 0=no R(fx) */
+    double dfx;	/* 1/mm, R(fx) is at fx=0,dfx,..,(nfx-1)*dfx */
+    double *R_fx_re, *R_fx_im;	/* [nfx] R(fx), in the tally arena */
+    struct ConvStop *conv;	/* batches until converged, NULL runs num_photons (mc_conv.c) */
+    struct Checkpoint *ckpt;	/* checkpoint and resume files, NULL when none (mc_ckpt.c) */
+    int worker;	/* 1..num_threads in a threaded run, 0 for the master */
+  };
+
+//typedef struct Photon PHOTON;
+//typedef struct Tissue TISSUE;
+//typedef struct Output OUTPUT;
+//typedef struct perturb PERTURB;
+
+  /*void UpdateBar(GtkWidget *, long);*/
+void ReadInput(struct SimContext *, FILE *);
+void DisplayInput();
+struct SimContext *AllocSimContext(void);
+void AllocHistory(struct History *);
+void initialize(struct SimContext *, char* inFileName);
+void AllocTallies(struct SimContext *);
+double *AllocVector(short, short);
+double **AllocMatrix(short, short, short, short);
+struct MatrixInfo *MatrixInfoOf(double **, short);
+void FreeVector(double *, short, short);
+void FreeMatrix(double **, short, short, short, short);
+void DisplayIntro(void);
+void DisplayStatus(long, long);
+void Scatter(struct SimContext *);
+void init_photon(struct SimContext *);
+void init_photon_cramer(struct SimContext *);
+double StepMut(struct SimContext *, short);
+double *TallyArenaSpan(struct SimContext *, size_t *);
+void SetupLayerTable(struct SimContext *);
+void FreeLayerTable(struct SimContext *);
+short LayerAt(struct SimContext *, double);
+void SetStepSize(struct SimContext *);
+short HitBoundary(struct SimContext *);
+void CrossLayer(struct SimContext *);
+void CrossUp(struct SimContext *);
+void CrossDown(struct SimContext *);
+double Fresnel(double, double, double, double *);
+
+//DCFIX
+short HitLayer(struct SimContext *);
+short HitEllip(struct SimContext *);
+void CrossEllip(struct SimContext *); //========================
+
+void Move_Photon(struct SimContext *);
+void Absorb(struct SimContext *);
+void AbsorbAlongTrack(struct SimContext *, double);
+void Scatter_Or_Absorb(struct SimContext *);
+void TestWeight(struct SimContext *);
+void FreeMemory(struct SimContext *);
+void Test_Distance(struct SimContext *);
+void Scatter1D(struct SimContext *);
+
+void SaveResults(struct SimContext *);
+
+//__declspec(dllexport) void initialize_from_external(PHOTON *photptr_ex, TISSUE *tissptr_ex, OUTPUT *outptr_ex, PERTURB *pertptr_ex);
+void RunMCCHInternal(char* inFileName, char* muaFileName, char* inclFileName,
+					 char* voxFileName, char* detFileName);
+void MergeMCCHInternal(char* inFileName, char* muaFileName, char* inclFileName,
+					   char* voxFileName, char* detFileName, int numShards, char** shardFileNames);
+void BenchMCCHInternal(int numInFiles, char** inFileNames, char* muaFileName,
+					   char* inclFileName, char* voxFileName, char* detFileName);
+void RunMCLoop(struct SimContext *);
+void RunPhotonRange(struct SimContext *, int, int);
+__declspec(dllexport) struct SimContext *CreateSimContext(char* inFileName);
+__declspec(dllexport) void RunSimContext(struct SimContext *);
+__declspec(dllexport) void FreeSimContext(struct SimContext *);
+__declspec(dllexport) void RunMCLoopExternal(struct Photon *photptr_ex, struct Tissue *tissptr_ex,
+	struct SourceDefinition *source_ex, struct Output *outptr_ex, struct History *histptr_ex, struct Flags *flagptr_ex,
+	struct DetectorDefinition *detector_ex);
+//__declspec(dllexport) void RunMCLoop();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
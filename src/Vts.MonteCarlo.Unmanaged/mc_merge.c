@@ -0,0 +1,62 @@
+/* Merging the raw output of independent runs ("shards").
+*
+*  Each shard is a Philox run of the same input, tallies and files
+*  with its own "seed" line and a "checkpoint" line, whose final
+*  checkpoint (mc_ckpt.c) holds its raw tallies, second-moment sums
+*  and photon count. MergeSimContext() adds any number of them into
+*  a context that was set up from that input but not run, sets
+*  num_photons to their total and writes the results as SaveResults()
+*  does for a run: they are normalized once, so the means and the
+*  relative errors are those of one run of all the photons.
+*
+*  ran3 ignores Flags.Seed, so ran3 shards are copies of each other,
+*  and two Philox shards with one seed trace the same photons; both
+*  are refused. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "mc_main.h"
+#include "mc_moment.h"
+#include "mc_ckpt.h"
+#include "mc_merge.h"
+
+/*****************************************************************/
+/* sum the shards in files[0..num_files-1] into ctx and save them */
+__declspec(dllexport) void MergeSimContext(struct SimContext *ctx, int num_files, char **files)
+{
+	int *seed;
+	int rng_type,photons,total=0,k,j;
+
+	seed=(int *)malloc(((num_files>0) ? num_files : 1)*sizeof(int));
+	if (seed==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	/* the tables SaveResults() looks up, as RunMCLoop() sets them up */
+	SetupLayerTable(ctx);
+	SetupMoments(ctx);
+	for (k=0;k<num_files;++k) {
+		photons=AddCheckpoint(ctx,files[k],&rng_type,&seed[k]);
+		if (rng_type!=RNG_PHILOX) {
+			printf("\nERROR - shard %s is a ran3 run: only Philox runs with different seeds can be merged\n",files[k]);
+			exit(0);
+		}
+		for (j=0;j<k;++j)
+			if (seed[j]==seed[k]) {
+				printf("\nERROR - shards %s and %s both have seed %d\n",files[j],files[k],seed[k]);
+				exit(0);
+			}
+		if (photons>INT_MAX-total) {
+			printf("\nERROR - shards hold more than %d photons\n",INT_MAX);
+			exit(0);
+		}
+		total+=photons;
+		printf("shard %s: %d photons, seed %d\n",files[k],photons,seed[k]);
+	}
+	free(seed);
+	ctx->source->num_photons=total;
+	printf("merged %d shards: %d photons\n",num_files,total);
+
+	SaveResults(ctx);
+}
@@ -0,0 +1,11 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+__declspec(dllexport) void MergeSimContext(struct SimContext *, int, char **);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
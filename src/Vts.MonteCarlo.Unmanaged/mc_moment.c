@@ -0,0 +1,268 @@
+/* Per-photon second moments of the tallies, Flags.TallySecondMoment.
+*
+*  Every double of the tally arena, of the allvox block, of det_wt and
+*  of the white MC block has a slot in photon[] and sum2[]. MomentAdd() adds a deposit to
+*  the photon's slot and lists the slot the first time it is hit;
+*  MomentEndPhoton() squares each listed slot into sum2[] and clears
+*  it, so a bin that one photon deposits in several times counts as a
+*  single sample and the work follows the bins a photon touches, not
+*  the size of the tallies. Before the tallies are normalized,
+*  MomentsToRelErr() turns sum2[] into the relative standard error of
+*  the mean, which does not change when a tally is scaled.
+*  Rd, Td and Atot are summed per photon from the R_ra, T_ra and
+*  A_layer slots it touched. The complex tallies R(r,f) and R(fx)
+*  take one sample per part, see RelErrComplex(). */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "mc_main.h"
+#include "mc_v.h"
+#include "mc_detect.h"
+#include "mc_white.h"
+#include "mc_moment.h"
+
+#define MOMENT_REGION_ARENA 0
+#define MOMENT_REGION_ALLVOX 1
+#define MOMENT_REGION_DET 2
+#define MOMENT_REGION_WHITE 3
+
+/*****************************************************************/
+/* slot of tally double p */
+static size_t MomentSlot(const struct MomentTrack *mt, const double *p)
+{
+	int k;
+
+	for (k=0;k<MOMENT_REGIONS;++k)
+		if ((p>=mt->base[k])&&(p<mt->base[k]+mt->num[k]))
+			return mt->first[k]+(size_t)(p-mt->base[k]);
+	printf("\nERROR - second moment of a double that is not a tally\n");
+	exit(0);
+	return 0;
+}
+
+/*****************************************************************/
+/* [lo,hi) of a matrix's doubles */
+static void MatrixSpan(double **m, const double **lo, const double **hi)
+{
+	struct MatrixInfo *info=MatrixInfoOf(m,0);
+
+	*lo=info->data;
+	*hi=info->data+(size_t)info->rows*info->stride;
+}
+
+/*****************************************************************/
+/* size the slots to ctx's tallies; call once they are allocated */
+void SetupMoments(struct SimContext *ctx)
+{
+	struct MomentTrack *mt=&ctx->moments;
+	size_t n;
+	int k;
+
+	FreeMoments(ctx);
+	if (!ctx->flagptr->TallySecondMoment||(ctx->tally_arena==NULL))
+		return;
+
+	mt->base[MOMENT_REGION_ARENA]=TallyArenaSpan(ctx,&mt->num[MOMENT_REGION_ARENA]);
+	if (ctx->bananaptr!=NULL) {
+		mt->base[MOMENT_REGION_ALLVOX]=ctx->outptr->in_side_allvox;
+		mt->num[MOMENT_REGION_ALLVOX]=2*ctx->bananaptr->num_vox*ALLVOX_STRIDE;
+	}
+	if (ctx->detptr!=NULL) {
+		mt->base[MOMENT_REGION_DET]=ctx->det_wt;
+		mt->num[MOMENT_REGION_DET]=ctx->detptr->num;
+	}
+	if (ctx->whiteptr!=NULL) {
+		mt->base[MOMENT_REGION_WHITE]=ctx->whiteptr->tally;
+		mt->num[MOMENT_REGION_WHITE]=ctx->whiteptr->num_tally;
+	}
+	n=0;
+	for (k=0;k<MOMENT_REGIONS;++k) {
+		mt->first[k]=n;
+		n+=mt->num[k];
+	}
+	mt->num_slots=n;
+	mt->photon=(double *)calloc(2*n,sizeof(double));
+	mt->cap_touched=1024;
+	mt->touched=(size_t *)malloc(mt->cap_touched*sizeof(size_t));
+	if ((mt->photon==NULL)||(mt->touched==NULL)) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	mt->sum2=mt->photon+n;
+	mt->on=1;
+}
+
+/*****************************************************************/
+void FreeMoments(struct SimContext *ctx)
+{
+	free(ctx->moments.photon);
+	free(ctx->moments.touched);
+	memset(&ctx->moments,0,sizeof(struct MomentTrack));
+}
+
+/*****************************************************************/
+void MomentAdd(struct SimContext *ctx, const double *p, double w)
+{
+	struct MomentTrack *mt=&ctx->moments;
+	size_t i=MomentSlot(mt,p);
+
+	if (mt->photon[i]==0.0) {
+		if (w==0.0)
+			return;
+		if (mt->num_touched==mt->cap_touched) {
+			mt->cap_touched*=2;
+			mt->touched=(size_t *)realloc(mt->touched,mt->cap_touched*sizeof(size_t));
+			if (mt->touched==NULL) {
+				printf("Memory allocation error\n");
+				exit(1);
+			}
+		}
+		mt->touched[mt->num_touched++]=i;
+	}
+	mt->photon[i]+=w;
+}
+
+/*****************************************************************/
+/* the photon is done: one sample per bin it touched */
+void MomentEndPhoton(struct SimContext *ctx)
+{
+	struct MomentTrack *mt=&ctx->moments;
+	const double *r_lo,*r_hi,*t_lo,*t_hi,*a_lo,*a_hi,*p;
+	const double *base=mt->base[MOMENT_REGION_ARENA];
+	size_t j,i;
+	double v;
+	int k;
+
+	if (!mt->on)
+		return;
+	MatrixSpan(ctx->outptr->R_ra,&r_lo,&r_hi);
+	MatrixSpan(ctx->outptr->T_ra,&t_lo,&t_hi);
+	a_lo=ctx->outptr->A_layer;
+	a_hi=a_lo+ctx->tissptr->num_layers+2;
+	for (k=0;k<3;++k)
+		mt->tot[k]=0.0;
+
+	for (j=0;j<mt->num_touched;++j) {
+		i=mt->touched[j];
+		v=mt->photon[i];
+		mt->sum2[i]+=v*v;
+		mt->photon[i]=0.0;
+		if (i<mt->num[MOMENT_REGION_ARENA]) {
+			p=base+i;
+			if ((p>=r_lo)&&(p<r_hi))
+				mt->tot[MOMENT_RD]+=v;
+			else if ((p>=t_lo)&&(p<t_hi))
+				mt->tot[MOMENT_TD]+=v;
+			else if ((p>=a_lo)&&(p<a_hi))
+				mt->tot[MOMENT_ATOT]+=v;
+		}
+	}
+	mt->num_touched=0;
+	for (k=0;k<3;++k)
+		mt->tot2[k]+=mt->tot[k]*mt->tot[k];
+}
+
+/*****************************************************************/
+/* add the worker's sums into ctx and zero them */
+void ReduceMoments(struct SimContext *ctx, struct SimContext *wctx)
+{
+	struct MomentTrack *mt=&ctx->moments, *wmt=&wctx->moments;
+	size_t i;
+	int k;
+
+	if (!mt->on||!wmt->on)
+		return;
+	for (i=0;i<mt->num_slots;++i) {
+		mt->sum2[i]+=wmt->sum2[i];
+		wmt->sum2[i]=0.0;
+	}
+	for (k=0;k<3;++k) {
+		mt->tot2[k]+=wmt->tot2[k];
+		wmt->tot2[k]=0.0;
+	}
+}
+
+/*****************************************************************/
+/* relative error of a mean of n photons with sum s and sum of */
+/* squares s2; 0 for a bin no photon reached                   */
+static double RelErrOf(double s, double s2, long n)
+{
+	double v;
+
+	if ((s==0.0)||(n<2))
+		return 0.0;
+	v=(n*s2-s*s)/(n-1);
+	return (v>0.0) ? sqrt(v)/fabs(s) : 0.0;
+}
+
+/*****************************************************************/
+/* a derived tally filled from sums must have had its own deposits: */
+/* a raw sum with no second moment would report 0 error. A sum of n */
+/* photons above n*sqrt(DBL_MIN) has one whose square is not 0.     */
+static void CheckDerived(struct SimContext *ctx, const double *p, int num, long n, const char *name)
+{
+	struct MomentTrack *mt=&ctx->moments;
+	int i;
+
+	for (i=0;i<num;++i)
+		if ((fabs(p[i])>n*sqrt(DBL_MIN))&&(mt->sum2[MomentSlot(mt,p+i)]==0.0)) {
+			printf("\nERROR - %s[%d] has no second moment\n",name,i);
+			exit(0);
+		}
+}
+
+/*****************************************************************/
+/* sum2[] -> relative errors; call on the raw sums, after the */
+/* derived tallies are filled from them and before scaling     */
+void MomentsToRelErr(struct SimContext *ctx, long n)
+{
+	struct MomentTrack *mt=&ctx->moments;
+	double s[3];
+	size_t i,j;
+	int k;
+
+	if (!mt->on)
+		return;
+	CheckDerived(ctx,ctx->outptr->R_r,ctx->detector->nr,n,"R_r");
+	CheckDerived(ctx,ctx->outptr->T_r,ctx->detector->nr,n,"T_r");
+	CheckDerived(ctx,ctx->outptr->R_a,ctx->detector->na,n,"R_a");
+	CheckDerived(ctx,ctx->outptr->T_a,ctx->detector->na,n,"T_a");
+	CheckDerived(ctx,ctx->outptr->A_z,ctx->detector->nz,n,"A_z");
+	for (k=0;k<MOMENT_REGIONS;++k)
+		for (i=0,j=mt->first[k];i<mt->num[k];++i,++j)
+			mt->sum2[j]=RelErrOf(mt->base[k][i],mt->sum2[j],n);
+
+	s[MOMENT_RD]=s[MOMENT_TD]=s[MOMENT_ATOT]=0.0;
+	for (i=0;i<(size_t)ctx->detector->nr;++i) {
+		for (j=0;j<(size_t)ctx->detector->na;++j) {
+			s[MOMENT_RD]+=ctx->outptr->R_ra[i][j];
+			s[MOMENT_TD]+=ctx->outptr->T_ra[i][j];
+		}
+	}
+	for (i=1;i<=(size_t)ctx->tissptr->num_layers;++i)
+		s[MOMENT_ATOT]+=ctx->outptr->A_layer[i];
+	for (k=0;k<3;++k)
+		mt->tot2[k]=RelErrOf(s[k],mt->tot2[k],n);
+}
+
+/*****************************************************************/
+/* relative error of tally double p, after MomentsToRelErr() */
+double RelErr(struct SimContext *ctx, const double *p)
+{
+	return ctx->moments.sum2[MomentSlot(&ctx->moments,p)];
+}
+
+/*****************************************************************/
+/* relative error of complex tally *re+i*(*im): the standard errors */
+/* of both parts over the modulus. It bounds the relative error of  */
+/* the amplitude and the error of the phase in rad                  */
+double RelErrComplex(struct SimContext *ctx, const double *re, const double *im)
+{
+	double a=RelErr(ctx,re)*(*re), b=RelErr(ctx,im)*(*im);
+	double m=sqrt((*re)*(*re)+(*im)*(*im));
+
+	return (m>0.0) ? sqrt(a*a+b*b)/m : 0.0;
+}
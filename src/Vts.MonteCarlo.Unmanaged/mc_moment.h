@@ -0,0 +1,23 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+/* deposit w in tally double *p: also count it for the photon's */
+/* second moment. Derived tallies that NormalizeResults() fills  */
+/* from sums take the MOMENT_ADD() alone.                        */
+#define MOMENT_ADD(ctx,p,w) if ((ctx)->moments.on) MomentAdd((ctx),(p),(w))
+
+void SetupMoments(struct SimContext *);
+void FreeMoments(struct SimContext *);
+void MomentAdd(struct SimContext *, const double *, double);
+void MomentEndPhoton(struct SimContext *);
+void ReduceMoments(struct SimContext *, struct SimContext *);
+void MomentsToRelErr(struct SimContext *, long);
+double RelErr(struct SimContext *, const double *);
+double RelErrComplex(struct SimContext *, const double *, const double *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -1,154 +1,362 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include "mc_main.h"
-#include "pert.h"
-#include "mc_read_input.h"
-
-/* global variables */
-extern struct Photon *photptr;
-extern struct Tissue *tissptr;
-extern struct Output *outptr;
-extern struct perturb *pertptr;
-extern struct SourceDefinition *source;
-extern struct DetectorDefinition *detector;
-/************************************************************/
-void ReadInput(FILE * comm_file_ptr)
-
-{
-  char temp[256];
-  char temp2[256];
-  char in_fname[256];
-  FILE * file_ptr;
-  int i;
-
-  if ( comm_file_ptr == NULL ) {
-    printf("Enter input filename: ");
-    scanf("%s",in_fname);
-    file_ptr = fopen(in_fname, "r");
-  }
-  else
-    file_ptr = comm_file_ptr;
-  
-  if (file_ptr == NULL ) {
-    printf("\nERROR - Could not find or open input file %s\n",in_fname);
-    exit(0);
-  }
-  
-  /* Read in output file name */
-  fscanf(file_ptr, "%s %*[^\n]s",  pertptr->output_filename);
-
-  /* Read in number of layers */
-  fscanf(file_ptr, "%hd %*[^\n]s", &tissptr->num_layers);
-  if ( tissptr->num_layers > 12 ) {
-    printf("\nERROR - number of layers must be less than 12\n");
-    exit(0);
-    }
-
-  /* Read in index of outside medium */
-  fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[0].n);
-
-  /* loop through number of layers and read properties of each */
-  for (i=1 ;i<tissptr->num_layers+1 ;i++ ) {
-    fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[i].n);
-    fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[i].mus);
-    fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[i].mua);
-    fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[i].g);
-    fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[i].d);
-  }
-
-  /* read in index of outside, bottom medium */
-  fscanf(file_ptr, "%lf %*[^\n]s", &tissptr->layerprops[tissptr->num_layers+1].n);
-  /* Read in flat or Gaussian beam */
-  fscanf(file_ptr, "%s %*[^\n]s", source->beamtype);
-  //if ( (source->beamtype[0] != 'f') && (source->beamtype[0] != 'F')) {
-  //  if ((source->beamtype[0] != 'g') && (source->beamtype[0] != 'G') )
-  //    {
-  //      printf("\nERROR - beam type must be either g (Gaussian) or f (flat)\n");
-  //      exit(0);
-  //    }
-  //}
-
-  if ( (source->beamtype[0] != 'f') && (source->beamtype[0] != 'F')&&
-	  (source->beamtype[0] != 'r') && (source->beamtype[0] != 'R')&&
-	  (source->beamtype[0] != 'g') && (source->beamtype[0] != 'G') )
-  {
-	  printf("\nERROR - beam type must be either g (Gaussian) or f (flat) or r (rectangular)\n");
-	  exit(0);
-  }
-
-  /* Read in beam radius */  
-  fscanf(file_ptr, "%lf %*[^\n]s", &source->beam_center_x); 
-  fscanf(file_ptr, "%lf %*[^\n]s", &source->beam_radius);   
-  fscanf(file_ptr, "%lf %*[^\n]s", &source->src_NA);
-
-  /* Read in nr,dr,nz,dz,na */
-  fscanf(file_ptr, "%hd %*[^\n]s", &detector->nr);
-  fscanf(file_ptr, "%lf %*[^\n]s", &detector->dr);
-  fscanf(file_ptr, "%hd %*[^\n]s", &detector->nz);
-  fscanf(file_ptr, "%lf %*[^\n]s", &detector->dz);
-  
-  fscanf(file_ptr, "%hd %*[^\n]s", &detector->nx); //=================================
-  fscanf(file_ptr, "%lf %*[^\n]s", &detector->dx);
-  fscanf(file_ptr, "%hd %*[^\n]s", &detector->ny);
-  fscanf(file_ptr, "%lf %*[^\n]s", &detector->dy);
-
-  /*  fscanf(file_ptr, "%hd %*[^\n]s", &detector->na);*/
-  detector->na=1;
-
-  /* compute da=(pi/2)/na */
-  detector->da = (PI/2.0)/detector->na;
-
-  /* Read in number of photons */
-  fscanf(file_ptr, "%ld %*[^\n]s",  &source->num_photons);
-
-  /* read dt */
-  fscanf(file_ptr, "%hd %*[^\n]s", &detector->nt);
-  fscanf(file_ptr, "%lf %*[^\n]s", &detector->dt);
-
-  /* Compute starting and ending coordinates for each layer */
-  tissptr->layerprops[0].zend = 0.0;
-  for ( i=1;i<tissptr->num_layers+1;i++ )
-  {
-    tissptr->layerprops[i].zbegin = tissptr->layerprops[i-1].zend;
-    tissptr->layerprops[i].zend = tissptr->layerprops[i].d + 
-                                  tissptr->layerprops[i].zbegin;
-  }
-
-  /* compute albedo for each layer */
-  for (i=1;i<tissptr->num_layers+1;i++)
-    {
-      tissptr->layerprops[i].albedo=tissptr->layerprops[i].mus/(tissptr->layerprops[i].mus+tissptr->layerprops[i].mua);
-    }
-
-  Read_Perturbation_Input(file_ptr);
-
-  fclose(file_ptr);
-  }
-/***************************************************************/
-void Read_Perturbation_Input(FILE *file_ptr)
-{
-  int i;
-  /* read in ellipsoid or layer pert flag */
-  fscanf(file_ptr,"%d %*[^\n]s",&tissptr->do_ellip_layer); // CKH FIX 2/09 needs to be d not hd
-  /* read in ellipsoid dimensions */
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->ellip_x);
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->ellip_y);
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->ellip_z);
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->ellip_rad_x);
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->ellip_rad_y);
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->ellip_rad_z);
-  /* read in layer z min and max */
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->layer_z_min);
-  fscanf(file_ptr,"%lf %*[^\n]s",&tissptr->layer_z_max);
-
-  /* read in detector data */
-  fscanf(file_ptr,"%d %*[^\n]s",&detector->nr);
-  /* read in reflect/transmit flag */
-  fscanf(file_ptr,"%d %*[^\n]s",&detector->reflect_flag);
-  /* loop through number of detectors and read center */
-  for (i=0 ;i<detector->nr ;++i) {
-    fscanf(file_ptr, "%lf %*[^\n]s", &detector->det_ctr[i]);
-  }
-  fscanf(file_ptr,"%lf %*[^\n]s",&detector->det_rad);
-
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include "mc_main.h"
+#include "mc_detect.h"
+#include "mc_conv.h"
+#include "mc_ckpt.h"
+#include "pert.h"
+#include "mc_read_input.h"
+
+/************************************************************/
+void ReadInput(struct SimContext *ctx, FILE * comm_file_ptr)
+
+{
+  char temp[256];
+  char temp2[256];
+  char in_fname[256];
+  FILE * file_ptr;
+  int i;
+
+  if ( comm_file_ptr == NULL ) {
+    printf("Enter input filename: ");
+    scanf("%s",in_fname);
+    file_ptr = fopen(in_fname, "r");
+  }
+  else
+    file_ptr = comm_file_ptr;
+  
+  if (file_ptr == NULL ) {
+    printf("\nERROR - Could not find or open input file %s\n",in_fname);
+    exit(0);
+  }
+  
+  /* Read in output file name */
+  fscanf(file_ptr, "%s %*[^\n]s",  ctx->pertptr->output_filename);
+
+  /* Read in number of layers */
+  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->tissptr->num_layers);
+  if ( ctx->tissptr->num_layers < 1 ) {
+    printf("\nERROR - number of layers must be at least 1\n");
+    exit(0);
+    }
+  /* layers 0 and num_layers+1 are the media above and below */
+  free(ctx->tissptr->layerprops);
+  ctx->tissptr->layerprops=(struct Layer *)calloc(ctx->tissptr->num_layers+2,sizeof(struct Layer));
+  if (ctx->tissptr->layerprops==NULL) {
+    printf("Memory allocation error\n");
+    exit(1);
+    }
+  AllocPertLayers(ctx->pertptr,ctx->tissptr->num_layers);
+
+  /* Read in index of outside medium */
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[0].n);
+
+  /* loop through number of layers and read properties of each */
+  for (i=1 ;i<ctx->tissptr->num_layers+1 ;i++ ) {
+    fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[i].n);
+    fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[i].mus);
+    fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[i].mua);
+    fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[i].g);
+    fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[i].d);
+  }
+
+  /* read in index of outside, bottom medium */
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->tissptr->layerprops[ctx->tissptr->num_layers+1].n);
+  /* Read in flat or Gaussian beam */
+  fscanf(file_ptr, "%s %*[^\n]s", ctx->source->beamtype);
+  //if ( (source->beamtype[0] != 'f') && (source->beamtype[0] != 'F')) {
+  //  if ((source->beamtype[0] != 'g') && (source->beamtype[0] != 'G') )
+  //    {
+  //      printf("\nERROR - beam type must be either g (Gaussian) or f (flat)\n");
+  //      exit(0);
+  //    }
+  //}
+
+  if ( (ctx->source->beamtype[0] != 'f') && (ctx->source->beamtype[0] != 'F')&&
+	  (ctx->source->beamtype[0] != 'r') && (ctx->source->beamtype[0] != 'R')&&
+	  (ctx->source->beamtype[0] != 'g') && (ctx->source->beamtype[0] != 'G') )
+  {
+	  printf("\nERROR - beam type must be either g (Gaussian) or f (flat) or r (rectangular)\n");
+	  exit(0);
+  }
+
+  /* Read in beam radius */  
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->source->beam_center_x); 
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->source->beam_radius);   
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->source->src_NA);
+
+  /* Read in nr,dr,nz,dz,na */
+  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->detector->nr);
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->detector->dr);
+  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->detector->nz);
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->detector->dz);
+  
+  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->detector->nx); //=================================
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->detector->dx);
+  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->detector->ny);
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->detector->dy);
+
+  /*  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->detector->na);*/
+  ctx->detector->na=1;
+
+  /* compute da=(pi/2)/na */
+  ctx->detector->da = (PI/2.0)/ctx->detector->na;
+
+  /* Read in number of photons */
+  fscanf(file_ptr, "%ld %*[^\n]s",  &ctx->source->num_photons);
+
+  /* read dt */
+  fscanf(file_ptr, "%hd %*[^\n]s", &ctx->detector->nt);
+  fscanf(file_ptr, "%lf %*[^\n]s", &ctx->detector->dt);
+
+  /* Compute starting and ending coordinates for each layer */
+  ctx->tissptr->layerprops[0].zend = 0.0;
+  for ( i=1;i<ctx->tissptr->num_layers+1;i++ )
+  {
+    ctx->tissptr->layerprops[i].zbegin = ctx->tissptr->layerprops[i-1].zend;
+    ctx->tissptr->layerprops[i].zend = ctx->tissptr->layerprops[i].d + 
+                                  ctx->tissptr->layerprops[i].zbegin;
+  }
+
+  /* compute albedo for each layer */
+  for (i=1;i<ctx->tissptr->num_layers+1;i++)
+    {
+      ctx->tissptr->layerprops[i].albedo=ctx->tissptr->layerprops[i].mus/(ctx->tissptr->layerprops[i].mus+ctx->tissptr->layerprops[i].mua);
+    }
+
+  Read_Perturbation_Input(ctx,file_ptr);
+
+  fclose(file_ptr);
+  }
+/***************************************************************/
+void Read_Perturbation_Input(struct SimContext *ctx, FILE *file_ptr)
+{
+  int i,num_det=0;
+  struct Detector *det;
+  /* read in ellipsoid or layer pert flag */
+  fscanf(file_ptr,"%d %*[^\n]s",&ctx->tissptr->do_ellip_layer); // CKH FIX 2/09 needs to be d not hd
+  /* read in ellipsoid dimensions */
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->ellip_x);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->ellip_y);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->ellip_z);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->ellip_rad_x);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->ellip_rad_y);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->ellip_rad_z);
+  /* read in layer z min and max */
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->layer_z_min);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->tissptr->layer_z_max);
+
+  /* read in detector data: the number of detectors is its own */
+  /* count, detector->nr stays the number of radial bins         */
+  fscanf(file_ptr,"%d %*[^\n]s",&num_det);
+  /* read in reflect/transmit flag */
+  fscanf(file_ptr,"%d %*[^\n]s",&ctx->detector->reflect_flag);
+  /* loop through number of detectors and read center */
+  det=(struct Detector *)calloc((num_det>0)?num_det:1,sizeof(struct Detector));
+  if (det==NULL) {
+    printf("Memory allocation error\n");
+    exit(1);
+  }
+  for (i=0 ;i<num_det ;++i)
+    fscanf(file_ptr, "%lf %*[^\n]s", &det[i].x);
+  fscanf(file_ptr,"%lf %*[^\n]s",&ctx->detector->det_rad);
+  /* circles of radius det_rad on the x axis */
+  if (ctx->detector->det_rad>0.0) {
+    for (i=0 ;i<num_det ;++i) {
+      det[i].type=DET_CIRCLE;
+      det[i].b=ctx->detector->det_rad;
+    }
+    SetDetectors(ctx,num_det,det);
+  }
+  else {
+    if (num_det>0)
+      printf("Warning: Zero detector radius specified\n");
+    SetDetectors(ctx,0,det);
+  }
+  free(det);
+
+  Read_Roulette_Input(ctx,file_ptr);
+  Read_Keyword_Input(ctx,file_ptr);
+}
+/***************************************************************/
+/* optional trailing lines: wt_cut, prr, then any number of     */
+/* "layer wt_cut prr" overrides. No wt_cut turns roulette off.  */
+void Read_Roulette_Input(struct SimContext *ctx, FILE *file_ptr)
+{
+  int i;
+  double wt_cut,prr;
+
+  if (fscanf(file_ptr,"%lf %*[^\n]s",&ctx->pertptr->wt_cut)!=1)
+    ctx->pertptr->wt_cut=0.0;
+  if (fscanf(file_ptr,"%lf %*[^\n]s",&ctx->pertptr->prr)!=1)
+    ctx->pertptr->prr=PRR_DEFAULT;
+  for (i=0;i<ctx->tissptr->num_layers+2;++i) {
+    ctx->pertptr->layer_wt_cut[i]=ctx->pertptr->wt_cut;
+    ctx->pertptr->layer_prr[i]=ctx->pertptr->prr;
+  }
+  while (fscanf(file_ptr,"%d %lf %lf %*[^\n]s",&i,&wt_cut,&prr)==3) {
+    if ((i<1)||(i>ctx->tissptr->num_layers)) {
+      printf("\nERROR - roulette override for layer %d, tissue has %d layers\n",
+        i,ctx->tissptr->num_layers);
+      exit(0);
+    }
+    ctx->pertptr->layer_wt_cut[i]=wt_cut;
+    ctx->pertptr->layer_prr[i]=prr;
+  }
+  for (i=1;i<ctx->tissptr->num_layers+1;++i)
+    if ((ctx->pertptr->layer_wt_cut[i]>0.0)&&
+        ((ctx->pertptr->layer_prr[i]<=0.0)||(ctx->pertptr->layer_prr[i]>1.0))) {
+      printf("\nERROR - roulette survival chance must be in (0,1]\n");
+      exit(0);
+    }
+}
+/***************************************************************/
+/* index of the name that follows key in names[num]; the Flags  */
+/* values are in the same order                                 */
+static int Read_Flag_Name(FILE *file_ptr, const char *key, const char **names, int num)
+{
+  char name[16];
+  int i;
+
+  if (fscanf(file_ptr," %15s",name)==1)
+    for (i=0;i<num;++i)
+      if (strcmp(name,names[i])==0)
+        return i;
+  printf("\nERROR - %s: expected %s",key,names[0]);
+  for (i=1;i<num;++i)
+    printf(" or %s",names[i]);
+  printf("\n");
+  exit(0);
+  return 0;
+}
+/***************************************************************/
+/* optional last lines, in any order:                           */
+/*   "fd nomega df": reflectance R(r,f) at the modulation       */
+/*                   frequencies f=0,df,..,(nomega-1)*df GHz    */
+/*   "fx nfx dfx":   reflectance R(fx) at the spatial           */
+/*                   frequencies fx=0,dfx,..,(nfx-1)*dfx 1/mm   */
+/*   "stop err s batch": trace batches of batch photons (0 for  */
+/*                   the default) until the batch-means         */
+/*                   relative error is at most err, s seconds   */
+/*                   have passed (0 for either: no limit) or    */
+/*                   num_photons are done                       */
+/*   "conv Rd", "conv Rr ir": the tallies that err is of, Rd    */
+/*                   when there is no conv line                 */
+/*   "checkpoint file n": save the raw tallies to file every n  */
+/*                   photons (0: only at the end)               */
+/*   "resume file":  start from the tallies in file             */
+/*   "seed n":       seed of the Philox streams, for shards     */
+/*                   that are merged (mc_merge.c)               */
+/*   "rng ran3|philox", "engine scalar|batch",                  */
+/*   "allvox off|history|stream", "tracking surface|delta",     */
+/*   "absorb analog|discrete|continuous", "moments off|on",     */
+/*   "threads n" (0: all cores): the Flags, see mc_main.h       */
+/*   "visits off|on": count the photons entering each allvox    */
+/*                   voxel, written to wts_visits               */
+void Read_Keyword_Input(struct SimContext *ctx, FILE *file_ptr)
+{
+  static const char *rng_names[]={"ran3","philox"};
+  static const char *engine_names[]={"scalar","batch"};
+  static const char *allvox_names[]={"off","history","stream"};
+  static const char *tracking_names[]={"surface","delta"};
+  static const char *absorb_names[]={"analog","discrete","continuous"};
+  static const char *off_on_names[]={"off","on"};
+  char key[16],name[256];
+  int num;
+  double df,seconds;
+
+  ctx->outptr->nomega=0;
+  ctx->nfx=0;
+  FreeConvStop(ctx);
+  FreeCheckpoint(ctx);
+  while (fscanf(file_ptr," %15s",key)==1) {
+    if ((strcmp(key,"fd")==0)||(strcmp(key,"fx")==0)) {
+      if (fscanf(file_ptr,"%d %lf",&num,&df)!=2) {
+        printf("\nERROR - %s: expected number of frequencies and spacing\n",key);
+        exit(0);
+      }
+      if ((num<1)||(num>SHRT_MAX)||!(df>0.0)) {
+        printf("\nERROR - %s: %d frequencies %f apart\n",key,num,df);
+        exit(0);
+      }
+      if (key[1]=='d') {
+        ctx->outptr->nomega=num;
+        ctx->dfreq=df;
+      }
+      else {
+        ctx->nfx=(short)num;
+        ctx->dfx=df;
+      }
+    }
+    else if (strcmp(key,"stop")==0) {
+      if ((fscanf(file_ptr,"%lf %lf %d",&df,&seconds,&num)!=3)||
+          (df<0.0)||(seconds<0.0)||(num<0)) {
+        printf("\nERROR - stop: expected relative error, seconds and batch size, all >=0\n");
+        exit(0);
+      }
+      SetConvStop(ctx,df,seconds,num);
+    }
+    else if (strcmp(key,"conv")==0) {
+      if (fscanf(file_ptr," %15s",name)!=1)
+        name[0]=0;
+      if (strcmp(name,"Rd")==0)
+        AddConvTally(ctx,CONV_RD);
+      else if ((strcmp(name,"Rr")==0)&&(fscanf(file_ptr,"%d",&num)==1)&&(num>=0))
+        AddConvTally(ctx,num);
+      else {
+        printf("\nERROR - conv: expected Rd or Rr and a radial bin\n");
+        exit(0);
+      }
+    }
+    else if (strcmp(key,"checkpoint")==0) {
+      if ((fscanf(file_ptr," %255s %d",name,&num)!=2)||(num<0)) {
+        printf("\nERROR - checkpoint: expected file name and photons between checkpoints\n");
+        exit(0);
+      }
+      SetCheckpoint(ctx,name,num);
+    }
+    else if (strcmp(key,"resume")==0) {
+      if (fscanf(file_ptr," %255s",name)!=1) {
+        printf("\nERROR - resume: expected checkpoint file name\n");
+        exit(0);
+      }
+      SetResume(ctx,name);
+    }
+    else if (strcmp(key,"seed")==0) {
+      if (fscanf(file_ptr,"%d",&num)!=1) {
+        printf("\nERROR - seed: expected an integer\n");
+        exit(0);
+      }
+      ctx->flagptr->Seed=num;
+    }
+    else if (strcmp(key,"rng")==0)
+      ctx->flagptr->RngType=Read_Flag_Name(file_ptr,key,rng_names,2);
+    else if (strcmp(key,"engine")==0)
+      ctx->flagptr->TransportEngine=Read_Flag_Name(file_ptr,key,engine_names,2);
+    else if (strcmp(key,"allvox")==0)
+      ctx->flagptr->Allvox=Read_Flag_Name(file_ptr,key,allvox_names,3);
+    else if (strcmp(key,"tracking")==0)
+      ctx->flagptr->Tracking=Read_Flag_Name(file_ptr,key,tracking_names,2);
+    else if (strcmp(key,"absorb")==0)
+      ctx->flagptr->AbsWtType=Read_Flag_Name(file_ptr,key,absorb_names,3);
+    else if (strcmp(key,"moments")==0)
+      ctx->flagptr->TallySecondMoment=Read_Flag_Name(file_ptr,key,off_on_names,2);
+    else if (strcmp(key,"threads")==0) {
+      if ((fscanf(file_ptr,"%d",&num)!=1)||(num<0)) {
+        printf("\nERROR - threads: expected a number of threads >=0\n");
+        exit(0);
+      }
+      ctx->flagptr->NumThreads=num;
+    }
+    else if (strcmp(key,"visits")==0)
+      ctx->allvox_trk.visits.record=Read_Flag_Name(file_ptr,key,off_on_names,2);
+    else {
+      printf("\nERROR - input line %s: expected fd, fx, stop, conv, checkpoint, resume, seed,\n"
+        "rng, engine, allvox, tracking, absorb, moments, threads or visits\n",key);
+      exit(0);
+    }
+    fscanf(file_ptr,"%*[^\n]");
+  }
+}
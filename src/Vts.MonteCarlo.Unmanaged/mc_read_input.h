@@ -1,2 +1,6 @@
-void  ReadInput2(FILE *);
-void Read_Perturbation_Input(FILE *file_ptr);
+struct SimContext;
+
+void  ReadInput2(FILE *);
+void Read_Perturbation_Input(struct SimContext *ctx, FILE *file_ptr);
+void Read_Roulette_Input(struct SimContext *ctx, FILE *file_ptr);
+void Read_Keyword_Input(struct SimContext *ctx, FILE *file_ptr);
@@ -0,0 +1,120 @@
+/* Physics event counters and phase timers; building with MC_STATS=0
+*  compiles them out.
+*
+*  Every context counts its own events in ctx->stats with the
+*  STATS_INC() macro: one add on a field of a struct the thread
+*  already owns, no locks. Workers' counts are added to the master's
+*  with the tallies (ReduceWorkerTallies). STATS_END_PHOTON() counts
+*  the photon and puts its number of steps into a power-of-2 bin.
+*  STATS_BEGIN()/STATS_END() add the wall-clock time of a phase:
+*  initialize, RunMCLoop, Compute_Prob_allvox (summed over threads),
+*  NormalizeResults and writing the output files.
+*
+*  SaveStats() writes them all as JSON to <output>_stats.json next to
+*  the results. The counts are of the photons traced in this run; a
+*  resumed run (mc_ckpt.c) does not count those of its checkpoint. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "mc_main.h"
+#include "mc_stats.h"
+#include "pert.h"
+
+/*****************************************************************/
+double WallSeconds(void)
+{
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	return (double)clock()/CLOCKS_PER_SEC;	/* one thread: CPU time will do */
+#endif
+}
+
+#if MC_STATS
+/*****************************************************************/
+/* the photon is done after steps steps */
+void StatsEndPhoton(struct SimContext *ctx, int steps)
+{
+	int k=0;
+
+	while ((steps>1)&&(k<STATS_STEP_BINS-1)) {
+		steps>>=1;
+		++k;
+	}
+	++ctx->stats.photons;
+	++ctx->stats.steps[k];
+}
+
+/*****************************************************************/
+/* add the worker's counts into ctx and zero them */
+void ReduceStats(struct SimContext *ctx, struct SimContext *wctx)
+{
+	struct EventStats *s=&ctx->stats, *w=&wctx->stats;
+	int k;
+
+	s->photons+=w->photons;
+	s->collisions+=w->collisions;
+	s->virtual_collisions+=w->virtual_collisions;
+	s->boundary_hits+=w->boundary_hits;
+	s->fresnel_reflections+=w->fresnel_reflections;
+	s->region_crossings+=w->region_crossings;
+	s->history_kills+=w->history_kills;
+	for (k=0;k<STATS_STEP_BINS;++k)
+		s->steps[k]+=w->steps[k];
+	s->seconds[STATS_ALLVOX]+=w->seconds[STATS_ALLVOX];
+	memset(w,0,sizeof(*w));
+}
+
+/*****************************************************************/
+static void SaveCount(FILE *file, const char *name, STATS_U64 n, const char *sep)
+{
+	fprintf(file,"    \"%s\": %.0f%s\n",name,(double)n,sep);
+}
+
+/*****************************************************************/
+void SaveStats(struct SimContext *ctx)
+{
+	struct EventStats *s=&ctx->stats;
+	static const char *phase[STATS_PHASES]={
+		"initialize","RunMCLoop","Compute_Prob_allvox","NormalizeResults","output"};
+	char tmp_name[270];
+	FILE *file;
+	int k;
+
+	sprintf(tmp_name,"%s_stats.json",ctx->pertptr->output_filename);
+	file=fopen(tmp_name,"w");
+	if (file==NULL) {
+		printf("\nERROR - could not open %s\n",tmp_name);
+		exit(0);
+	}
+	fprintf(file,"{\n");
+	fprintf(file,"  \"photons\": %.0f,\n",(double)s->photons);
+	fprintf(file,"  \"threads\": %d,\n",s->threads);
+	fprintf(file,"  \"counters\": {\n");
+	SaveCount(file,"collisions",s->collisions,",");
+	fprintf(file,"    \"collisions_per_photon\": %.6g,\n",
+		(s->photons>0) ? (double)s->collisions/s->photons : 0.0);
+	SaveCount(file,"virtual_collisions",s->virtual_collisions,",");
+	SaveCount(file,"boundary_hits",s->boundary_hits,",");
+	SaveCount(file,"fresnel_reflections",s->fresnel_reflections,",");
+	SaveCount(file,"region_crossings",s->region_crossings,",");
+	SaveCount(file,"history_kills",s->history_kills,"");
+	fprintf(file,"  },\n");
+	/* entry k: photons with 2^k..2^(k+1)-1 steps, the last one up */
+	fprintf(file,"  \"steps_log2_histogram\": [");
+	for (k=0;k<STATS_STEP_BINS;++k)
+		fprintf(file,"%s%.0f",(k>0) ? ", " : "",(double)s->steps[k]);
+	fprintf(file,"],\n");
+	fprintf(file,"  \"seconds\": {\n");
+	for (k=0;k<STATS_PHASES;++k)
+		fprintf(file,"    \"%s\": %.6f%s\n",phase[k],s->seconds[k],(k<STATS_PHASES-1) ? "," : "");
+	fprintf(file,"  }\n");
+	fprintf(file,"}\n");
+	fclose(file);
+}
+#endif /* MC_STATS */
@@ -0,0 +1,35 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+#ifndef MC_STATS
+#define MC_STATS 1	/* 0 compiles the event counters and phase timers out */
+#endif
+
+/* count event c of EventStats, time phase p (STATS_INIT, ...) */
+#if MC_STATS
+#define STATS_INC(ctx,c) (++(ctx)->stats.c)
+#define STATS_BEGIN(ctx,p) ((ctx)->stats.start[p]=WallSeconds())
+#define STATS_END(ctx,p) ((ctx)->stats.seconds[p]+=WallSeconds()-(ctx)->stats.start[p])
+#define STATS_END_PHOTON(ctx,steps) StatsEndPhoton((ctx),(steps))
+#define STATS_REDUCE(ctx,wctx) ReduceStats((ctx),(wctx))
+#define STATS_SAVE(ctx) SaveStats(ctx)
+#else
+#define STATS_INC(ctx,c) ((void)0)
+#define STATS_BEGIN(ctx,p) ((void)0)
+#define STATS_END(ctx,p) ((void)0)
+#define STATS_END_PHOTON(ctx,steps) ((void)0)
+#define STATS_REDUCE(ctx,wctx) ((void)0)
+#define STATS_SAVE(ctx) ((void)0)
+#endif
+
+double WallSeconds(void);
+void StatsEndPhoton(struct SimContext *, int);
+void ReduceStats(struct SimContext *, struct SimContext *);
+void SaveStats(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
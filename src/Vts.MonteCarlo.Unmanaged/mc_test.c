@@ -0,0 +1,150 @@
+/* Native self tests, the "test" mode of main().
+*
+*  SelfTestMC() needs no reference output and prints a PASS or FAIL
+*  line per test:
+*  - Philox4x32: the 10-round generator against the known-answer
+*    vectors of Random123 (kat_vectors, philox4x32_10).
+*  - resume: the input traced once, then traced to half its photons
+*    with a checkpoint and resumed from it to all of them. The final
+*    checkpoints of the two, which hold every raw tally, must be the
+*    same bytes. Done with Philox on the input's threads and with
+*    ran3 on one thread, where the checkpoint carries the ran3 state.
+*  It returns the number of tests that failed. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mc_main.h"
+#include "mc_conv.h"
+#include "mc_ckpt.h"
+#include "mc_test.h"
+#include "protos.h"
+
+/* written and removed by TestResume() */
+#define TEST_CKPT "mc_test_half.bin"
+#define TEST_WHOLE "mc_test_whole.bin"
+#define TEST_RESUMED "mc_test_resumed.bin"
+
+/* Random123 philox4x32_10 known answers: key, counter, output */
+static const unsigned int philox_kat[3][10]={
+	{0x00000000,0x00000000, 0x00000000,0x00000000,0x00000000,0x00000000,
+	 0x6627e8d5,0xe169c58d,0xbc57ac4c,0x9b00dbd8},
+	{0xffffffff,0xffffffff, 0xffffffff,0xffffffff,0xffffffff,0xffffffff,
+	 0x408f276d,0x41c83b0e,0xa20bc7c6,0x6d5451fd},
+	{0xa4093822,0x299f31d0, 0x243f6a88,0x85a308d3,0x13198a2e,0x03707344,
+	 0xd16cfe09,0x94fdcceb,0x5001e420,0x24126ea1}
+};
+
+/*****************************************************************/
+static int TestPhilox(void)
+{
+	unsigned int out[4];
+	int i,k,bad=0;
+
+	for (i=0;i<3;++i) {
+		Philox4x32(philox_kat[i],philox_kat[i]+2,out);
+		for (k=0;k<4;++k)
+			if (out[k]!=philox_kat[i][6+k])
+				++bad;
+		if (bad>0) {
+			printf("FAIL Philox4x32: vector %d gives %08x %08x %08x %08x\n",
+				i,out[0],out[1],out[2],out[3]);
+			return 1;
+		}
+	}
+	printf("PASS Philox4x32: %d known-answer vectors\n",i);
+	return 0;
+}
+
+/*****************************************************************/
+/* the input with rng_type and no stop, checkpoint or resume line */
+static struct SimContext *TestContext(char *inFileName, int rng_type)
+{
+	struct SimContext *ctx;
+
+	ctx=CreateSimContext(inFileName);
+	ctx->flagptr->RngType=rng_type;
+	if (rng_type==RNG_RAN3)
+		ctx->flagptr->NumThreads=1;
+	FreeConvStop(ctx);
+	FreeCheckpoint(ctx);
+	return ctx;
+}
+
+/*****************************************************************/
+/* bytes in which files a and b differ, -1 when one cannot be read */
+static long FileDiff(const char *a, const char *b)
+{
+	FILE *fa=fopen(a,"rb"),*fb=fopen(b,"rb");
+	long diff=0;
+	int ca,cb;
+
+	if ((fa==NULL)||(fb==NULL))
+		diff=-1;
+	else
+		do {
+			ca=fgetc(fa);
+			cb=fgetc(fb);
+			if (ca!=cb)
+				++diff;
+		} while ((ca!=EOF)||(cb!=EOF));
+	if (fa!=NULL)
+		fclose(fa);
+	if (fb!=NULL)
+		fclose(fb);
+	return diff;
+}
+
+/*****************************************************************/
+static int TestResume(char *inFileName, int rng_type)
+{
+	const char *name=(rng_type==RNG_PHILOX) ? "philox" : "ran3";
+	struct SimContext *ctx;
+	long diff;
+	int n;
+
+	/* uninterrupted */
+	ctx=TestContext(inFileName,rng_type);
+	n=ctx->source->num_photons;
+	SetCheckpoint(ctx,TEST_WHOLE,0);
+	RunMCLoop(ctx);
+	FreeSimContext(ctx);
+
+	/* half, checkpointed at the end */
+	ctx=TestContext(inFileName,rng_type);
+	ctx->source->num_photons=n/2;
+	SetCheckpoint(ctx,TEST_CKPT,0);
+	RunMCLoop(ctx);
+	FreeSimContext(ctx);
+
+	/* the rest, resumed */
+	ctx=TestContext(inFileName,rng_type);
+	SetResume(ctx,TEST_CKPT);
+	SetCheckpoint(ctx,TEST_RESUMED,0);
+	RunMCLoop(ctx);
+	FreeSimContext(ctx);
+
+	diff=FileDiff(TEST_WHOLE,TEST_RESUMED);
+	remove(TEST_CKPT);
+	remove(TEST_WHOLE);
+	remove(TEST_RESUMED);
+	if (diff!=0) {
+		printf("FAIL resume (%s): the tallies of %d+%d photons differ from one run in %ld bytes\n",
+			name,n/2,n-n/2,diff);
+		return 1;
+	}
+	printf("PASS resume (%s): %d+%d photons give the tallies of one run\n",name,n/2,n-n/2);
+	return 0;
+}
+
+/*****************************************************************/
+__declspec(dllexport) int SelfTestMC(char *inFileName)
+{
+	int failed=0;
+
+	failed+=TestPhilox();
+	failed+=TestResume(inFileName,RNG_PHILOX);
+	failed+=TestResume(inFileName,RNG_RAN3);
+	printf("%d of 3 self tests failed\n",failed);
+	return failed;
+}
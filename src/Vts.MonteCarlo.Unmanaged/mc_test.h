@@ -0,0 +1,9 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+__declspec(dllexport) int SelfTestMC(char *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
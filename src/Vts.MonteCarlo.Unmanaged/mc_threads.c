@@ -0,0 +1,330 @@
+/* Multithreaded photon loop.
+*
+*  The photon range 1..num_photons, or a batch of it (mc_conv.c), is
+*  split into contiguous chunks that are handed out to worker
+*  threads. Each worker traces with its own
+*  Photon, History, perturb and Output tallies, sharing only the
+*  read-only tissue, source, detector and flag definitions. When a
+*  chunk is done its tallies are added into the master context in
+*  chunk order, so for a given seed the results do not depend on
+*  thread scheduling. NormalizeResults then runs on the master exactly
+*  as in the serial case. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "mc_main.h"
+#include "pert.h"
+#include "mc_v.h"
+#include "mc_threads.h"
+#include "mc_white.h"
+#include "mc_detect.h"
+#include "mc_moment.h"
+#include "mc_ckpt.h"
+#include "mc_stats.h"
+#include "protos.h"
+
+#define MAX_CHUNKS 1024
+#define MIN_CHUNK_PHOTONS 256	/* keeps the batch engine's lanes full */
+
+/*****************************************************************/
+int NumWorkerThreads(struct SimContext *ctx)
+{
+	int num_threads=ctx->flagptr->NumThreads;
+
+#ifdef _OPENMP
+	if (num_threads<=0)
+		num_threads=omp_get_max_threads();
+#else
+	num_threads=1;
+#endif
+	/* no point in workers without photons to trace */
+	if (num_threads>ctx->source->num_photons)
+		num_threads=ctx->source->num_photons;
+	if (num_threads<1)
+		num_threads=1;
+	return num_threads;
+}
+
+/*****************************************************************/
+/* one worker context per thread, for RunChunks() */
+struct SimContext **StartWorkers(struct SimContext *ctx, int num_threads)
+{
+	struct SimContext **workers;
+	int w;
+
+	workers=(struct SimContext **)calloc(num_threads,sizeof(struct SimContext *));
+	for (w=0;w<num_threads;++w)
+		workers[w]=CloneWorkerContext(ctx,w+1);
+	return workers;
+}
+
+/*****************************************************************/
+void StopWorkers(struct SimContext **workers, int num_threads)
+{
+	int w;
+
+	for (w=0;w<num_threads;++w)
+		FreeWorkerContext(workers[w]);
+	free(workers);
+}
+
+/*****************************************************************/
+/* Photons first..last are cut into chunks whose size depends only */
+/* on the size of the range. A worker tallies one chunk at a time  */
+/* from zero and the chunk sums are added into ctx in chunk order, */
+/* so with the per-photon Philox streams the output is             */
+/* bit-identical for any number of threads. Photons up to done are */
+/* in ctx already (a checkpoint) and are skipped; resuming at a    */
+/* checkpoint of the same range gives the uninterrupted result.    */
+void RunChunks(struct SimContext *ctx, struct SimContext **workers, int num_threads,
+	int first_photon, int last_photon, int done, int show_status)
+{
+	int N=last_photon-first_photon+1;
+	int num_chunks=(N+MIN_CHUNK_PHOTONS-1)/MIN_CHUNK_PHOTONS;
+	int c;
+
+	if (num_chunks>MAX_CHUNKS)
+		num_chunks=MAX_CHUNKS;
+
+#ifdef _OPENMP
+#pragma omp parallel for ordered num_threads(num_threads) schedule(static,1)
+#else
+	(void)num_threads;
+#endif
+	for (c=0;c<num_chunks;++c) {
+		struct SimContext *wctx;
+		int first=(int)((long long)N*c/num_chunks)+1;
+		int last=(int)((long long)N*(c+1)/num_chunks);
+#ifdef _OPENMP
+		wctx=workers[omp_get_thread_num()];
+#else
+		wctx=workers[0];
+#endif
+		if (first_photon-1+last>done)
+			RunPhotonRange(wctx,(first_photon-1+first>done) ? first_photon-1+first : done+1,
+				first_photon-1+last);
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+		{
+			ReduceWorkerTallies(ctx,wctx);
+			if (ctx->conv==NULL)	/* convergence runs check after a batch */
+				CheckpointIfDue(ctx,first_photon-1+last);
+			if (show_status&&((10*(long long)last/N)>(10*(long long)(first-1)/N)))
+				DisplayStatus(last,N);
+		}
+	}
+}
+
+/*****************************************************************/
+/* the tallies already hold photons 1..done */
+void RunMCLoopParallel(struct SimContext *ctx, int num_threads, int done)
+{
+	struct SimContext **workers;
+	int N=ctx->source->num_photons;
+
+	printf("running %d photons on %d threads\n",N-done,num_threads);
+	workers=StartWorkers(ctx,num_threads);
+	RunChunks(ctx,workers,num_threads,1,N,done,1);
+	StopWorkers(workers,num_threads);
+}
+
+/*****************************************************************/
+static void ClearPertCounters(struct perturb *pertptr, int num_layers)
+{
+	pertptr->tot_phot=0;
+	pertptr->tot_rouletted=0;
+	memset(pertptr->col_in_layer,0,(num_layers+2)*sizeof(int));
+	memset(pertptr->pathlen_in_layer,0,(num_layers+2)*sizeof(double));
+	pertptr->tot_out_top=0;
+	pertptr->tot_out_bot=0;
+	pertptr->col_hit_bdry=0;
+}
+
+/*****************************************************************/
+/* Worker context: private photon state and zeroed tallies, shared */
+/* read-only problem definition.                                   */
+struct SimContext *CloneWorkerContext(struct SimContext *ctx, int worker)  /* worker>=1 */
+{
+	struct SimContext *wctx;
+
+	wctx=(struct SimContext *)calloc(1,sizeof(struct SimContext));
+	wctx->worker=worker;
+
+	/* shared, not written while tracing */
+	wctx->tissptr=ctx->tissptr;
+	wctx->source=ctx->source;
+	wctx->detector=ctx->detector;
+	wctx->flagptr=ctx->flagptr;
+	wctx->inclptr=ctx->inclptr;
+	wctx->voxptr=ctx->voxptr;
+	wctx->layers=ctx->layers;
+	wctx->delta=ctx->delta;
+	wctx->detptr=ctx->detptr;
+
+	wctx->photptr=(struct Photon *)malloc(sizeof(struct Photon));
+	memcpy(wctx->photptr,ctx->photptr,sizeof(struct Photon));
+	wctx->photptr->num_photons_written=(double *)calloc(DetectorSlots(ctx),sizeof(double));
+	if (ctx->detptr!=NULL)
+		wctx->det_wt=(double *)calloc(ctx->detptr->num,sizeof(double));
+
+	/* keep the user data (roulette, file name), own zeroed counters */
+	wctx->pertptr=(struct perturb *)malloc(sizeof(struct perturb));
+	memcpy(wctx->pertptr,ctx->pertptr,sizeof(struct perturb));
+	wctx->pertptr->col_in_layer=(int *)malloc((ctx->tissptr->num_layers+2)*sizeof(int));
+	wctx->pertptr->pathlen_in_layer=(double *)malloc((ctx->tissptr->num_layers+2)*sizeof(double));
+	ClearPertCounters(wctx->pertptr,ctx->tissptr->num_layers);
+
+	wctx->histptr=(struct History *)calloc(1,sizeof(struct History));
+	if (RECORD_HISTORY(wctx))
+		AllocHistory(wctx->histptr);
+
+	wctx->outptr=(struct Output *)calloc(1,sizeof(struct Output));
+	wctx->outptr->nomega=ctx->outptr->nomega;
+	wctx->dfreq=ctx->dfreq;
+	wctx->nfx=ctx->nfx;
+	wctx->dfx=ctx->dfx;
+	AllocTallies(wctx);
+	if (ctx->whiteptr!=NULL)
+		wctx->whiteptr=CloneWhiteMC(ctx);
+	if (ctx->bananaptr!=NULL) {
+		wctx->bananaptr=(struct bvolume *)malloc(sizeof(struct bvolume));
+		memcpy(wctx->bananaptr,ctx->bananaptr,sizeof(struct bvolume));
+		wctx->bananaptr->banana_photons=0;
+		wctx->allvox_trk.visits.record=ctx->allvox_trk.visits.record;
+		Alloc_Tally_allvox(wctx);
+	}
+
+	/* each worker gets its own ran3 stream; worker 1 reproduces the
+	   stream of a serial run. Philox streams are set per photon. */
+	wctx->rng.first_time=0;
+	wctx->rng.iff=0;
+	wctx->rng.idum=-worker;
+
+	SetupMoments(wctx);	/* after all of the worker's tallies */
+	return wctx;
+}
+
+/*****************************************************************/
+/* dst+=src and clear src for the worker's next chunk */
+static void DrainVector(double *dst, double *src, size_t n)
+{
+	size_t i;
+
+	for (i=0;i<n;++i) {
+		dst[i]+=src[i];
+		src[i]=0.0;
+	}
+}
+
+/* matrices are contiguous (AllocMatrix), drain rows and padding in one pass */
+static void DrainMatrix(double **dst, double **src)
+{
+	struct MatrixInfo *d=MatrixInfoOf(dst,0), *s=MatrixInfoOf(src,0);
+
+	DrainVector(d->data,s->data,(size_t)d->rows*d->stride);
+}
+
+/*****************************************************************/
+/* add the worker's tallies into ctx and zero them */
+void ReduceWorkerTallies(struct SimContext *ctx, struct SimContext *wctx)
+{
+	struct Output *out=ctx->outptr, *wout=wctx->outptr;
+	short nr=ctx->detector->nr;
+	short nz=ctx->detector->nz;
+	short na=ctx->detector->na;
+	int i;
+
+	DrainMatrix(out->A_rz,wout->A_rz);
+	DrainVector(out->A_z,wout->A_z,nz);
+	DrainVector(out->A_layer,wout->A_layer,ctx->tissptr->num_layers+2);
+	DrainMatrix(out->Flu_rz,wout->Flu_rz);
+	DrainVector(out->Flu_z,wout->Flu_z,nz);
+	DrainMatrix(out->R_ra,wout->R_ra);
+	DrainVector(out->R_r,wout->R_r,nr);
+	DrainVector(out->R_r2,wout->R_r2,nr);
+	DrainMatrix(out->R_rt,wout->R_rt);
+	if (out->nomega>0) {
+		DrainMatrix(out->re_rw,wout->re_rw);
+		DrainMatrix(out->im_rw,wout->im_rw);
+	}
+	if (ctx->nfx>0) {
+		DrainVector(ctx->R_fx_re,wctx->R_fx_re,ctx->nfx);
+		DrainVector(ctx->R_fx_im,wctx->R_fx_im,ctx->nfx);
+	}
+	DrainVector(out->R_a,wout->R_a,na);
+	DrainMatrix(out->T_ra,wout->T_ra);
+	DrainVector(out->T_r,wout->T_r,nr);
+	DrainVector(out->T_a,wout->T_a,na);
+	DrainMatrix(out->R_xy,wout->R_xy);
+	DrainVector(&out->wt_pathlen_out_top,&wout->wt_pathlen_out_top,1);
+	DrainVector(&out->wt_pathlen_out_bot,&wout->wt_pathlen_out_bot,1);
+	DrainVector(&out->wt_pathlen_out_sides,&wout->wt_pathlen_out_sides,1);
+
+	if ((ctx->bananaptr!=NULL)&&(wctx->bananaptr!=NULL)) {
+		/* in_side, out_side and visits, back to back in the tally block */
+		DrainVector(out->in_side_allvox,wout->in_side_allvox,
+			ctx->bananaptr->num_tally);
+		ctx->bananaptr->banana_photons+=wctx->bananaptr->banana_photons;
+		wctx->bananaptr->banana_photons=0;
+	}
+
+	ctx->pertptr->tot_phot+=wctx->pertptr->tot_phot;
+	ctx->pertptr->tot_rouletted+=wctx->pertptr->tot_rouletted;
+	for (i=0;i<ctx->tissptr->num_layers+2;++i) {
+		ctx->pertptr->col_in_layer[i]+=wctx->pertptr->col_in_layer[i];
+		ctx->pertptr->pathlen_in_layer[i]+=wctx->pertptr->pathlen_in_layer[i];
+	}
+	ctx->pertptr->tot_out_top+=wctx->pertptr->tot_out_top;
+	ctx->pertptr->tot_out_bot+=wctx->pertptr->tot_out_bot;
+	ctx->pertptr->col_hit_bdry+=wctx->pertptr->col_hit_bdry;
+	ClearPertCounters(wctx->pertptr,ctx->tissptr->num_layers);
+
+	DrainVector(ctx->photptr->num_photons_written,wctx->photptr->num_photons_written,DetectorSlots(ctx));
+	if (ctx->detptr!=NULL)
+		DrainVector(ctx->det_wt,wctx->det_wt,ctx->detptr->num);
+	ReduceMoments(ctx,wctx);
+	if (ctx->whiteptr!=NULL)
+		ReduceWhiteMC(ctx,ctx->whiteptr,wctx->whiteptr);
+	STATS_REDUCE(ctx,wctx);
+}
+
+/*****************************************************************/
+void FreeWorkerContext(struct SimContext *wctx)
+{
+	if (wctx->bananaptr!=NULL) {
+		Free_Tally_allvox(wctx);
+		free(wctx->bananaptr);
+		Free_Visits_allvox(wctx);
+	}
+	if (wctx->whiteptr!=NULL)
+		FreeWhiteMC(wctx,wctx->whiteptr);
+	FreeMoments(wctx);
+	FreeMemory(wctx);
+	free(wctx->outptr);
+
+	free(wctx->histptr->xh);
+	free(wctx->histptr->yh);
+	free(wctx->histptr->zh);
+	free(wctx->histptr->uxh);
+	free(wctx->histptr->uyh);
+	free(wctx->histptr->uzh);
+	free(wctx->histptr->weight);
+	free(wctx->histptr->pert_wt);
+	free(wctx->histptr->path_length);
+	free(wctx->histptr->boundary_col);
+	free(wctx->histptr);
+
+	free(wctx->photptr->num_photons_written);
+	free(wctx->photptr);
+	free(wctx->det_wt);
+	/* roulette settings are the master's */
+	free(wctx->pertptr->col_in_layer);
+	free(wctx->pertptr->pathlen_in_layer);
+	free(wctx->pertptr);
+	free(wctx);
+}
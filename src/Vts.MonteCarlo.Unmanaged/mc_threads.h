@@ -0,0 +1,18 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+int NumWorkerThreads(struct SimContext *);
+void RunMCLoopParallel(struct SimContext *, int, int);
+struct SimContext **StartWorkers(struct SimContext *, int);
+void StopWorkers(struct SimContext **, int);
+void RunChunks(struct SimContext *, struct SimContext **, int, int, int, int, int);
+struct SimContext *CloneWorkerContext(struct SimContext *, int);
+void ReduceWorkerTallies(struct SimContext *, struct SimContext *);
+void FreeWorkerContext(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -1,295 +1,397 @@
-#include <stdio.h>
-#include <math.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-
-#include "mc_main.h"
-#include "mc_utils.h"
-#include "protos.h"
-
-#define Boolean char
-//#define STANDARDTEST 1 // field in flags structure now
-#define ONE (1.0-1e-12)
-#define NR_END 1
-#define FREE_ARG char*
-
-extern struct Photon *photptr;
-extern struct Flags *flagptr;
-extern struct Tissue *tissptr;
-
-/*****************************************************************/
-
-/* random number generator */
-#define MBIG 1000000000
-#define MSEED 161803398
-#define MZ 0
-#define FAC 1.0E-9
-
-double ran3(int *idum)
-{
-  static int inext,inextp;
-  static long ma[56];
-  static int iff=0;
-  long mj,mk;
-  int i,ii,k;
-
-  if (*idum < 0 || iff == 0) {
-    iff=1;
-    mj=MSEED-(*idum < 0 ? -*idum : *idum);
-    mj %= MBIG;
-    ma[55]=mj;
-    mk=1;
-    for (i=1;i<=54;i++) {
-      ii=(21*i) % 55;
-      ma[ii]=mk;
-      mk=mj-mk;
-      if (mk < MZ) mk += MBIG;
-      mj=ma[ii];
-    }
-    for (k=1;k<=4;k++)
-      for (i=1;i<=55;i++) {
-        ma[i] -= ma[1+(i+30) % 55];
-        if (ma[i] < MZ) ma[i] += MBIG;
-      }
-    inext=0;
-    inextp=31;
-    *idum=1;
-  }
-  if (++inext == 56) inext=1;
-  if (++inextp == 56) inextp=1;
-  mj=ma[inext]-ma[inextp];
-  if (mj < MZ) mj += MBIG;
-  ma[inext]=mj;
-  return (double)mj*FAC;  
-}
-
-#undef MBIG
-#undef MSEED
-#undef MZ
-#undef FAC
-
-/*****************************************************************/
-/* generate Random number using ran3(). */
-/*      Taken from Numerical Recipes in C */
-__declspec(dllexport) double RandomNum(void)
-{
-  static Boolean first_time=1;
-  static int idum;      /* seed for ran3. */
-  double RN;
-
-  if(first_time) {
-//#if STANDARDTEST /* Use fixed seed to test the program. */
-  if (flagptr->Seed==0) 
-    idum = - 1;
-//#else
-  else
-    idum = -(int)time(NULL)%(1<<15);
-    /* use 16-bit integer as the seed. */
-//#endif
-    //ran3(&idum);  // CKH FIX to match managed
-    first_time = 0;
-    idum = 1;
-  }
-  RN = ran3(&idum);
-  return( RN ); 
-  //return( (double)ran3(&idum) ); 
-}
-
-/*****************************************************************/
-double ***d3tensor(long nrl, long nrh, long ncl, long nch, long ndl, long ndh)
-/* allocate a double 3tensor with range t[nrl..nrh][ncl..nch][ndl..ndh] */
-/* from f3tensor in nrutil.c */
-{
-	long i,j,nrow=nrh-nrl+1,ncol=nch-ncl+1,ndep=ndh-ndl+1;
-	double ***t;
-
-	/* allocate pointers to pointers to rows */
-	t=(double ***) malloc((size_t)((nrow+NR_END)*sizeof(double**)));
-	if (!t) nrerror("allocation failure 1 in d3tensor()");
-	t += NR_END;
-	t -= nrl;
-
-	/* allocate pointers to rows and set pointers to them */
-	t[nrl]=(double **) malloc((size_t)((nrow*ncol+NR_END)*sizeof(double*)));
-	if (!t[nrl]) nrerror("allocation failure 2 in d3tensor()");
-	t[nrl] += NR_END;
-	t[nrl] -= ncl;
-
-	/* allocate rows and set pointers to them */
-	t[nrl][ncl]=(double *) malloc((size_t)((nrow*ncol*ndep+NR_END)*sizeof(double)));
-	if (!t[nrl][ncl]) nrerror("allocation failure 3 in d3tensor()");
-	t[nrl][ncl] += NR_END;
-	t[nrl][ncl] -= ndl;
-
-	for(j=ncl+1;j<=nch;j++) t[nrl][j]=t[nrl][j-1]+ndep;
-	for(i=nrl+1;i<=nrh;i++) {
-		t[i]=t[i-1]+ncol;
-		t[i][ncl]=t[i-1][ncl]+ncol*ndep;
-		for(j=ncl+1;j<=nch;j++) t[i][j]=t[i][j-1]+ndep;
-	}
-
-	/* return pointer to array of pointers to rows */
-	return t;
-}
-/*****************************************************************/
-/* THIS NEEDS WORK DO NOT USE! */
-double ****d4tensor(long nrl, long nrh, long ncl, long nch, 
-       long ndl, long ndh, long nel, long neh)
-/* allocate a double 3tensor with range */
-/* t[nrl..nrh][ncl..nch][ndl..ndh][nel..neh] */
-/* from f3tensor in nrutil.c */
-{
-	long i,j,k,nrow=nrh-nrl+1,ncol=nch-ncl+1,ndep=ndh-ndl+1;
-        long ndep2=neh-nel+1;
-	double ****t;
-
-	/* allocate pointers to pointers to pointers to rows */
-	t=(double ****) malloc((size_t)((nrow+NR_END)*sizeof(double***)));
-	if (!t) nrerror("allocation failure 1 in d4tensor()");
-	t += NR_END;
-	t -= nrl;
-
-	/* allocate pointers to pointers to rows and set pointers to them */
-	t[nrl]=(double ***) malloc((size_t)((nrow*ncol+NR_END)*
-          sizeof(double**)));
-	if (!t[nrl]) nrerror("allocation failure 2 in d4tensor()");
-	t[nrl] += NR_END;
-	t[nrl] -= ncl;
-
-	/* allocate pointers to rows and set pointers to them */
-	t[nrl][ncl]=(double **) malloc((size_t)
-          ((nrow*ncol*ndep+NR_END)*sizeof(double*)));
-	if (!t[nrl][ncl]) nrerror("allocation failure 3 in d4tensor()");
-	t[nrl][ncl] += NR_END;
-	t[nrl][ncl] -= ndl;
-
-	/* allocate rows and set pointers to them */
-	t[nrl][ncl][ndl]=(double *) malloc((size_t)
-          ((nrow*ncol*ndep*ndep2+NR_END)*sizeof(double)));
-	if (!t[nrl][ncl][ndl]) nrerror("allocation failure 4 in d4tensor()");
-	t[nrl][ncl][ndl] += NR_END;
-	t[nrl][ncl][ndl] -= nel;
-
-	for(j=ndl+1;j<=ndh;j++) t[nrl][ncl][j]=t[nrl][ncl][j-1]+ndep2;
-	for(i=nrl+1;i<=nrh;i++) {
-		t[i]=t[i-1]+ncol;
-		t[i][ncl]=t[i-1][ncl]+ncol*ndep;
-		t[i][ncl][ndl]=t[i-1][ncl][ndl]+ncol*ndep*ndep2;
-		for(j=ncl+1;j<=nch;j++) {
-                   t[i][j]=t[i][j-1]+ndep*ndep2;
-		   for(k=ndl+1;k<=ndh;k++) 
-                     t[i][j][k]=t[i][j][k-1]+ndep2;
-                }
-	}
-
-	/* return pointer to array of pointers to rows */
-	return t;
-}
-
-/*****************************************************************/
-void free_d3tensor(double ***t, long nrl, long nrh, long ncl, long nch,
-	long ndl, long ndh)
-/* free a double d3tensor allocated by d3tensor() */
-{
-	free((FREE_ARG) (t[nrl][ncl]+ndl-NR_END));
-	free((FREE_ARG) (t[nrl]+ncl-NR_END));
-	free((FREE_ARG) (t+nrl-NR_END));
-}
-/*****************************************************************/
-void free_d4tensor(double ****t, long nrl, long nrh, long ncl, long nch,
-	long ndl, long ndh, long nel, long neh)
-/* free a double d4tensor allocated by d4tensor() */
-{
-	free((FREE_ARG) (t[nrl][ncl][ndl]+nel-NR_END));
-	free((FREE_ARG) (t[nrl][ncl]+ndl-NR_END));
-	free((FREE_ARG) (t[nrl]+ncl-NR_END));
-	free((FREE_ARG) (t+nrl-NR_END));
-}
-/*****************************************************************/
-void Write_3_Bytes(double double_var, FILE * fptr)
-{
-  unsigned char *out_array_ptr;
-  unsigned char out_array[3];
-  unsigned char res;
-  int int_var;
-  unsigned int in, abs_int_var;
-  
-  /* convert double to an  integer */
-  if(double_var<0)
-    int_var = (int)(double_var*1e5-0.5);
-  else
-    int_var = (int)(double_var*1e5+0.5);
-
-  if (int_var<0)
-    abs_int_var= -1*int_var;
-  else
-    abs_int_var=int_var;
-  
-  /* first 8 bits */
-  in=abs_int_var & 0xff;
-  res=in;
-  out_array_ptr=out_array;
-  *out_array_ptr=res;
-  
-  /* 2nd 8 bits */
-  in=abs_int_var & 0xff00;
-  res=in >> 8;
-  out_array_ptr++;
-  *out_array_ptr=res;
-  
-  /* last 8 bits */
-  in=abs_int_var & 0xff0000;
-  res=in >> 16;
-  if(int_var<0)
-    res=res|128;
-  out_array_ptr++;
-  *out_array_ptr=res;
-  
-  /* now write 3 bytes to output file */
-  fwrite(out_array,3,1,fptr);
-}
-/************************************************************/
-double Char3_To_Double(unsigned char * in_array_ptr)
-{
-  unsigned int rest_int1,rest_int2,rest_int3,restored_int;
-  unsigned char res;
-  double restored_double, sign;
-  
-  res= *in_array_ptr;
-  rest_int1= res;
-  
-  in_array_ptr++;
-  res= *in_array_ptr;
-  rest_int2= res << 8;
-  
-  in_array_ptr++;
-  res= *in_array_ptr;
-  if(res&128)
-    { res = res-128;
-    sign= -1.0;
-    }
-  else
-    sign=1.0;
-  rest_int3= res << 16;
-  
-  restored_int=rest_int1+rest_int2+rest_int3;
-  restored_double= sign*((double)(restored_int))*1e-5;
-  /*printf("%.6f\n",restored_double);*/
-  return(restored_double);
-}
-
-/************************************************************/
-
-double Specular()
-{
-  double R;
-  double n_air = tissptr->layerprops[0].n;
-  double n_tiss = tissptr->layerprops[1].n;
-  
-  R = (n_air-n_tiss)*(n_air-n_tiss)/((n_air+n_tiss)*(n_air+n_tiss));
-  /* printf("Specular: n_air=%f n_tiss=%f R=%f\n",n_air,n_tiss,R); */
-  return(R);
-}
-
-/********************************************************/
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mc_main.h"
+#include "mc_utils.h"
+#include "protos.h"
+
+#define Boolean char
+//#define STANDARDTEST 1 // field in flags structure now
+#define ONE (1.0-1e-12)
+#define NR_END 1
+#define FREE_ARG char*
+
+/*****************************************************************/
+
+/* random number generator */
+#define MBIG 1000000000
+#define MSEED 161803398
+#define MZ 0
+#define FAC 1.0E-9
+
+double ran3(struct Ran3State *rng)
+{
+  /* state lives in the simulation context so that runs do not share it */
+  long *ma=rng->ma;
+  int *idum=&rng->idum;
+  long mj,mk;
+  int i,ii,k;
+
+  if (*idum < 0 || rng->iff == 0) {
+    rng->iff=1;
+    mj=MSEED-(*idum < 0 ? -*idum : *idum);
+    mj %= MBIG;
+    ma[55]=mj;
+    mk=1;
+    for (i=1;i<=54;i++) {
+      ii=(21*i) % 55;
+      ma[ii]=mk;
+      mk=mj-mk;
+      if (mk < MZ) mk += MBIG;
+      mj=ma[ii];
+    }
+    for (k=1;k<=4;k++)
+      for (i=1;i<=55;i++) {
+        ma[i] -= ma[1+(i+30) % 55];
+        if (ma[i] < MZ) ma[i] += MBIG;
+      }
+    rng->inext=0;
+    rng->inextp=31;
+    *idum=1;
+  }
+  if (++rng->inext == 56) rng->inext=1;
+  if (++rng->inextp == 56) rng->inextp=1;
+  mj=ma[rng->inext]-ma[rng->inextp];
+  if (mj < MZ) mj += MBIG;
+  ma[rng->inext]=mj;
+  return (double)mj*FAC;  
+}
+
+#undef MBIG
+#undef MSEED
+#undef MZ
+#undef FAC
+
+/*****************************************************************/
+/* Philox4x32-10 counter-based generator (Salmon et al., SC11).   */
+/* Every random number is a pure function of (key, counter), so   */
+/* each photon owns a stream keyed by seed and photon index and   */
+/* the result does not depend on which thread traced it.          */
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+#define TWO_M32 (1.0/4294967296.0)
+
+void Philox4x32(const unsigned int key_in[2], const unsigned int ctr_in[4],
+  unsigned int out[4])
+{
+  unsigned int k0=key_in[0],k1=key_in[1];
+  unsigned int c0=ctr_in[0],c1=ctr_in[1],c2=ctr_in[2],c3=ctr_in[3];
+  PHILOX_U64 p0,p1;
+  int round;
+
+  for (round=0;round<10;round++) {
+    p0=(PHILOX_U64)PHILOX_M0*c0;
+    p1=(PHILOX_U64)PHILOX_M1*c2;
+    c0=(unsigned int)(p1>>32)^c1^k0;
+    c2=(unsigned int)(p0>>32)^c3^k1;
+    c1=(unsigned int)p1;
+    c3=(unsigned int)p0;
+    k0+=PHILOX_W0;
+    k1+=PHILOX_W1;
+  }
+  out[0]=c0; out[1]=c1; out[2]=c2; out[3]=c3;
+}
+
+/* uniform on the open interval (0,1) so log() and 1/x are safe */
+#define U32_TO_OPEN01(u) (((double)(u)+0.5)*TWO_M32)
+
+/*****************************************************************/
+/* position ctx's Philox stream at the start of photon n */
+void SeedPhotonStream(struct SimContext *ctx, int n)
+{
+  struct PhiloxState *prng=&ctx->prng;
+
+  prng->key[0]=(unsigned int)ctx->flagptr->Seed;
+  prng->key[1]=0;
+  prng->ctr[0]=0;	/* block within the photon's stream */
+  prng->ctr[1]=0;
+  prng->ctr[2]=(unsigned int)n;	/* photon index */
+  prng->ctr[3]=0;
+  prng->next=4;	/* buffer empty */
+}
+
+/*****************************************************************/
+double PhiloxNum(struct PhiloxState *prng)
+{
+  unsigned int out[4];
+  int i;
+
+  if (prng->next>=4) {
+    Philox4x32(prng->key,prng->ctr,out);
+    if (++prng->ctr[0]==0) ++prng->ctr[1];
+    for (i=0;i<4;i++)
+      prng->buf[i]=U32_TO_OPEN01(out[i]);
+    prng->next=0;
+  }
+  return prng->buf[prng->next++];
+}
+
+/*****************************************************************/
+/* Fill rn[0..num-1] with the next num numbers of ctx's stream,   */
+/* a whole Philox block at a time. Gives the same numbers as num  */
+/* calls to RandomNum(). ran3 runs fall back to RandomNum().      */
+__declspec(dllexport) void RandomFill(struct SimContext *ctx, double *rn, int num)
+{
+  struct PhiloxState *prng=&ctx->prng;
+  unsigned int out[4];
+  int i=0;
+
+  if (ctx->flagptr->RngType!=RNG_PHILOX) {
+    for (i=0;i<num;i++)
+      rn[i]=RandomNum(ctx);
+    return;
+  }
+  /* drain what is left of the current block */
+  while ((i<num)&&(prng->next<4))
+    rn[i++]=prng->buf[prng->next++];
+  /* whole blocks straight into the caller's array */
+  for (;i+4<=num;i+=4) {
+    Philox4x32(prng->key,prng->ctr,out);
+    if (++prng->ctr[0]==0) ++prng->ctr[1];
+    rn[i]=U32_TO_OPEN01(out[0]);
+    rn[i+1]=U32_TO_OPEN01(out[1]);
+    rn[i+2]=U32_TO_OPEN01(out[2]);
+    rn[i+3]=U32_TO_OPEN01(out[3]);
+  }
+  for (;i<num;i++)
+    rn[i]=PhiloxNum(prng);
+}
+
+#undef PHILOX_M0
+#undef PHILOX_M1
+#undef PHILOX_W0
+#undef PHILOX_W1
+#undef TWO_M32
+#undef U32_TO_OPEN01
+
+/*****************************************************************/
+/* generate Random number using ran3() or Philox (Flags.RngType) */
+/*      ran3 taken from Numerical Recipes in C */
+__declspec(dllexport) double RandomNum(struct SimContext *ctx)
+{
+  struct Ran3State *rng=&ctx->rng;
+  double RN;
+
+  if (ctx->flagptr->RngType==RNG_PHILOX)
+    return PhiloxNum(&ctx->prng);
+
+  if(rng->first_time) {
+//#if STANDARDTEST /* Use fixed seed to test the program. */
+  if (ctx->flagptr->Seed==0) 
+    rng->idum = - 1;
+//#else
+  else
+    rng->idum = -(int)time(NULL)%(1<<15);
+    /* use 16-bit integer as the seed. */
+//#endif
+    //ran3(&idum);  // CKH FIX to match managed
+    rng->first_time = 0;
+    rng->idum = 1;
+  }
+  RN = ran3(rng);
+  return( RN ); 
+  //return( (double)ran3(&idum) ); 
+}
+
+/*****************************************************************/
+double ***d3tensor(long nrl, long nrh, long ncl, long nch, long ndl, long ndh)
+/* allocate a double 3tensor with range t[nrl..nrh][ncl..nch][ndl..ndh] */
+/* from f3tensor in nrutil.c */
+{
+	long i,j,nrow=nrh-nrl+1,ncol=nch-ncl+1,ndep=ndh-ndl+1;
+	double ***t;
+
+	/* allocate pointers to pointers to rows */
+	t=(double ***) malloc((size_t)((nrow+NR_END)*sizeof(double**)));
+	if (!t) nrerror("allocation failure 1 in d3tensor()");
+	t += NR_END;
+	t -= nrl;
+
+	/* allocate pointers to rows and set pointers to them */
+	t[nrl]=(double **) malloc((size_t)((nrow*ncol+NR_END)*sizeof(double*)));
+	if (!t[nrl]) nrerror("allocation failure 2 in d3tensor()");
+	t[nrl] += NR_END;
+	t[nrl] -= ncl;
+
+	/* allocate rows and set pointers to them */
+	t[nrl][ncl]=(double *) malloc((size_t)((nrow*ncol*ndep+NR_END)*sizeof(double)));
+	if (!t[nrl][ncl]) nrerror("allocation failure 3 in d3tensor()");
+	t[nrl][ncl] += NR_END;
+	t[nrl][ncl] -= ndl;
+
+	for(j=ncl+1;j<=nch;j++) t[nrl][j]=t[nrl][j-1]+ndep;
+	for(i=nrl+1;i<=nrh;i++) {
+		t[i]=t[i-1]+ncol;
+		t[i][ncl]=t[i-1][ncl]+ncol*ndep;
+		for(j=ncl+1;j<=nch;j++) t[i][j]=t[i][j-1]+ndep;
+	}
+
+	/* return pointer to array of pointers to rows */
+	return t;
+}
+/*****************************************************************/
+/* THIS NEEDS WORK DO NOT USE! */
+double ****d4tensor(long nrl, long nrh, long ncl, long nch, 
+       long ndl, long ndh, long nel, long neh)
+/* allocate a double 3tensor with range */
+/* t[nrl..nrh][ncl..nch][ndl..ndh][nel..neh] */
+/* from f3tensor in nrutil.c */
+{
+	long i,j,k,nrow=nrh-nrl+1,ncol=nch-ncl+1,ndep=ndh-ndl+1;
+        long ndep2=neh-nel+1;
+	double ****t;
+
+	/* allocate pointers to pointers to pointers to rows */
+	t=(double ****) malloc((size_t)((nrow+NR_END)*sizeof(double***)));
+	if (!t) nrerror("allocation failure 1 in d4tensor()");
+	t += NR_END;
+	t -= nrl;
+
+	/* allocate pointers to pointers to rows and set pointers to them */
+	t[nrl]=(double ***) malloc((size_t)((nrow*ncol+NR_END)*
+          sizeof(double**)));
+	if (!t[nrl]) nrerror("allocation failure 2 in d4tensor()");
+	t[nrl] += NR_END;
+	t[nrl] -= ncl;
+
+	/* allocate pointers to rows and set pointers to them */
+	t[nrl][ncl]=(double **) malloc((size_t)
+          ((nrow*ncol*ndep+NR_END)*sizeof(double*)));
+	if (!t[nrl][ncl]) nrerror("allocation failure 3 in d4tensor()");
+	t[nrl][ncl] += NR_END;
+	t[nrl][ncl] -= ndl;
+
+	/* allocate rows and set pointers to them */
+	t[nrl][ncl][ndl]=(double *) malloc((size_t)
+          ((nrow*ncol*ndep*ndep2+NR_END)*sizeof(double)));
+	if (!t[nrl][ncl][ndl]) nrerror("allocation failure 4 in d4tensor()");
+	t[nrl][ncl][ndl] += NR_END;
+	t[nrl][ncl][ndl] -= nel;
+
+	for(j=ndl+1;j<=ndh;j++) t[nrl][ncl][j]=t[nrl][ncl][j-1]+ndep2;
+	for(i=nrl+1;i<=nrh;i++) {
+		t[i]=t[i-1]+ncol;
+		t[i][ncl]=t[i-1][ncl]+ncol*ndep;
+		t[i][ncl][ndl]=t[i-1][ncl][ndl]+ncol*ndep*ndep2;
+		for(j=ncl+1;j<=nch;j++) {
+                   t[i][j]=t[i][j-1]+ndep*ndep2;
+		   for(k=ndl+1;k<=ndh;k++) 
+                     t[i][j][k]=t[i][j][k-1]+ndep2;
+                }
+	}
+
+	/* return pointer to array of pointers to rows */
+	return t;
+}
+
+/*****************************************************************/
+void free_d3tensor(double ***t, long nrl, long nrh, long ncl, long nch,
+	long ndl, long ndh)
+/* free a double d3tensor allocated by d3tensor() */
+{
+	free((FREE_ARG) (t[nrl][ncl]+ndl-NR_END));
+	free((FREE_ARG) (t[nrl]+ncl-NR_END));
+	free((FREE_ARG) (t+nrl-NR_END));
+}
+/*****************************************************************/
+void free_d4tensor(double ****t, long nrl, long nrh, long ncl, long nch,
+	long ndl, long ndh, long nel, long neh)
+/* free a double d4tensor allocated by d4tensor() */
+{
+	free((FREE_ARG) (t[nrl][ncl][ndl]+nel-NR_END));
+	free((FREE_ARG) (t[nrl][ncl]+ndl-NR_END));
+	free((FREE_ARG) (t[nrl]+ncl-NR_END));
+	free((FREE_ARG) (t+nrl-NR_END));
+}
+/*****************************************************************/
+void Write_3_Bytes(double double_var, FILE * fptr)
+{
+  unsigned char *out_array_ptr;
+  unsigned char out_array[3];
+  unsigned char res;
+  int int_var;
+  unsigned int in, abs_int_var;
+  
+  /* convert double to an  integer */
+  if(double_var<0)
+    int_var = (int)(double_var*1e5-0.5);
+  else
+    int_var = (int)(double_var*1e5+0.5);
+
+  if (int_var<0)
+    abs_int_var= -1*int_var;
+  else
+    abs_int_var=int_var;
+  
+  /* first 8 bits */
+  in=abs_int_var & 0xff;
+  res=in;
+  out_array_ptr=out_array;
+  *out_array_ptr=res;
+  
+  /* 2nd 8 bits */
+  in=abs_int_var & 0xff00;
+  res=in >> 8;
+  out_array_ptr++;
+  *out_array_ptr=res;
+  
+  /* last 8 bits */
+  in=abs_int_var & 0xff0000;
+  res=in >> 16;
+  if(int_var<0)
+    res=res|128;
+  out_array_ptr++;
+  *out_array_ptr=res;
+  
+  /* now write 3 bytes to output file */
+  fwrite(out_array,3,1,fptr);
+}
+/************************************************************/
+double Char3_To_Double(unsigned char * in_array_ptr)
+{
+  unsigned int rest_int1,rest_int2,rest_int3,restored_int;
+  unsigned char res;
+  double restored_double, sign;
+  
+  res= *in_array_ptr;
+  rest_int1= res;
+  
+  in_array_ptr++;
+  res= *in_array_ptr;
+  rest_int2= res << 8;
+  
+  in_array_ptr++;
+  res= *in_array_ptr;
+  if(res&128)
+    { res = res-128;
+    sign= -1.0;
+    }
+  else
+    sign=1.0;
+  rest_int3= res << 16;
+  
+  restored_int=rest_int1+rest_int2+rest_int3;
+  restored_double= sign*((double)(restored_int))*1e-5;
+  /*printf("%.6f\n",restored_double);*/
+  return(restored_double);
+}
+
+/************************************************************/
+
+double Specular(struct SimContext *ctx)
+{
+  double R;
+  double n_air = ctx->tissptr->layerprops[0].n;
+  double n_tiss = ctx->tissptr->layerprops[1].n;
+  
+  R = (n_air-n_tiss)*(n_air-n_tiss)/((n_air+n_tiss)*(n_air+n_tiss));
+  /* printf("Specular: n_air=%f n_tiss=%f R=%f\n",n_air,n_tiss,R); */
+  return(R);
+}
+
+/********************************************************/
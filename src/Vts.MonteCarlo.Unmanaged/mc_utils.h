@@ -1,12 +1,14 @@
-#ifdef __cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
-#include<stdio.h>
-
-double Specular(void);
-
-#ifdef __cplusplus
-}
-#endif /* __cplusplus */
-
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include<stdio.h>
+
+struct SimContext;
+
+double Specular(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
@@ -1,49 +1,66 @@
-#ifdef __cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
-struct bvolume{
-  double dx,dy,dz;
-  int nx,ny,nz;
-  int banana_photons;  /* number of photons contributing to banana */
-  int num_mu;
-  int num_phi;
-  int num_sa;
-};
-
-struct vox_list{  /* used only by allvox */
-  int ix,iy,iz;
-  int col;  
-  int sa_idx; 
-  struct vox_list *next;
-};
-
-void init_banana_plane(void);
-void init_banana_cube(void);
-void init_banana_allvox(void);
-void Compute_Banana(void);
-void Compute_Prob_plane(void);
-void Compute_Prob_cube(void);
-void Write_Wt_Table(FILE *, double ***);
-void Read_Wt_Table(void);
-void Output_Wts_plane(void);
-void Output_Wts_cube(void);
-void Output_Wts_allvox(void);
-void Free_List(struct vox_list *);
-void Add_To_List(struct vox_list **,int,int,int,int,int);
-void Angular_Bin_plane(double,double,double,double,double,double,
-		int,int *,int *);
-void Angular_Bin_cube(double,double,double,double,double,double,
-		int,int *,int *);
-int Angular_Bin_allvox(double,double,double,double,double,double);
-void Ray_Intersect_Cube(double,double,double,double,double,double,
-		      double,double,double,double,double,double, 
-		      int *,int *,int *, int *, int *, int *, int *,
-                      double *,double *);
-int Ray_Intersect_Plane(double,double,double,double,double,double,
-                    double *,double *,double *);
-
-
-#ifdef __cplusplus
-}
-#endif /* __cplusplus */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+
+struct SimContext;
+
+#define NUM_SIDES 6  /* voxel faces: 0=top,1=front,2=left,3=back,4=right,5=bot */
+#define ALLVOX_STRIDE 8  /* NUM_SIDES faces padded to one 64-byte line per voxel */
+
+/* in_side_allvox/out_side_allvox are each [ix][iy][iz][ALLVOX_STRIDE] */
+/* with the faces innermost, so a voxel visit touches one cache line  */
+#define VOX_IDX(b,ix,iy,iz) \
+  (((size_t)(ix)*(b)->ny+(iy))*(b)->nz+(iz))
+#define ALLVOX_IDX(b,ix,iy,iz,side) \
+  (VOX_IDX(b,ix,iy,iz)*ALLVOX_STRIDE+(side))
+
+struct bvolume{
+  double dx,dy,dz;
+  int nx,ny,nz;
+  size_t num_vox;  /* nx*ny*nz */
+  void *tally_block;  /* holds in_side_allvox, out_side_allvox, visits_allvox */
+  size_t num_tally;  /* doubles in tally_block */
+  int *visit_stamp;  /* photon that last entered each voxel, for visits */
+  int banana_photons;  /* number of photons contributing to banana */
+  int num_mu;
+  int num_phi;
+  int num_sa;
+};
+
+void init_banana_plane(void);
+void init_banana_cube(void);
+void init_banana_allvox(struct SimContext *);
+void Alloc_Tally_allvox(struct SimContext *);
+void Free_Tally_allvox(struct SimContext *);
+void Compute_Banana(void);
+void Compute_Prob_plane(void);
+void Compute_Prob_cube(void);
+void Compute_Prob_allvox(struct SimContext *);
+void Start_Track_allvox(struct SimContext *);
+void Score_Track_allvox(struct SimContext *,double,double,double,double,double,double);
+void Write_Wt_Table(FILE *, double ***);
+void Read_Wt_Table(void);
+void Output_Wts_plane(void);
+void Output_Wts_cube(void);
+void Output_Wts_allvox(struct SimContext *);
+void Add_Visit_allvox(struct SimContext *,int,int,int,int,int);
+void Count_Visits_allvox(struct SimContext *);
+void Free_Visits_allvox(struct SimContext *);
+void Angular_Bin_plane(double,double,double,double,double,double,
+		int,int *,int *);
+void Angular_Bin_cube(double,double,double,double,double,double,
+		int,int *,int *);
+int Angular_Bin_allvox(double,double,double,double,double,double);
+void Ray_Intersect_Cube(double,double,double,double,double,double,
+		      double,double,double,double,double,double, 
+		      int *,int *,int *, int *, int *, int *, int *,
+                      double *,double *);
+int Ray_Intersect_Plane(double,double,double,double,double,double,
+                    double *,double *,double *);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,274 @@
+/* Voxelized tissue (do_ellip_layer==5).
+*
+*  The slab 0<=z<=nz*dz is a grid of 8-bit material ids, each one a
+*  layerprops index, so layers 1..num_layers act as the property
+*  table. Materials are index matched to layer 1; only the top and
+*  bottom tissue surfaces refract. HitVoxel walks the cells a step
+*  passes through with a 3-D DDA (Amanatides & Woo) and stops the
+*  step only where the material changes, converting what is left of
+*  it to optical depth as HitLayer does, so the cost follows the path
+*  length and not the grid size. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "mc_voxel.h"
+
+#define VOX_EPS 1e-9	/* cm, nudge along u that decides the cell of a point on a face */
+#define VOX_INF 1e300
+
+/*****************************************************************/
+/* cell of coordinate p along one axis, -1 or n when outside */
+static int CellIndex(double p, double org, double inv_d, int n)
+{
+	double f=(p-org)*inv_d;
+
+	if (f<0.0)
+		return -1;
+	if (f>=n)
+		return n;
+	return (int)f;
+}
+
+/*****************************************************************/
+/* material of cell idx, lateral indices clamped to the grid */
+static short MatAt(const struct VoxelGrid *g, const int *idx)
+{
+	int ix=idx[0],iy=idx[1],iz=idx[2];
+
+	if (ix<0) ix=0;
+	if (ix>=g->nx) ix=g->nx-1;
+	if (iy<0) iy=0;
+	if (iy>=g->ny) iy=g->ny-1;
+	if (iz<0) iz=0;
+	if (iz>=g->nz) iz=g->nz-1;
+	return g->mat[((size_t)iz*g->ny+iy)*g->nx+ix];
+}
+
+/*****************************************************************/
+/* copy and check the grid and switch the tissue to voxel mode */
+void SetVoxelGrid(struct SimContext *ctx, int nx, int ny, int nz,
+	double x0, double y0, double dx, double dy, double dz, unsigned char *mat)
+{
+	struct VoxelGrid *g;
+	size_t num,i;
+	int used[256],k;
+	double n1=ctx->tissptr->layerprops[1].n;
+
+	if (ctx->voxptr!=NULL)
+		FreeVoxelGrid(ctx->voxptr);
+	ctx->voxptr=NULL;
+
+	if ((nx<=0)||(ny<=0)||(nz<=0)||!(dx>0.0)||!(dy>0.0)||!(dz>0.0)) {
+		printf("\nERROR - voxel grid %dx%dx%d with voxels %gx%gx%g cm\n",nx,ny,nz,dx,dy,dz);
+		exit(0);
+	}
+	num=(size_t)nx*ny;
+	if (num/ny!=(size_t)nx || (num*nz)/nz!=num) {
+		printf("\nERROR - voxel grid %dx%dx%d is too large\n",nx,ny,nz);
+		exit(0);
+	}
+	num*=nz;
+
+	memset(used,0,sizeof(used));
+	for (i=0;i<num;++i)
+		used[mat[i]]=1;
+	for (k=0;k<256;++k) {
+		if (!used[k])
+			continue;
+		if ((k<1)||(k>ctx->tissptr->num_layers)) {
+			printf("\nERROR - voxel material %d, materials are layers 1..%d\n",
+				k,ctx->tissptr->num_layers);
+			exit(0);
+		}
+		if (ctx->tissptr->layerprops[k].n!=n1) {
+			printf("\nERROR - voxel material %d has n=%f, materials must be index matched to layer 1 (n=%f)\n",
+				k,ctx->tissptr->layerprops[k].n,n1);
+			exit(0);
+		}
+	}
+
+	g=(struct VoxelGrid *)calloc(1,sizeof(struct VoxelGrid));
+	if (g==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	g->mat=(unsigned char *)malloc(num);
+	if (g->mat==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	memcpy(g->mat,mat,num);
+	g->nx=nx; g->ny=ny; g->nz=nz;
+	g->x0=x0; g->y0=y0;
+	g->dx=dx; g->dy=dy; g->dz=dz;
+	g->inv_d[0]=1.0/dx; g->inv_d[1]=1.0/dy; g->inv_d[2]=1.0/dz;
+	g->zmax=nz*dz;
+	ctx->voxptr=g;
+	ctx->tissptr->do_ellip_layer=5;
+}
+
+/*****************************************************************/
+/* binary file, native byte order:                                */
+/*   char[4] "VTSV", int nx, ny, nz, double x0, y0, dx, dy, dz,   */
+/*   then nx*ny*nz unsigned char material ids, x fastest, then y, */
+/*   then z from the top surface down                             */
+__declspec(dllexport) int ReadVoxelGrid(struct SimContext *ctx, char *fname)
+{
+	FILE *file_ptr;
+	char magic[4];
+	int dims[3];
+	double geom[5];
+	unsigned char *mat;
+	size_t num;
+
+	file_ptr=fopen(fname,"rb");
+	if (file_ptr==NULL) {
+		printf("\nERROR - Could not find or open voxel file %s\n",fname);
+		exit(0);
+	}
+	if ((fread(magic,1,4,file_ptr)!=4)||(memcmp(magic,"VTSV",4)!=0)||
+		(fread(dims,sizeof(int),3,file_ptr)!=3)||
+		(fread(geom,sizeof(double),5,file_ptr)!=5)) {
+		printf("\nERROR - voxel file %s: bad header\n",fname);
+		exit(0);
+	}
+	if ((dims[0]<=0)||(dims[1]<=0)||(dims[2]<=0)) {
+		printf("\nERROR - voxel file %s: grid %dx%dx%d\n",fname,dims[0],dims[1],dims[2]);
+		exit(0);
+	}
+	num=(size_t)dims[0]*dims[1]*dims[2];
+	mat=(unsigned char *)malloc(num);
+	if (mat==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	if (fread(mat,1,num,file_ptr)!=num) {
+		printf("\nERROR - voxel file %s: expected %lu material ids\n",fname,(unsigned long)num);
+		exit(0);
+	}
+	fclose(file_ptr);
+	SetVoxelGrid(ctx,dims[0],dims[1],dims[2],geom[0],geom[1],geom[2],geom[3],geom[4],mat);
+	free(mat);
+	printf("voxel grid: %dx%dx%d, %g cm thick\n",dims[0],dims[1],dims[2],ctx->voxptr->zmax);
+	return dims[0]*dims[1]*dims[2];
+}
+
+/*****************************************************************/
+void FreeVoxelGrid(struct VoxelGrid *g)
+{
+	free(g->mat);
+	free(g);
+}
+
+/*****************************************************************/
+short VoxelMaterialAt(struct SimContext *ctx, double x, double y, double z)
+{
+	struct VoxelGrid *g=ctx->voxptr;
+	int idx[3];
+
+	idx[0]=CellIndex(x,g->x0,g->inv_d[0],g->nx);
+	idx[1]=CellIndex(y,g->y0,g->inv_d[1],g->ny);
+	idx[2]=CellIndex(z,0.0,g->inv_d[2],g->nz);
+	return MatAt(g,idx);
+}
+
+/*****************************************************************/
+/* material of the cell the photon is in, a point on a face     */
+/* belonging to the cell it is heading into                      */
+short VoxelMaterial(struct SimContext *ctx)
+{
+	return VoxelMaterialAt(ctx,ctx->photptr->x+VOX_EPS*ctx->photptr->ux,
+		ctx->photptr->y+VOX_EPS*ctx->photptr->uy,
+		ctx->photptr->z+VOX_EPS*ctx->photptr->uz);
+}
+
+/*****************************************************************/
+/* HitBoundary for do_ellip_layer==5: returns 1 at a tissue surface, */
+/* 2 where the material changes, 0 otherwise                         */
+short HitVoxel(struct SimContext *ctx)
+{
+	struct VoxelGrid *g=ctx->voxptr;
+	double p[3],u[3],org[3],d[3],tmax[3],tdelta[3],dbound,t=0.0;
+	double s=ctx->photptr->s;
+	short mat=ctx->photptr->curr_layer;
+	double mut=ctx->layers.mut[mat];
+	int n[3],idx[3],step[3],a;
+	short hit=0;
+
+	p[0]=ctx->photptr->x; p[1]=ctx->photptr->y; p[2]=ctx->photptr->z;
+	u[0]=ctx->photptr->ux; u[1]=ctx->photptr->uy; u[2]=ctx->photptr->uz;
+	org[0]=g->x0; org[1]=g->y0; org[2]=0.0;
+	d[0]=g->dx; d[1]=g->dy; d[2]=g->dz;
+	n[0]=g->nx; n[1]=g->ny; n[2]=g->nz;
+	dbound=s;
+
+	/* tissue surfaces */
+	if (u[2]<0.0)
+		t=-p[2]/u[2];
+	else if (u[2]>0.0)
+		t=(g->zmax-p[2])/u[2];
+	if ((u[2]!=0.0)&&(t<dbound)) {
+		dbound=t;
+		hit=1;
+	}
+
+	/* distance to the first face on each axis and between faces;  */
+	/* beyond the lateral edges there are no faces to cross        */
+	for (a=0;a<3;++a) {
+		idx[a]=CellIndex(p[a]+VOX_EPS*u[a],org[a],g->inv_d[a],n[a]);
+		if (u[a]>0.0) {
+			step[a]=1;
+			tdelta[a]=d[a]/u[a];
+			tmax[a]=(idx[a]<n[a])?(org[a]+(idx[a]+1)*d[a]-p[a])/u[a]:VOX_INF;
+		}
+		else if (u[a]<0.0) {
+			step[a]=-1;
+			tdelta[a]=-d[a]/u[a];
+			tmax[a]=(idx[a]>=0)?(org[a]+idx[a]*d[a]-p[a])/u[a]:VOX_INF;
+		}
+		else {
+			step[a]=0;
+			tdelta[a]=tmax[a]=VOX_INF;
+		}
+	}
+
+	/* cross faces in order until the step ends or the material changes */
+	for (;;) {
+		a=(tmax[0]<tmax[1])?0:1;
+		if (tmax[2]<tmax[a])
+			a=2;
+		t=tmax[a];
+		if (t>=dbound)
+			break;
+		idx[a]+=step[a];
+		if ((idx[a]<0)||(idx[a]>=n[a])) {
+			if (a==2)
+				break;	/* tissue surface, already in dbound */
+			tmax[a]=VOX_INF;	/* left the grid sideways: edge cells repeat */
+			continue;
+		}
+		tmax[a]+=tdelta[a];
+		if (MatAt(g,idx)!=mat) {
+			dbound=(t>0.0)?t:0.0;
+			hit=2;
+			break;
+		}
+	}
+
+	if (hit) {
+		ctx->photptr->hit_bdry=1;
+		ctx->photptr->sleft=(mut>0.0)?(s-dbound)*mut:0.0;
+		ctx->photptr->s=dbound;
+	}
+	return hit;
+}
+
+/*****************************************************************/
+/* index matched: no Fresnel, the photon changes material only */
+void CrossVoxel(struct SimContext *ctx)
+{
+	ctx->photptr->curr_layer=VoxelMaterial(ctx);
+}
@@ -0,0 +1,30 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+/* voxelized tissue: a grid of material ids (layerprops indices) */
+/* filling the slab 0<=z<=nz*dz; read only while tracing, shared */
+/* by the worker contexts                                        */
+struct VoxelGrid{
+  int nx, ny, nz;
+  double x0, y0;	/* lateral corner; columns outside the grid repeat the edge voxels */
+  double dx, dy, dz;
+  double inv_d[3];	/* 1/dx, 1/dy, 1/dz */
+  double zmax;	/* nz*dz, bottom tissue surface */
+  unsigned char *mat;	/* [(iz*ny+iy)*nx+ix] */
+};
+
+__declspec(dllexport) int ReadVoxelGrid(struct SimContext *, char *);
+void SetVoxelGrid(struct SimContext *, int, int, int, double, double,
+	double, double, double, unsigned char *);
+void FreeVoxelGrid(struct VoxelGrid *);
+short VoxelMaterial(struct SimContext *);
+short VoxelMaterialAt(struct SimContext *, double, double, double);
+short HitVoxel(struct SimContext *);
+void CrossVoxel(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
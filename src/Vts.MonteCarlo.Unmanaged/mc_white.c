@@ -0,0 +1,404 @@
+/* Absorption rescaling ("white Monte Carlo").
+*
+*  For a fixed mus/g/geometry the random walk does not depend on mua:
+*  a photon that travelled L_i in layer i carries the extra weight
+*  exp(-sum_i mua_i*L_i). With a mua table set, RunMCLoop traces the
+*  photons once with mua=0 and every track updates that factor for
+*  all num_sets mua vectors at once (WhiteTrack), depositing the
+*  weight lost along the track in the layer absorption of each set.
+*  Reflected and transmitted weight is scored per set the same way.
+*  The per-set exp() is a branch-free polynomial so that the loop over
+*  the sets vectorizes. Results go to <output>_white.txt. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "mc_main.h"
+#include "pert.h"
+#include "mc_white.h"
+#include "mc_moment.h"
+
+#define LOG2E 1.44269504088896340736
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+#define ROUND_MAGIC 6755399441055744.0	/* 1.5*2^52, t+ROUND_MAGIC rounds t */
+#define EXP_MIN -700.0	/* exp(-700)=1e-304, keeps 2^k normal */
+
+#if defined(_MSC_VER) && (_MSC_VER<1900)
+#define snprintf _snprintf	/* no C99 snprintf before VS2015 */
+#endif
+
+/* Taylor coefficients of exp(r) for |r|<=ln2/2, highest order first */
+static const double exp_coef[14]={
+	1.0/6227020800.0,1.0/479001600.0,1.0/39916800.0,1.0/3628800.0,
+	1.0/362880.0,1.0/40320.0,1.0/5040.0,1.0/720.0,1.0/120.0,1.0/24.0,
+	1.0/6.0,1.0/2.0,1.0,1.0
+};
+
+/*****************************************************************/
+/* y=exp(x) for x<=0: x=k*ln2+r, 2^k is built in the exponent bits */
+static void WhiteExp(double *y, const double *x, int n)
+{
+	union {double d; PHILOX_U64 u;} big,scale;
+	double t,kf,r,p;
+	int i,j;
+
+	for (i=0;i<n;++i) {
+		t=(x[i]<EXP_MIN)?EXP_MIN:x[i];
+		big.d=t*LOG2E+ROUND_MAGIC;	/* low mantissa bits hold k */
+		kf=big.d-ROUND_MAGIC;
+		r=(t-kf*LN2_HI)-kf*LN2_LO;
+		p=exp_coef[0];
+		for (j=1;j<14;++j)
+			p=p*r+exp_coef[j];
+		scale.u=(big.u-0x4338000000000000ULL+1023)<<52;
+		y[i]=p*scale.d;
+	}
+}
+
+/*****************************************************************/
+/* the tallies are one zeroed block, so that ReduceWhiteMC() and */
+/* the second moments see them as a single run of doubles        */
+static struct WhiteMC *AllocWhiteMC(struct SimContext *ctx, int num_sets)
+{
+	struct WhiteMC *wh;
+	short nr=ctx->detector->nr;
+	short nt=ctx->detector->nt;
+	int num_layers=ctx->tissptr->num_layers;
+	double *p;
+	int i,k;
+
+	wh=(struct WhiteMC *)calloc(1,sizeof(struct WhiteMC));
+	if (wh==NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	wh->num_sets=num_sets;
+	wh->num_layers=num_layers;
+	wh->mua=(double *)calloc((num_layers+2)*num_sets,sizeof(double));
+	wh->mua0=(double *)calloc(num_layers+2,sizeof(double));
+	wh->albedo0=(double *)calloc(num_layers+2,sizeof(double));
+	wh->atten=(double *)calloc(num_sets,sizeof(double));
+	wh->arg=(double *)calloc(num_sets,sizeof(double));
+	wh->f=(double *)calloc(num_sets,sizeof(double));
+	wh->num_tally=(size_t)num_sets*(2+nr+(size_t)nr*nt+num_layers+2);
+	wh->tally=(double *)calloc(wh->num_tally,sizeof(double));
+	wh->R_r=(double **)malloc(num_sets*sizeof(double *));
+	wh->R_rt=(double ***)malloc(num_sets*sizeof(double **));
+	wh->rt_rows=(double **)malloc((size_t)num_sets*nr*sizeof(double *));
+	wh->A_layer=(double **)malloc((num_layers+2)*sizeof(double *));
+	if ((wh->mua==NULL)||(wh->mua0==NULL)||(wh->albedo0==NULL)||
+		(wh->atten==NULL)||(wh->arg==NULL)||(wh->f==NULL)||(wh->tally==NULL)||
+		(wh->R_r==NULL)||(wh->R_rt==NULL)||(wh->rt_rows==NULL)||(wh->A_layer==NULL)) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	p=wh->tally;
+	wh->Rd=p;
+	p+=num_sets;
+	wh->Td=p;
+	p+=num_sets;
+	for (k=0;k<num_sets;++k) {
+		wh->R_r[k]=p;
+		p+=nr;
+	}
+	for (k=0;k<num_sets;++k) {
+		wh->R_rt[k]=wh->rt_rows+(size_t)k*nr;
+		for (i=0;i<nr;++i) {
+			wh->R_rt[k][i]=p;
+			p+=nt;
+		}
+	}
+	for (i=0;i<num_layers+2;++i) {
+		wh->A_layer[i]=p;
+		p+=num_sets;
+	}
+	return wh;
+}
+
+/*****************************************************************/
+/* mua is num_sets rows of num_layers values (layer 1 first) */
+__declspec(dllexport) void SetWhiteMuaSets(struct SimContext *ctx, int num_sets, double *mua)
+{
+	struct WhiteMC *wh;
+	int i,k,num_layers=ctx->tissptr->num_layers;
+
+	if (ctx->whiteptr!=NULL)
+		FreeWhiteMC(ctx,ctx->whiteptr);
+	ctx->whiteptr=NULL;
+	if (num_sets<=0)
+		return;
+	wh=AllocWhiteMC(ctx,num_sets);
+	for (k=0;k<num_sets;++k)
+		for (i=1;i<num_layers+1;++i)
+			wh->mua[i*num_sets+k]=mua[k*num_layers+i-1];
+	ctx->whiteptr=wh;
+}
+
+/*****************************************************************/
+/* text table, one mua vector (num_layers values) per line */
+__declspec(dllexport) int ReadWhiteMuaSets(struct SimContext *ctx, char *fname)
+{
+	FILE *file_ptr;
+	double *mua=NULL,val;
+	int n=0,cap=0,num_layers=ctx->tissptr->num_layers;
+
+	file_ptr=fopen(fname,"r");
+	if (file_ptr==NULL) {
+		printf("\nERROR - Could not find or open mua table %s\n",fname);
+		exit(0);
+	}
+	while (fscanf(file_ptr,"%lf",&val)==1) {
+		if (n==cap) {
+			cap=(cap==0)?64*num_layers:2*cap;
+			mua=(double *)realloc(mua,cap*sizeof(double));
+			if (mua==NULL) {
+				printf("Memory allocation error\n");
+				exit(1);
+			}
+		}
+		mua[n++]=val;
+	}
+	fclose(file_ptr);
+	if ((n==0)||(n%num_layers!=0)) {
+		printf("\nERROR - mua table %s needs %d values per line\n",fname,num_layers);
+		exit(0);
+	}
+	SetWhiteMuaSets(ctx,n/num_layers,mua);
+	free(mua);
+	printf("white MC: %d mua vectors\n",n/num_layers);
+	return n/num_layers;
+}
+
+/*****************************************************************/
+/* same mua table, zero tallies: for a worker context */
+struct WhiteMC *CloneWhiteMC(struct SimContext *ctx)
+{
+	struct WhiteMC *src=ctx->whiteptr,*wh;
+	int i;
+
+	wh=AllocWhiteMC(ctx,src->num_sets);
+	for (i=0;i<(src->num_layers+2)*src->num_sets;++i)
+		wh->mua[i]=src->mua[i];
+	return wh;
+}
+
+/*****************************************************************/
+void FreeWhiteMC(struct SimContext *ctx, struct WhiteMC *wh)
+{
+	free(wh->A_layer);
+	free(wh->rt_rows);
+	free(wh->R_rt);
+	free(wh->R_r);
+	free(wh->tally);
+	free(wh->f);
+	free(wh->arg);
+	free(wh->atten);
+	free(wh->albedo0);
+	free(wh->mua0);
+	free(wh->mua);
+	free(wh);
+}
+
+/*****************************************************************/
+/* the walk itself is done without absorption */
+void BeginWhiteWalk(struct SimContext *ctx)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	struct Layer *lp=ctx->tissptr->layerprops;
+	int i;
+
+	for (i=1;i<wh->num_layers+1;++i) {
+		wh->mua0[i]=lp[i].mua;
+		wh->albedo0[i]=lp[i].albedo;
+		lp[i].mua=0.0;
+		lp[i].albedo=1.0;
+	}
+}
+
+/*****************************************************************/
+void EndWhiteWalk(struct SimContext *ctx)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	struct Layer *lp=ctx->tissptr->layerprops;
+	int i;
+
+	for (i=1;i<wh->num_layers+1;++i) {
+		lp[i].mua=wh->mua0[i];
+		lp[i].albedo=wh->albedo0[i];
+	}
+}
+
+/*****************************************************************/
+void WhiteStartPhoton(struct SimContext *ctx)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	int k;
+
+	for (k=0;k<wh->num_sets;++k)
+		wh->atten[k]=1.0;
+	wh->max_atten=1.0;
+}
+
+/*****************************************************************/
+/* a track of length s in the current layer */
+void WhiteTrack(struct SimContext *ctx, double s)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	short layer=ctx->photptr->curr_layer;
+	double w=ctx->photptr->w;
+	double *mua=wh->mua+layer*wh->num_sets;
+	double *a_layer=wh->A_layer[layer];
+	double max_atten=0.0;
+	int k,n=wh->num_sets;
+
+	if (s<=0.0)
+		return;
+	for (k=0;k<n;++k)
+		wh->arg[k]=-mua[k]*s;
+	WhiteExp(wh->f,wh->arg,n);
+	/* apart from the loop below, which vectorizes */
+	if (ctx->moments.on)
+		for (k=0;k<n;++k)
+			MomentAdd(ctx,&a_layer[k],w*wh->atten[k]*(1.0-wh->f[k]));
+	for (k=0;k<n;++k) {
+		a_layer[k]+=w*wh->atten[k]*(1.0-wh->f[k]);
+		wh->atten[k]*=wh->f[k];
+		max_atten=(wh->atten[k]>max_atten)?wh->atten[k]:max_atten;
+	}
+	wh->max_atten=max_atten;
+}
+
+/*****************************************************************/
+/* amt leaves the top surface in radial bin ir, time bin it (-1: none) */
+void WhiteReflect(struct SimContext *ctx, double amt, short ir, short it)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	double v;
+	int k;
+
+	for (k=0;k<wh->num_sets;++k) {
+		v=amt*wh->atten[k];
+		wh->Rd[k]+=v;
+		wh->R_r[k][ir]+=v;
+		MOMENT_ADD(ctx,&wh->Rd[k],v);
+		MOMENT_ADD(ctx,&wh->R_r[k][ir],v);
+		if (it>=0) {
+			wh->R_rt[k][ir][it]+=v;
+			MOMENT_ADD(ctx,&wh->R_rt[k][ir][it],v);
+		}
+	}
+}
+
+/*****************************************************************/
+void WhiteTransmit(struct SimContext *ctx, double amt)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	int k;
+
+	for (k=0;k<wh->num_sets;++k) {
+		wh->Td[k]+=amt*wh->atten[k];
+		MOMENT_ADD(ctx,&wh->Td[k],amt*wh->atten[k]);
+	}
+}
+
+/*****************************************************************/
+/* add the worker's tallies into dst and zero them */
+void ReduceWhiteMC(struct SimContext *ctx, struct WhiteMC *dst, struct WhiteMC *src)
+{
+	size_t i;
+
+	for (i=0;i<dst->num_tally;++i) {
+		dst->tally[i]+=src->tally[i];
+		src->tally[i]=0.0;
+	}
+}
+
+/*****************************************************************/
+/* tab and relative error of tally double p, with moments on */
+static void SaveWhiteRelErr(struct SimContext *ctx, FILE *file, const double *p)
+{
+	if (ctx->moments.on)
+		fprintf(file,"\t%.4e",RelErr(ctx,p));
+}
+
+/*****************************************************************/
+/* normalize as NormalizeResults() does and write <output>_white.txt; */
+/* the relative errors are those MomentsToRelErr() left in place     */
+void SaveWhiteResults(struct SimContext *ctx)
+{
+	struct WhiteMC *wh=ctx->whiteptr;
+	short nr=ctx->detector->nr;
+	short nt=ctx->detector->nt;
+	double dr=ctx->detector->dr;
+	double dt=ctx->detector->dt;
+	long num_phot=ctx->source->num_photons;
+	char tmp_name[256];
+	FILE *file;
+	double C1;
+	int i,ir,it,k;
+
+	for (k=0;k<wh->num_sets;++k) {
+		wh->Rd[k]/=num_phot;
+		wh->Td[k]/=num_phot;
+		for (i=1;i<wh->num_layers+1;++i)
+			wh->A_layer[i][k]/=num_phot;
+		for (ir=0;ir<nr;++ir) {
+			C1=2.0*PI*(ir+0.5)*dr*dr*num_phot;
+			wh->R_r[k][ir]/=C1;
+			for (it=0;it<nt;++it)
+				wh->R_rt[k][ir][it]/=C1;
+		}
+	}
+
+	i=snprintf(tmp_name,sizeof(tmp_name),"%s_white.txt",ctx->pertptr->output_filename);
+	if ((i<0)||(i>=(int)sizeof(tmp_name))) {
+		printf("\nERROR - output name %s is too long\n",ctx->pertptr->output_filename);
+		exit(0);
+	}
+	file=fopen(tmp_name,"w");
+	fprintf(file,"Absorption rescaling of one mua=0 walk\n");
+	fprintf(file,"Input number of photons=%ld\n",num_phot);
+	fprintf(file,"Number of mua vectors: %d\n\n",wh->num_sets);
+	for (k=0;k<wh->num_sets;++k) {
+		fprintf(file,"Set %d mua:",k);
+		for (i=1;i<wh->num_layers+1;++i)
+			fprintf(file,"\t%G",wh->mua[i*wh->num_sets+k]);
+		fprintf(file,"\n");
+		fprintf(file,"Diffuse reflection    = %12.4E\n",wh->Rd[k]);
+		if (ctx->moments.on)
+			fprintf(file,"Rel. error Rd         = %12.4E\n",RelErr(ctx,&wh->Rd[k]));
+		fprintf(file,"Total reflection      = %12.4E\n",wh->Rd[k]+ctx->photptr->Rspec);
+		fprintf(file,"Diffuse transmission  = %12.4E\n",wh->Td[k]);
+		if (ctx->moments.on)
+			fprintf(file,"Rel. error Td         = %12.4E\n",RelErr(ctx,&wh->Td[k]));
+		fprintf(file,"Absorption vs layer\n");
+		for (i=1;i<wh->num_layers+1;++i) {
+			fprintf(file,"Layer %d: \t%f",i,wh->A_layer[i][k]);
+			SaveWhiteRelErr(ctx,file,&wh->A_layer[i][k]);
+			fprintf(file,"\n");
+		}
+		fprintf(file,ctx->moments.on ? "r(cm)\tR(r)[W/cm2]\trel. error R\n" : "r(cm)\tR(r)[W/cm2]\n");
+		for (ir=0;ir<nr;++ir) {
+			fprintf(file,"%.4e\t%.4e",(ir+0.5)*dr,wh->R_r[k][ir]);
+			SaveWhiteRelErr(ctx,file,&wh->R_r[k][ir]);
+			fprintf(file,"\n");
+		}
+		for (i=0;i<(ctx->moments.on ? 2 : 1);++i) {
+			fprintf(file,(i==0) ? "Reflection vs r and time [W/cm2/ps]\n" :
+				"Relative error of reflection vs r and time\n");
+			fprintf(file,"           \t");
+			for (it=0;it<nt;++it)
+				fprintf(file,"%.4e\t",(it+0.5)*dt);
+			fprintf(file,"\n");
+			for (ir=0;ir<nr;++ir) {
+				fprintf(file,"%.4e\t",(ir+0.5)*dr);
+				for (it=0;it<nt;++it)
+					fprintf(file,"%.4e\t",(i==0) ? wh->R_rt[k][ir][it] : RelErr(ctx,&wh->R_rt[k][ir][it]));
+				fprintf(file,"\n");
+			}
+		}
+		fprintf(file,"\n");
+	}
+	fclose(file);
+}
@@ -0,0 +1,44 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+
+/* absorption rescaling ("white Monte Carlo"): the random walk runs */
+/* once with mua=0 and every track is reweighted for num_sets mua   */
+/* vectors at the same time                                         */
+struct WhiteMC{
+  int num_sets;      /* mua vectors scored */
+  int num_layers;
+  double *mua;       /* [layer*num_sets+k], layers 0..num_layers+1 */
+  double *mua0;      /* input mua and albedo of each layer, restored */
+  double *albedo0;   /* after the walk */
+  double *atten;     /* [k] exp(-sum mua*L) of the photon being traced */
+  double max_atten;  /* largest atten[k], what roulette tests */
+  double *arg,*f;    /* [k] scratch for one track */
+  /* tallies, per mua vector, views of one block */
+  double *tally;     /* Rd, Td, R_r, R_rt, A_layer back to back */
+  size_t num_tally;  /* doubles in it */
+  double *Rd, *Td;   /* [k] */
+  double **R_r;      /* [k][ir] */
+  double ***R_rt;    /* [k][ir][it] */
+  double **A_layer;  /* [layer][k] */
+  double **rt_rows;  /* rows behind R_rt */
+};
+
+__declspec(dllexport) void SetWhiteMuaSets(struct SimContext *, int, double *);
+__declspec(dllexport) int ReadWhiteMuaSets(struct SimContext *, char *);
+struct WhiteMC *CloneWhiteMC(struct SimContext *);
+void FreeWhiteMC(struct SimContext *, struct WhiteMC *);
+void BeginWhiteWalk(struct SimContext *);
+void EndWhiteWalk(struct SimContext *);
+void WhiteStartPhoton(struct SimContext *);
+void WhiteTrack(struct SimContext *, double);
+void WhiteReflect(struct SimContext *, double, short, short);
+void WhiteTransmit(struct SimContext *, double);
+void ReduceWhiteMC(struct SimContext *, struct WhiteMC *, struct WhiteMC *);
+void SaveWhiteResults(struct SimContext *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -1,51 +1,58 @@
-#define MAX_DET 10
-void pert(void);
-void init_pert(void);
-
-struct perturb
-{
-  /* USER SPECIFIED DATA */
-  //int do_ellip_layer;  /* 0=nopert 1=pert:ellip 2=pert:layer 3=nopert:ellip */ 
-  ///* ellipsoid data */
-  ///* center position */
-  //double ellip_x, ellip_y, ellip_z;
-  ///* radius dimensions */
-  //double ellip_rad_x, ellip_rad_y, ellip_rad_z;
-  ///* layer info */
-  //double layer_z_min, layer_z_max;
-  
-  ///* detector data */
-  //int reflect_flag;  /* 1=reflect 0=transmit */
-  ///* number of x-axis bins */
-  //int nr;
-  //double det_ctr[MAX_DET];
-  //double det_rad;
-  //double det_NA;
-  
-  /* russian roulette data */
-  double wt_cut;
-  double prr;
-  /* END USER */
-  int tot_phot;
-  int col_in_layer[14];
-  double pathlen_in_layer[14];
-  int tot_out_top;
-  int tot_out_bot;
-  char output_filename[256]; 
-  int col_hit_bdry;
-
-};
-
-/* prototypes */
-int In_Detector(double, double, double, double, double);
-int InEllipsoid(double, double, double);
-void Ray_Intersect_Ellip(double, double, double,
-                         double, double, double,
-                         double *, double *);
-void Ray_Intersect_Layer(double, double, double,
-                         double, double, double,
-                         double *, double *);
-//void Pert_Col(double, double, double);
-//void Pert_Path_Len(double, double, double,
-//                     double, double, double,int);
-
+#define PRR_DEFAULT 0.1 /* roulette survival chance if the input gives none */
+struct SimContext;
+
+void pert(void);
+void init_pert(struct SimContext *);
+
+struct perturb
+{
+  /* USER SPECIFIED DATA */
+  //int do_ellip_layer;  /* 0=nopert 1=pert:ellip 2=pert:layer 3=nopert:ellip */ 
+  ///* ellipsoid data */
+  ///* center position */
+  //double ellip_x, ellip_y, ellip_z;
+  ///* radius dimensions */
+  //double ellip_rad_x, ellip_rad_y, ellip_rad_z;
+  ///* layer info */
+  //double layer_z_min, layer_z_max;
+  
+  ///* detector data */
+  //int reflect_flag;  /* 1=reflect 0=transmit */
+  ///* number of x-axis bins */
+  //int nr;
+  //double det_ctr[MAX_DET];
+  //double det_rad;
+  //double det_NA;
+  
+  /* russian roulette data, off when wt_cut=0 */
+  double wt_cut;
+  double prr;
+  double *layer_wt_cut;  /* [0..num_layers+1] per layer, default wt_cut */
+  double *layer_prr;     /* [0..num_layers+1] per layer, default prr */
+  /* END USER */
+  int tot_phot;
+  int tot_rouletted;  /* photons killed by roulette */
+  int *col_in_layer;  /* [0..num_layers+1], see AllocPertLayers() */
+  double *pathlen_in_layer;
+  int tot_out_top;
+  int tot_out_bot;
+  char output_filename[256]; 
+  int col_hit_bdry;
+
+};
+
+/* prototypes */
+int In_Detector(struct SimContext *, double, double, double);
+int InEllipsoid(struct SimContext *, double, double, double);
+void AllocPertLayers(struct perturb *, int);
+void FreePertLayers(struct perturb *);
+void Ray_Intersect_Ellip(struct SimContext *, double, double, double,
+                         double, double, double,
+                         double *, double *);
+void Ray_Intersect_Layer(struct SimContext *, double, double, double,
+                         double, double, double,
+                         double *, double *);
+//void Pert_Col(double, double, double);
+//void Pert_Path_Len(double, double, double,
+//                     double, double, double,int);
+
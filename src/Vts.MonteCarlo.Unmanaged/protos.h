@@ -1,50 +1,58 @@
-#ifdef __cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
-/*****************************************************************
- *  function prototypes
- *****/
-void ReadInput(FILE *);
-void initialize(void);
-void DisplayIntro(void);
-void DisplayStatus(long, long);
-void Scatter(void);
-void init_photon(void);
-void SetStepSize(void);
-short HitBoundary(void);
-void CrossLayer(void);
-void Move_Photon(void);
-void Absorb(void);
-void Scatter_Or_Absorb(void);
-void TestWeight(void);
-void FreeMemory(void);
-void Test_Distance(void);
-void Write_Or_Pert();
-
-/* mc_2_photon_io.c */
-void Compute_EV(void);
-void Write_3_Bytes(double, FILE *);
-short Intersect_Cylinder(double, double, double, double,
-			 double, double);
-short Heading_Towards_Cylinder(double, double, double, double, double);
-short Soln_Exists(double, double, double, double, double *,double *);
-
-void Write_Photon_To_Disk(int);
-void Display_Photon_Data(void);
-
-/* save_text.c */
-void SaveTextResult(void);
-void NormalizeResults(void);
-
-  /* mc_utils.c */
-  double ran3(int *idum);
-  __declspec(dllexport) double RandomNum(void);
-  double ***d3tensor(long,long,long,long,long,long);
-  void free_d3tensor(double ***,long,long,long,long,long,long);
-  double ****d4tensor(long,long,long,long,long,long,long,long);
-  void free_d4tensor(double ****,long,long,long,long,long,long,long,long);
-
-#ifdef __cplusplus
-}
-#endif /* __cplusplus */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct SimContext;
+struct Ran3State;
+struct PhiloxState;
+
+/*****************************************************************
+ *  function prototypes
+ *****/
+void ReadInput(struct SimContext *, FILE *);
+void initialize(struct SimContext *, char *);
+void DisplayIntro(void);
+void DisplayStatus(long, long);
+void Scatter(struct SimContext *);
+void init_photon(struct SimContext *);
+void SetStepSize(struct SimContext *);
+short HitBoundary(struct SimContext *);
+void CrossLayer(struct SimContext *);
+void Move_Photon(struct SimContext *);
+void Absorb(struct SimContext *);
+void Scatter_Or_Absorb(struct SimContext *);
+void TestWeight(struct SimContext *);
+void FreeMemory(struct SimContext *);
+void Test_Distance(struct SimContext *);
+void Write_Or_Pert();
+
+/* mc_2_photon_io.c */
+void Compute_EV(void);
+void Write_3_Bytes(double, FILE *);
+short Intersect_Cylinder(double, double, double, double,
+			 double, double);
+short Heading_Towards_Cylinder(double, double, double, double, double);
+short Soln_Exists(double, double, double, double, double *,double *);
+
+void Write_Photon_To_Disk(struct SimContext *, int);
+void Display_Photon_Data(void);
+
+/* save_text.c */
+void SaveTextResult(struct SimContext *);
+void NormalizeResults(struct SimContext *);
+
+  /* mc_utils.c */
+  double ran3(struct Ran3State *);
+  __declspec(dllexport) double RandomNum(struct SimContext *);
+  void Philox4x32(const unsigned int [2], const unsigned int [4], unsigned int [4]);
+  void SeedPhotonStream(struct SimContext *, int);
+  double PhiloxNum(struct PhiloxState *);
+  __declspec(dllexport) void RandomFill(struct SimContext *, double *, int);
+  double ***d3tensor(long,long,long,long,long,long);
+  void free_d3tensor(double ***,long,long,long,long,long,long);
+  double ****d4tensor(long,long,long,long,long,long,long,long);
+  void free_d4tensor(double ****,long,long,long,long,long,long,long,long);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
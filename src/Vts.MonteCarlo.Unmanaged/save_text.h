@@ -1,12 +1,12 @@
-#ifdef __cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
-/* save_text.c */
-//void SaveTextResult(void);/*
-//void SaveTextResult2(void);*/
-//void Save_Banana(void);
-
-#ifdef __cplusplus
-}
-#endif /* __cplusplus */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* save_text.c */
+//void SaveTextResult(void);/*
+//void SaveTextResult2(void);*/
+//void Save_Banana(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -7,5 +7,11 @@ namespace Vts.MonteCarlo
     {
         public int Seed;
         public int AbsWeightingType;
+        public int NumThreads;
+        public int RngType;
+        public int TransportEngine;
+        public int Allvox;
+        public int Tracking;
+        public int TallySecondMoment;
     }
 }
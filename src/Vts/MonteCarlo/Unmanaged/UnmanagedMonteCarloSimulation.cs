@@ -16,7 +16,7 @@ namespace Vts.MonteCarlo
         public static extern void RunUnmanagedMC(ref UnmanagedPhoton unmanagedPhoton,
             ref UnmanagedTissue unmanagedTissue, ref UnmanagedSourceDefinition unmanagedSourceDefinition,
             ref UnmanagedOutput unmanagedOutput, ref UnmanagedHistory unmanagedHistory,
-            ref UnmanagedFlags unmanagedFlags);
+            ref UnmanagedFlags unmanagedFlags, ref UnmanagedDetectorDefinition unmanagedDetectorDefinition);
 
         //[DllImport(@"Vts.MonteCarlo.Unmanaged.dll", EntryPoint = "RunTest")]
         //public static extern void RunUnmanagedMC(ref UnmanagedPhoton unmanagedPhoton,